@@ -10,11 +10,15 @@
 **  along with this program.  If not, see <http://www.gnu.org/licenses/>.    **
 ******************************************************************************/
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <system_error>
+#include <thread>
 #include "dwgreader.h"
 #include "drw_textcodec.h"
 #include "drw_dbg.h"
@@ -909,237 +913,422 @@ bool dwgReader::readPlineVertex(DRW_Polyline& pline, dwgBuffer *dbuf){
     return ret;
 }
 
+namespace {
+    //handles of the objects in map, the order entities are read in
+    std::vector<duint32> sortedHandles(const std::unordered_map<duint32, objHandle> &map) {
+        std::vector<duint32> handles;
+        handles.reserve(map.size());
+        for (const auto& it : map)
+            handles.push_back(it.first);
+        std::sort(handles.begin(), handles.end());
+        return handles;
+    }
+}
+
 bool dwgReader::readDwgEntities(DRW_Interface& intfa, dwgBuffer *dbuf){
     bool ret = true;
     bool ret2 = true;
 
     DRW_DBG("\nobject map total size= "); DRW_DBG(ObjectMap.size());
-    auto itB=ObjectMap.begin();
-    auto itE=ObjectMap.end();
-    while (itB != itE){
-        ret2 = readDwgEntity(dbuf, itB->second, intfa);
-        ObjectMap.erase(itB);
-        itB=ObjectMap.begin();
+    //debug output is not thread safe, parse in parallel only without it
+    if (threadCount > 1 && DRW_DBGGL == DRW_dbg::Level::None)
+        return readDwgEntitiesParallel(intfa, dbuf);
+
+    for (duint32 handle : sortedHandles(ObjectMap)) {
+        auto mit = ObjectMap.find(handle);
+        if (mit == ObjectMap.end())
+            continue; //vertex already read with its polyline
+        ret2 = readDwgEntity(dbuf, mit->second, intfa);
+        ObjectMap.erase(handle);
         if (ret)
             ret = ret2;
     }
     return ret;
 }
 
+namespace {
+    //object of the entities section, parsed by a worker thread
+    struct dwgEntityItem {
+        objHandle obj;
+        std::vector<duint8> data;
+        duint32 bs {0};
+        bool good {false}; //data read ok
+        bool ok {true}; //entity parsed ok
+        std::unique_ptr<DRW_Entity> entity;
+    };
+}
+
 /**
- * Reads a dwg drawing entity (dwg object entity) given its offset in the file
+ * Reads the dwg drawing entities like the sequential loop of
+ * readDwgEntities, but parses them on threadCount threads.
+ * The objects are handled in batches: their data is copied from dbuf,
+ * the entities are parsed by the workers and then sent to the interface
+ * in handle order by the calling thread.
  */
-bool dwgReader::readDwgEntity(dwgBuffer *dbuf, objHandle& obj, DRW_Interface& intfa){
+bool dwgReader::readDwgEntitiesParallel(DRW_Interface& intfa, dwgBuffer *dbuf){
+    //objects parsed at once, bounds the memory held by parsed entities
+    const size_t batchSize = 8192;
     bool ret = true;
-    duint32 bs = 0;
+    bool ret2 = true;
 
-#define ENTRY_PARSE(e) \
-    ret = e.parseDwg(version, &buff, bs); \
-    parseAttribs(&e); \
-    nextEntLink = e.nextEntLink; \
-    prevEntLink = e.prevEntLink;
+    std::vector<duint32> const handles = sortedHandles(ObjectMap);
 
-    nextEntLink = prevEntLink = 0;// set to 0 to skip unimplemented entities
-        dbuf->setPosition(obj.loc);
-        //verify if position is ok:
-        if (!dbuf->isGood()){
-            DRW_DBG(" Warning: readDwgEntity, bad location\n");
-            return false;
+    std::vector<dwgEntityItem> batch;
+    batch.reserve(std::min(batchSize, handles.size()));
+    for (size_t first = 0; first < handles.size(); first += batchSize) {
+        size_t last = std::min(handles.size(), first + batchSize);
+        batch.clear();
+        for (size_t i = first; i < last; ++i) {
+            auto mit = ObjectMap.find(handles[i]);
+            if (mit == ObjectMap.end())
+                continue; //vertex already read with its polyline
+            batch.emplace_back();
+            dwgEntityItem &item = batch.back();
+            item.obj = mit->second;
+            item.good = readObjectData(dbuf, item.obj, item.data, item.bs);
         }
-        int size = dbuf->getModularShort();
-        if (version > DRW::AC1021) {//2010+
-            bs = dbuf->getUModularChar();
+
+        std::atomic<size_t> next {0};
+        auto worker = [this, &batch, &next]() {
+            for (size_t i = next++; i < batch.size(); i = next++) {
+                dwgEntityItem &item = batch[i];
+                if (!item.good)
+                    continue;
+                //an exception leaving a thread terminates the program,
+                //the entity is reported as not read instead
+                try {
+                    item.entity = parseDwgEntity(item.data, item.bs, item.obj, item.ok);
+                } catch (...) {
+                    item.entity.reset();
+                    item.good = false;
+                }
+            }
+        };
+        std::vector<std::thread> workers;
+        size_t nWorkers = std::min<size_t>(threadCount, batch.size());
+        for (size_t i = 1; i < nWorkers; ++i) {
+            try {
+                workers.emplace_back(worker);
+            } catch (const std::system_error&) {
+                break; //parse with the threads already running
+            }
         }
-        std::vector<duint8> tmpByteStr(size);
-        dbuf->getBytes(tmpByteStr.data(), size);
-        //verify if getBytes is ok:
-        if (!dbuf->isGood()){
-            DRW_DBG(" Warning: readDwgEntity, bad size\n");
-            return false;
+        worker();
+        for (std::thread &t : workers)
+            t.join();
+
+        for (dwgEntityItem &item : batch) {
+            auto mit = ObjectMap.find(item.obj.handle);
+            if (mit == ObjectMap.end())
+                continue; //vertex read with a polyline of this batch
+            ObjectMap.erase(mit);
+            if (!item.good)
+                ret2 = false;
+            else
+                ret2 = sendDwgEntity(item.entity.get(), item.obj, item.ok, dbuf, intfa);
+            if (ret)
+                ret = ret2;
         }
-        dwgBuffer buff(tmpByteStr.data(), size, &decoder);
-        dint16 oType = buff.getObjType(version);
-        buff.resetPosition();
-
-        if (oType > 499){
-            auto it = classesmap.find(oType);
-            if (it == classesmap.end()){//fail, not found in classes set error
-                DRW_DBG("Class "); DRW_DBG(oType);DRW_DBG("not found, handle: "); DRW_DBG(obj.handle); DRW_DBG("\n");
-                return false;
-            } else {
-                DRW_Class *cl = it->second;
-                if (cl->dwgType != 0)
-                    oType = cl->dwgType;
-            }
+    }
+    return ret;
+}
+
+/**
+ * Reads a dwg drawing entity (dwg object entity) given its offset in the file
+ */
+bool dwgReader::readDwgEntity(dwgBuffer *dbuf, objHandle& obj, DRW_Interface& intfa){
+    bool ret = true;
+    duint32 bs = 0;
+    std::vector<duint8> tmpByteStr;
+
+    nextEntLink = prevEntLink = 0;// set to 0 to skip unimplemented entities
+    if (!readObjectData(dbuf, obj, tmpByteStr, bs))
+        return false;
+    std::unique_ptr<DRW_Entity> e = parseDwgEntity(tmpByteStr, bs, obj, ret);
+    if (e) {
+        nextEntLink = e->nextEntLink;
+        prevEntLink = e->prevEntLink;
+    }
+    return sendDwgEntity(e.get(), obj, ret, dbuf, intfa);
+}
+
+/**
+ * Copies the data of a dwg object, given its offset in dbuf
+ */
+bool dwgReader::readObjectData(dwgBuffer *dbuf, const objHandle& obj, std::vector<duint8>& data, duint32& bs){
+    bs = 0;
+    dbuf->setPosition(obj.loc);
+    //verify if position is ok:
+    if (!dbuf->isGood()){
+        DRW_DBG(" Warning: readDwgEntity, bad location\n");
+        return false;
+    }
+    int size = dbuf->getModularShort();
+    if (version > DRW::AC1021) {//2010+
+        bs = dbuf->getUModularChar();
+    }
+    data.resize(size);
+    dbuf->getBytes(data.data(), size);
+    //verify if getBytes is ok:
+    if (!dbuf->isGood()){
+        DRW_DBG(" Warning: readDwgEntity, bad size\n");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Parses a dwg drawing entity from the data of its object and sets the
+ * object type. Returns nullptr for objects which are not supported entities,
+ * ok is set to false if the class of the object is unknown or the entity
+ * has failed. Only reads the tables of the reader, so it can be called
+ * from several threads at once.
+ */
+std::unique_ptr<DRW_Entity> dwgReader::parseDwgEntity(std::vector<duint8>& data, duint32 bs, objHandle& obj, bool& ok){
+    std::unique_ptr<DRW_Entity> e;
+    dwgBuffer buff(data.data(), data.size(), &decoder);
+    dint16 oType = buff.getObjType(version);
+    buff.resetPosition();
+
+    if (oType > 499){
+        auto it = classesmap.find(oType);
+        if (it == classesmap.end()){//fail, not found in classes set error
+            DRW_DBG("Class "); DRW_DBG(oType);DRW_DBG("not found, handle: "); DRW_DBG(obj.handle); DRW_DBG("\n");
+            ok = false;
+            return e;
+        } else {
+            DRW_Class *cl = it->second;
+            if (cl->dwgType != 0)
+                oType = cl->dwgType;
         }
+    }
 
-        obj.type = oType;
-        switch (oType){
-        case 17: {
-            DRW_Arc e;
-            ENTRY_PARSE(e)
-            intfa.addArc(e);
-            break; }
-        case 18: {
-            DRW_Circle e;
-            ENTRY_PARSE(e)
-            intfa.addCircle(e);
-            break; }
-        case 19:{
-            DRW_Line e;
-            ENTRY_PARSE(e)
-            intfa.addLine(e);
-            break;}
-        case 27: {
-            DRW_Point e;
-            ENTRY_PARSE(e)
-            intfa.addPoint(e);
-            break; }
-        case 35: {
-            DRW_Ellipse e;
-            ENTRY_PARSE(e)
-            intfa.addEllipse(e);
-            break; }
-        case 7:
-        case 8: {//minsert = 8
-            DRW_Insert e;
-            ENTRY_PARSE(e)
-            e.name = findTableName(DRW::BLOCK_RECORD, e.blockRecH.ref);//RLZ: find as block or blockrecord (ps & ps0)
-            intfa.addInsert(e);
-            break; }
-        case 77: {
-            DRW_LWPolyline e;
-            ENTRY_PARSE(e)
-            intfa.addLWPolyline(e);
-            break; }
-        case 1: {
-            DRW_Text e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::STYLE, e.styleH.ref);
-            intfa.addText(e);
-            break; }
-        case 44: {
-            DRW_MText e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::STYLE, e.styleH.ref);
-            intfa.addMText(e);
-            break; }
-        case 28: {
-            DRW_3Dface e;
-            ENTRY_PARSE(e)
-            intfa.add3dFace(e);
-            break; }
-        case 20: {
-            DRW_DimOrdinate e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-            intfa.addDimOrdinate(&e);
-            break; }
-        case 21: {
-            DRW_DimLinear e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-            intfa.addDimLinear(&e);
-            break; }
-        case 22: {
-            DRW_DimAligned e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-            intfa.addDimAlign(&e);
-            break; }
-        case 23: {
-            DRW_DimAngular3p e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-            intfa.addDimAngular3P(&e);
-            break; }
-        case 24: {
-            DRW_DimAngular e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-            intfa.addDimAngular(&e);
-            break; }
-        case 25: {
-            DRW_DimRadial e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-            intfa.addDimRadial(&e);
-            break; }
-        case 26: {
-            DRW_DimDiametric e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-            intfa.addDimDiametric(&e);
-            break; }
-        case 45: {
-            DRW_Leader e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-            intfa.addLeader(&e);
-            break; }
-        case 31: {
-            DRW_Solid e;
-            ENTRY_PARSE(e)
-            intfa.addSolid(e);
-            break; }
-        case 78: {
-            DRW_Hatch e;
-            ENTRY_PARSE(e)
-            intfa.addHatch(&e);
-            break; }
-        case 32: {
-            DRW_Trace e;
-            ENTRY_PARSE(e)
-            intfa.addTrace(e);
-            break; }
-        case 34: {
-            DRW_Viewport e;
-            ENTRY_PARSE(e)
-            intfa.addViewport(e);
-            break; }
-        case 36: {
-            DRW_Spline e;
-            ENTRY_PARSE(e)
-            intfa.addSpline(&e);
-            break; }
-        case 40: {
-            DRW_Ray e;
-            ENTRY_PARSE(e)
-            intfa.addRay(e);
-            break; }
-        case 15:    // pline 2D
-        case 16:    // pline 3D
-        case 29: {  // pline PFACE
-            DRW_Polyline e;
-            ENTRY_PARSE(e)
-            readPlineVertex(e, dbuf);
-            intfa.addPolyline(e);
-            break; }
-//        case 30: {
-//            DRW_Polyline e;// MESH (not pline)
-//            ENTRY_PARSE(e)
-//            intfa.addRay(e);
-//            break; }
-        case 41: {
-            DRW_Xline e;
-            ENTRY_PARSE(e)
-            intfa.addXline(e);
-            break; }
-        case 101: {
-            DRW_Image e;
-            ENTRY_PARSE(e)
-            intfa.addImage(&e);
-            break; }
+    obj.type = oType;
+    switch (oType){
+    case 17:
+        e.reset(new DRW_Arc);
+        break;
+    case 18:
+        e.reset(new DRW_Circle);
+        break;
+    case 19:
+        e.reset(new DRW_Line);
+        break;
+    case 27:
+        e.reset(new DRW_Point);
+        break;
+    case 35:
+        e.reset(new DRW_Ellipse);
+        break;
+    case 7:
+    case 8: //minsert = 8
+        e.reset(new DRW_Insert);
+        break;
+    case 77:
+        e.reset(new DRW_LWPolyline);
+        break;
+    case 1:
+        e.reset(new DRW_Text);
+        break;
+    case 44:
+        e.reset(new DRW_MText);
+        break;
+    case 28:
+        e.reset(new DRW_3Dface);
+        break;
+    case 20:
+        e.reset(new DRW_DimOrdinate);
+        break;
+    case 21:
+        e.reset(new DRW_DimLinear);
+        break;
+    case 22:
+        e.reset(new DRW_DimAligned);
+        break;
+    case 23:
+        e.reset(new DRW_DimAngular3p);
+        break;
+    case 24:
+        e.reset(new DRW_DimAngular);
+        break;
+    case 25:
+        e.reset(new DRW_DimRadial);
+        break;
+    case 26:
+        e.reset(new DRW_DimDiametric);
+        break;
+    case 45:
+        e.reset(new DRW_Leader);
+        break;
+    case 31:
+        e.reset(new DRW_Solid);
+        break;
+    case 78:
+        e.reset(new DRW_Hatch);
+        break;
+    case 32:
+        e.reset(new DRW_Trace);
+        break;
+    case 34:
+        e.reset(new DRW_Viewport);
+        break;
+    case 36:
+        e.reset(new DRW_Spline);
+        break;
+    case 40:
+        e.reset(new DRW_Ray);
+        break;
+    case 15:    // pline 2D
+    case 16:    // pline 3D
+    case 29:    // pline PFACE
+        e.reset(new DRW_Polyline);
+        break;
+//    case 30:
+//        e.reset(new DRW_Polyline);// MESH (not pline)
+//        break;
+    case 41:
+        e.reset(new DRW_Xline);
+        break;
+    case 101:
+        e.reset(new DRW_Image);
+        break;
+    default:
+        //not supported or are object
+        return e;
+    }
 
-        default:
-            //not supported or are object add to remaining map
+    ok = e->parseDwg(version, &buff, bs);
+    parseAttribs(e.get());
+    return e;
+}
+
+/**
+ * Sends an entity parsed by parseDwgEntity to the interface, objects which
+ * are not supported entities are added to the remaining map.
+ * Returns ok.
+ */
+bool dwgReader::sendDwgEntity(DRW_Entity *e, objHandle& obj, bool ok, dwgBuffer *dbuf, DRW_Interface& intfa){
+    if (!e) {
+        //not supported or are object add to remaining map
+        if (ok)
             objObjectMap[obj.handle]= obj;
+        return ok;
+    }
+
+    switch (obj.type){
+    case 17:
+        intfa.addArc(*static_cast<DRW_Arc*>(e));
+        break;
+    case 18:
+        intfa.addCircle(*static_cast<DRW_Circle*>(e));
+        break;
+    case 19:
+        intfa.addLine(*static_cast<DRW_Line*>(e));
+        break;
+    case 27:
+        intfa.addPoint(*static_cast<DRW_Point*>(e));
+        break;
+    case 35:
+        intfa.addEllipse(*static_cast<DRW_Ellipse*>(e));
+        break;
+    case 7:
+    case 8: {//minsert = 8
+        DRW_Insert *ins = static_cast<DRW_Insert*>(e);
+        ins->name = findTableName(DRW::BLOCK_RECORD, ins->blockRecH.ref);//RLZ: find as block or blockrecord (ps & ps0)
+        intfa.addInsert(*ins);
+        break; }
+    case 77:
+        intfa.addLWPolyline(*static_cast<DRW_LWPolyline*>(e));
+        break;
+    case 1: {
+        DRW_Text *txt = static_cast<DRW_Text*>(e);
+        txt->style = findTableName(DRW::STYLE, txt->styleH.ref);
+        intfa.addText(*txt);
+        break; }
+    case 44: {
+        DRW_MText *txt = static_cast<DRW_MText*>(e);
+        txt->style = findTableName(DRW::STYLE, txt->styleH.ref);
+        intfa.addMText(*txt);
+        break; }
+    case 28:
+        intfa.add3dFace(*static_cast<DRW_3Dface*>(e));
+        break;
+    case 20:
+    case 21:
+    case 22:
+    case 23:
+    case 24:
+    case 25:
+    case 26: {
+        DRW_Dimension *dim = static_cast<DRW_Dimension*>(e);
+        dim->style = findTableName(DRW::DIMSTYLE, dim->dimStyleH.ref);
+        switch (obj.type){
+        case 20:
+            intfa.addDimOrdinate(static_cast<DRW_DimOrdinate*>(dim));
+            break;
+        case 21:
+            intfa.addDimLinear(static_cast<DRW_DimLinear*>(dim));
+            break;
+        case 22:
+            intfa.addDimAlign(static_cast<DRW_DimAligned*>(dim));
+            break;
+        case 23:
+            intfa.addDimAngular3P(static_cast<DRW_DimAngular3p*>(dim));
+            break;
+        case 24:
+            intfa.addDimAngular(static_cast<DRW_DimAngular*>(dim));
+            break;
+        case 25:
+            intfa.addDimRadial(static_cast<DRW_DimRadial*>(dim));
+            break;
+        default:
+            intfa.addDimDiametric(static_cast<DRW_DimDiametric*>(dim));
             break;
         }
-        if (!ret){
-            DRW_DBG("Warning: Entity type "); DRW_DBG(oType);DRW_DBG("has failed, handle: "); DRW_DBG(obj.handle); DRW_DBG("\n");
-        }
-    return ret;
+        break; }
+    case 45: {
+        DRW_Leader *leader = static_cast<DRW_Leader*>(e);
+        leader->style = findTableName(DRW::DIMSTYLE, leader->dimStyleH.ref);
+        intfa.addLeader(leader);
+        break; }
+    case 31:
+        intfa.addSolid(*static_cast<DRW_Solid*>(e));
+        break;
+    case 78:
+        intfa.addHatch(static_cast<DRW_Hatch*>(e));
+        break;
+    case 32:
+        intfa.addTrace(*static_cast<DRW_Trace*>(e));
+        break;
+    case 34:
+        intfa.addViewport(*static_cast<DRW_Viewport*>(e));
+        break;
+    case 36:
+        intfa.addSpline(static_cast<DRW_Spline*>(e));
+        break;
+    case 40:
+        intfa.addRay(*static_cast<DRW_Ray*>(e));
+        break;
+    case 15:    // pline 2D
+    case 16:    // pline 3D
+    case 29: {  // pline PFACE
+        DRW_Polyline *pline = static_cast<DRW_Polyline*>(e);
+        readPlineVertex(*pline, dbuf);
+        intfa.addPolyline(*pline);
+        break; }
+    case 41:
+        intfa.addXline(*static_cast<DRW_Xline*>(e));
+        break;
+    case 101:
+        intfa.addImage(static_cast<DRW_Image*>(e));
+        break;
+    default:
+        break;
+    }
+    if (!ok){
+        DRW_DBG("Warning: Entity type "); DRW_DBG(obj.type);DRW_DBG("has failed, handle: "); DRW_DBG(obj.handle); DRW_DBG("\n");
+    }
+    return ok;
 }
 
 bool dwgReader::readDwgObjects(DRW_Interface& intfa, dwgBuffer *dbuf){
@@ -16,6 +16,7 @@
 #include <unordered_map>
 #include <list>
 #include <memory>
+#include <vector>
 #include "drw_textcodec.h"
 #include "dwgutil.h"
 #include "dwgbuffer.h"
@@ -140,6 +141,9 @@ protected:
     virtual bool readDwgObjects(DRW_Interface& intfa) = 0;
 
     virtual bool readDwgEntity(dwgBuffer *dbuf, objHandle& obj, DRW_Interface& intfa);
+    bool readObjectData(dwgBuffer *dbuf, const objHandle& obj, std::vector<duint8>& data, duint32& bs);
+    std::unique_ptr<DRW_Entity> parseDwgEntity(std::vector<duint8>& data, duint32 bs, objHandle& obj, bool& ok);
+    bool sendDwgEntity(DRW_Entity *e, objHandle& obj, bool ok, dwgBuffer *dbuf, DRW_Interface& intfa);
     bool readDwgObject(dwgBuffer *dbuf, objHandle& obj, DRW_Interface& intfa);
     void parseAttribs(DRW_Entity* e);
     std::string findTableName(DRW::TTYPE table, dint32 handle);
@@ -153,6 +157,7 @@ protected:
 
     bool readDwgBlocks(DRW_Interface& intfa, dwgBuffer *dbuf);
     bool readDwgEntities(DRW_Interface& intfa, dwgBuffer *dbuf);
+    bool readDwgEntitiesParallel(DRW_Interface& intfa, dwgBuffer *dbuf);
     bool readDwgObjects(DRW_Interface& intfa, dwgBuffer *dbuf);
     bool readPlineVertex(DRW_Polyline& pline, dwgBuffer *dbuf);
 
@@ -170,6 +175,7 @@ public:
     std::unordered_map<duint32, DRW_AppId*> appIdmap;
 //    duint32 currBlock;
     duint8 maintenanceVersion{0};
+    unsigned int threadCount{1}; //threads used to parse the entities
 
 protected:
     std::unique_ptr<dwgBuffer> fileBuf;
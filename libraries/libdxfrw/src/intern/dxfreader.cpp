@@ -11,6 +11,7 @@
 ******************************************************************************/
 
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <string>
 #include <sstream>
@@ -18,6 +19,10 @@
 #include "drw_textcodec.h"
 #include "drw_dbg.h"
 
+bool dxfReader::good() const {
+    return filestr->good();
+}
+
 bool dxfReader::readRec(int *codeData) {
 //    std::string text;
     int code;
@@ -95,7 +100,7 @@ bool dxfReader::readRec(int *codeData) {
         //break in binary files because the conduct is unpredictable
         return false;
 
-    return (filestr->good());
+    return good();
 }
 int dxfReader::getHandleString(){
     int res;
@@ -286,3 +291,226 @@ bool dxfReaderAscii::readBool() {
         return false;
 }
 
+namespace {
+//! white space skipped by atoi() and by streams in the "C" locale
+bool isSpace(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/**
+ * Converts [begin, end) like atoi(), returns false if the number has
+ * too many digits to be sure about the result.
+ */
+bool parseInt(const char *begin, const char *end, int *value) {
+    const char *p = begin;
+    while (p < end && isSpace(*p))
+        ++p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = (*p++ == '-');
+    int result = 0;
+    int digits = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+        if (++digits > 9)
+            return false;
+        result = result * 10 + (*p - '0');
+    }
+    *value = negative ? -result : result;
+    return true;
+}
+
+/**
+ * Converts a plain decimal number in [begin, end) like a stream in the
+ * "C" locale does. Only numbers with up to 15 significant digits and
+ * small exponents are handled, these are converted exactly with a
+ * single multiplication or division. Returns false for everything else.
+ */
+bool parseDouble(const char *begin, const char *end, double *value) {
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+        1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+        1e21, 1e22
+    };
+    const char *p = begin;
+    while (p < end && isSpace(*p))
+        ++p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = (*p++ == '-');
+
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool anyDigit = false;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+        anyDigit = true;
+        if (mantissa == 0 && *p == '0')
+            continue;
+        if (++digits > 15)
+            return false;
+        mantissa = mantissa * 10 + (*p - '0');
+    }
+    if (p < end && *p == '.') {
+        for (++p; p < end && *p >= '0' && *p <= '9'; ++p) {
+            anyDigit = true;
+            --exponent;
+            if (mantissa == 0 && *p == '0')
+                continue;
+            if (++digits > 15)
+                return false;
+            mantissa = mantissa * 10 + (*p - '0');
+        }
+    }
+    if (!anyDigit)
+        return false;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negativeExp = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negativeExp = (*p++ == '-');
+        if (p == end || *p < '0' || *p > '9')
+            return false;
+        int exp = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+            if (exp > 1000)
+                return false;
+            exp = exp * 10 + (*p - '0');
+        }
+        exponent += negativeExp ? -exp : exp;
+    }
+
+    // mantissa has at most 15 digits, so it is exact as a double
+    double result = static_cast<double>(mantissa);
+    if (mantissa != 0) {
+        if (exponent < -22 || exponent > 22)
+            return false;
+        result = exponent < 0 ? result / powers[-exponent] : result * powers[exponent];
+    }
+    *value = negative ? -result : result;
+    return true;
+}
+}
+
+/**
+ * Gets the next line like std::getline() does, without the line feed.
+ * Returns the state of the input afterwards.
+ */
+bool dxfReaderAsciiBuffer::readLine(const char **lineBegin, const char **lineEnd) {
+    *lineBegin = *lineEnd = pos;
+    if (!isGood)
+        return false;
+    const char *lf = static_cast<const char *>(std::memchr(pos, '\n', last - pos));
+    if (lf) {
+        *lineEnd = lf;
+        pos = lf + 1;
+    } else {
+        // no line feed before the end of file
+        *lineEnd = pos = last;
+        isGood = false;
+    }
+    return isGood;
+}
+
+/**
+ * Reads a line holding a number, without the trailing carriage return.
+ * Returns false if the input ended, in that case nothing must be stored.
+ */
+bool dxfReaderAsciiBuffer::readNumber(const char **lineBegin, const char **lineEnd) {
+    //dxfReaderAscii reads numbers through readString(), keep its type
+    type = STRING;
+    readLine(lineBegin, lineEnd);
+    if (*lineEnd > *lineBegin && *(*lineEnd - 1) == '\r')
+        --*lineEnd;
+    return isGood;
+}
+
+bool dxfReaderAsciiBuffer::readCode(int *code) {
+    const char *begin, *end;
+    readLine(&begin, &end);
+    if (!parseInt(begin, end, code))
+        *code = atoi(std::string(begin, end).c_str());
+    DRW_DBG(*code); DRW_DBG("\n");
+    return isGood;
+}
+
+bool dxfReaderAsciiBuffer::readString(std::string *text) {
+    type = STRING;
+    if (!isGood)
+        return false;
+    const char *begin, *end;
+    readLine(&begin, &end);
+    if (end > begin && *(end - 1) == '\r')
+        --end;
+    text->assign(begin, end);
+    return isGood;
+}
+
+bool dxfReaderAsciiBuffer::readString() {
+    readString(&strData);
+    DRW_DBG(strData); DRW_DBG("\n");
+    return isGood;
+}
+
+bool dxfReaderAsciiBuffer::readBinary() {
+    return readString();
+}
+
+bool dxfReaderAsciiBuffer::readInt16() {
+    type = INT32;
+    const char *begin, *end;
+    if (readNumber(&begin, &end)) {
+        if (!parseInt(begin, end, &intData))
+            intData = atoi(std::string(begin, end).c_str());
+        DRW_DBG(intData); DRW_DBG("\n");
+        return true;
+    } else
+        return false;
+}
+
+bool dxfReaderAsciiBuffer::readInt32() {
+    type = INT32;
+    return readInt16();
+}
+
+bool dxfReaderAsciiBuffer::readInt64() {
+    type = INT64;
+    return readInt16();
+}
+
+bool dxfReaderAsciiBuffer::readDouble() {
+    type = DOUBLE;
+    const char *begin, *end;
+    if (readNumber(&begin, &end)) {
+        if (!parseDouble(begin, end, &doubleData)) {
+            std::string text(begin, end);
+#if defined(__APPLE__)
+            int succeeded=sscanf( & (text[0]), "%lg", &doubleData);
+            if(succeeded != 1) {
+                DRW_DBG("dxfReaderAsciiBuffer::readDouble(): reading double error: ");
+                DRW_DBG(text);
+                DRW_DBG('\n');
+            }
+#else
+            std::istringstream sd(text);
+            sd >> doubleData;
+#endif
+        }
+        DRW_DBG(doubleData); DRW_DBG('\n');
+        return true;
+    } else
+        return false;
+}
+
+//saved as int or add a bool member??
+bool dxfReaderAsciiBuffer::readBool() {
+    type = BOOL;
+    const char *begin, *end;
+    if (readNumber(&begin, &end)) {
+        if (!parseInt(begin, end, &intData))
+            intData = atoi(std::string(begin, end).c_str());
+        DRW_DBG(intData); DRW_DBG("\n");
+        return true;
+    } else
+        return false;
+}
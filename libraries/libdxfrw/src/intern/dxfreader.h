@@ -49,6 +49,8 @@ public:
     void setIgnoreComments(const bool bValue) {m_bIgnoreComments = bValue;}
 
 protected:
+    //! state of the input after the last read, like std::istream::good()
+    virtual bool good() const;
     virtual bool readCode(int *code) = 0; //return true if successful (not EOF)
     virtual bool readString(std::string *text) = 0;
     virtual bool readString() = 0;
@@ -101,4 +103,36 @@ public:
     virtual bool readBool();
 };
 
+/**
+ * Ascii reader for a file loaded into memory as a whole. Lines are parsed
+ * in place and plain decimal numbers are converted without a stream, the
+ * results are the same as the ones of dxfReaderAscii.
+ */
+class dxfReaderAsciiBuffer : public dxfReader {
+public:
+    dxfReaderAsciiBuffer(const char *begin, const char *end):
+        dxfReader(nullptr), pos(begin), last(end) {skip = true; }
+    virtual ~dxfReaderAsciiBuffer(){}
+    virtual bool readCode(int *code);
+    virtual bool readString(std::string *text);
+    virtual bool readString();
+    virtual bool readBinary();
+    virtual bool readInt16();
+    virtual bool readDouble();
+    virtual bool readInt32();
+    virtual bool readInt64();
+    virtual bool readBool();
+
+protected:
+    virtual bool good() const {return isGood;}
+
+private:
+    bool readLine(const char **lineBegin, const char **lineEnd);
+    bool readNumber(const char **lineBegin, const char **lineEnd);
+
+    const char *pos;
+    const char *last;
+    bool isGood {true};
+};
+
 #endif // DXFREADER_H
@@ -15,6 +15,7 @@
 #include <fstream>
 #include <algorithm>
 #include <sstream>
+#include <thread>
 #include "intern/drw_dbg.h"
 #include "intern/drw_textcodec.h"
 #include "intern/dwgreader.h"
@@ -141,6 +142,9 @@ bool dwgR::read(DRW_Interface *interface_, bool ext){
     isOk = openFile(&filestr);
     if (!isOk)
         return false;
+    reader->threadCount = threadCount;
+    if (reader->threadCount == 0)
+        reader->threadCount = std::max(1u, std::thread::hardware_concurrency());
 
     isOk = reader->readMetaData();
     if (isOk) {
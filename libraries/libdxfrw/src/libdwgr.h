@@ -35,6 +35,8 @@ public:
     DRW::error getError(){return error;}
 bool testReader();
     void setDebug(DRW::DebugLevel lvl);
+    //threads used to parse entities, 0 uses all cores, 1 parses sequentially
+    void setThreadCount(unsigned int count){threadCount = count;}
 
 private:
     bool openFile(std::ifstream *filestr);
@@ -49,6 +51,7 @@ private:
     std::string codePage;
     DRW_Interface *iface { nullptr };
     std::unique_ptr< dwgReader > reader;
+    unsigned int threadCount { 0 };
 
 };
 
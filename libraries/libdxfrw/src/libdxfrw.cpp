@@ -15,6 +15,7 @@
 #include "libdxfrw.h"
 #include <fstream>
 #include <algorithm>
+#include <vector>
 #include <sstream>
 #include <cassert>
 #include "intern/drw_textcodec.h"
@@ -66,6 +67,7 @@ bool dxfRW::read(DRW_Interface *interface_, bool ext){
     drw_assert(fileName.empty() == false);
     applyExt = ext;
     std::ifstream filestr;
+    std::vector<char> buffer;
     if (nullptr == interface_) {
         return setError(DRW::BAD_UNKNOWN);
     }
@@ -93,8 +95,24 @@ bool dxfRW::read(DRW_Interface *interface_, bool ext){
         DRW_DBG("dxfRW::read binary file\n");
     } else {
         binFile = false;
-        filestr.open (fileName.c_str(), std::ios_base::in);
-        reader = new dxfReaderAscii(&filestr);
+        //load the whole file and parse it in place, it is much faster
+        //than reading it line by line from the stream
+        filestr.open (fileName.c_str(), std::ios_base::in | std::ios::binary);
+        filestr.seekg (0, std::ios::end);
+        std::streamoff size = filestr.tellg();
+        if (size > 0) {
+            buffer.resize(static_cast<size_t>(size));
+            filestr.seekg (0, std::ios::beg);
+            filestr.read (&buffer[0], size);
+        }
+        if (size > 0 && filestr.gcount() == size) {
+            reader = new dxfReaderAsciiBuffer(buffer.data(), buffer.data() + buffer.size());
+        } else {
+            buffer.clear();
+            filestr.close();
+            filestr.open (fileName.c_str(), std::ios_base::in);
+            reader = new dxfReaderAscii(&filestr);
+        }
     }
 
     bool isOk {processDxf()};
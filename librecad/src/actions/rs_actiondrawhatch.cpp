@@ -24,6 +24,7 @@
 **
 **********************************************************************/
 #include <iostream>
+#include <vector>
 #include <QAction>
 #include <QMouseEvent>
 #include "rs_actiondrawhatch.h"
@@ -33,6 +34,27 @@
 #include "rs_hatch.h"
 #include "rs_debug.h"
 
+namespace {
+/**
+ * Appends the entities firstEntity(RS2::ResolveAll) returns for the
+ * container to list. Inserts which aren't selected have no selected
+ * entities and aren't resolved.
+ */
+void appendResolved(RS_EntityContainer* container, std::vector<RS_Entity*>& list)
+{
+	for (RS_Entity* e=container->firstEntity(); e; e=container->nextEntity()) {
+		if (e->rtti()==RS2::EntityInsert && !e->isSelected()) {
+			continue;
+		}
+		if (e->isContainer()) {
+			appendResolved(static_cast<RS_EntityContainer*>(e), list);
+		} else {
+			list.push_back(e);
+		}
+	}
+}
+}
+
 RS_ActionDrawHatch::RS_ActionDrawHatch(RS_EntityContainer& container, RS_GraphicView& graphicView)
                                 :RS_PreviewActionInterface("Draw Hatch", container, graphicView)
 								, data{new RS_HatchData{}}
@@ -69,8 +91,6 @@ void RS_ActionDrawHatch::trigger() {
 
     //if (pos.valid) {
     //deletePreview();
-	RS_Entity* e;
-
 	// deselect unhatchable entities:
 	for(auto e: *container){
         if (e->isSelected() && 
@@ -81,8 +101,9 @@ void RS_ActionDrawHatch::trigger() {
 			e->setSelected(false);
         }
     }
-	for (e=container->firstEntity(RS2::ResolveAll); e;
-            e=container->nextEntity(RS2::ResolveAll)) {
+	std::vector<RS_Entity*> resolved;
+	appendResolved(container, resolved);
+	for (RS_Entity* e: resolved) {
         if (e->isSelected() && 
             (e->rtti()==RS2::EntityHatch ||
             /* e->rtti()==RS2::EntityEllipse ||*/ e->rtti()==RS2::EntityPoint ||
@@ -94,8 +115,7 @@ void RS_ActionDrawHatch::trigger() {
 
 	// look for selected contours:
     bool haveContour = false;
-	for (e=container->firstEntity(RS2::ResolveAll); e;
-            e=container->nextEntity(RS2::ResolveAll)) {
+	for (RS_Entity* e: resolved) {
         if (e->isSelected()) {
             haveContour = true;
         }
@@ -113,8 +133,7 @@ void RS_ActionDrawHatch::trigger() {
     loop->setPen(RS_Pen(RS2::FlagInvalid));
 
     // add selected contour:
-	for (RS_Entity* e=container->firstEntity(RS2::ResolveAll); e;
-            e=container->nextEntity(RS2::ResolveAll)) {
+	for (RS_Entity* e: resolved) {
 
         if (e->isSelected()) {
             e->setSelected(false);
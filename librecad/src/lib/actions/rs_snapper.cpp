@@ -649,7 +649,9 @@ RS_Entity* RS_Snapper::catchEntity(const RS_Vector& pos, RS2::EntityType enType,
 		break;
 	}
 
-	for(RS_Entity* en= container->firstEntity(level);en;en=container->nextEntity(level)){
+	// only entities within snap range can be caught
+	RS_Vector const range{getSnapRange(), getSnapRange()};
+	for(RS_Entity* en: container->getEntitiesOverlappingWindow(pos - range, pos + range, level)){
         if(en->isVisible()==false) continue;
 		if(en->rtti() != enType && isContainer){
             //whether this entity is a member of member of the type enType
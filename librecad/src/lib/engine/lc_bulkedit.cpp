@@ -0,0 +1,183 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2018 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "lc_bulkedit.h"
+#include "rs_entitycontainer.h"
+#include "rs_graphicview.h"
+
+namespace {
+bool onBorder(double value, double border)
+{
+    return std::abs(value - border) <= RS_TOLERANCE * std::max(1., std::abs(border));
+}
+}
+
+LC_BulkEdit::LC_BulkEdit(RS_EntityContainer& container, RS_Document* document,
+                         RS_GraphicView* graphicView, bool handleUndo) :
+    container(container),
+    graphicView(graphicView),
+    undo(document, handleUndo)
+{
+    double const inf = std::numeric_limits<double>::infinity();
+    dirty = {inf, inf, -inf, -inf};
+}
+
+LC_BulkEdit::~LC_BulkEdit()
+{
+    apply();
+}
+
+void LC_BulkEdit::reserve(size_t count)
+{
+    added.reserve(added.size() + count);
+}
+
+void LC_BulkEdit::add(RS_Entity* entity)
+{
+    if (entity) {
+        added.push_back(entity);
+    }
+}
+
+void LC_BulkEdit::remove(RS_Entity* entity)
+{
+    if (entity) {
+        removed.push_back(entity);
+    }
+}
+
+void LC_BulkEdit::select(RS_Entity* entity, bool select)
+{
+    if (entity) {
+        selected.emplace_back(entity, select);
+    }
+}
+
+void LC_BulkEdit::change(RS_Entity* entity)
+{
+    if (!entity) {
+        return;
+    }
+    // the old geometry has to be erased
+    extendDirty(entity);
+    shrinkBorders = shrinkBorders || touchesBorders(entity);
+    changed.push_back(entity);
+}
+
+void LC_BulkEdit::addUndoable(RS_Undoable* undoable)
+{
+    undo.addUndoable(undoable);
+}
+
+void LC_BulkEdit::extendDirty(RS_Entity const* entity)
+{
+    LC_SpatialIndex::Box box;
+    if (!LC_SpatialIndex::entityBox(entity, box)) {
+        dirtyEverywhere = true;
+        return;
+    }
+    dirty.minX = std::min(dirty.minX, box.minX);
+    dirty.minY = std::min(dirty.minY, box.minY);
+    dirty.maxX = std::max(dirty.maxX, box.maxX);
+    dirty.maxY = std::max(dirty.maxY, box.maxY);
+}
+
+bool LC_BulkEdit::touchesBorders(RS_Entity const* entity) const
+{
+    RS_Vector const& vMin = entity->getMin();
+    RS_Vector const& vMax = entity->getMax();
+    RS_Vector const& cMin = container.getMin();
+    RS_Vector const& cMax = container.getMax();
+    return onBorder(vMin.x, cMin.x) || onBorder(vMin.y, cMin.y)
+            || onBorder(vMax.x, cMax.x) || onBorder(vMax.y, cMax.y);
+}
+
+/**
+ * Applies the collected changes in one pass over them.
+ */
+void LC_BulkEdit::apply()
+{
+    if (added.empty() && removed.empty() && selected.empty() && changed.empty()) {
+        return;
+    }
+
+    for (auto const& p: selected) {
+        p.first->setSelected(p.second);
+        extendDirty(p.first);
+    }
+
+    for (RS_Entity* e: removed) {
+        e->setSelected(false);
+        e->setUndoState(true);
+        undo.addUndoable(e);
+        extendDirty(e);
+        shrinkBorders = shrinkBorders || touchesBorders(e);
+    }
+
+    for (RS_Entity* e: changed) {
+        container.entityChanged(e);
+        extendDirty(e);
+    }
+
+    container.reserve(static_cast<int>(added.size()));
+    for (RS_Entity* e: added) {
+        container.addEntity(e);
+        undo.addUndoable(e);
+        extendDirty(e);
+    }
+
+    if (shrinkBorders) {
+        container.updateBorders();
+    } else {
+        for (RS_Entity* e: changed) {
+            container.adjustBorders(e);
+        }
+    }
+
+    if (graphicView) {
+        // the view draws a block container wherever the block is inserted
+        RS_Entity const* top = &container;
+        while (top && top != graphicView->getContainer()) {
+            top = top->getParent();
+        }
+        if (dirtyEverywhere || !top) {
+            graphicView->redraw(RS2::RedrawDrawing);
+        } else if (dirty.minX <= dirty.maxX && dirty.minY <= dirty.maxY) {
+            graphicView->redrawWindow({dirty.minX, dirty.minY}, {dirty.maxX, dirty.maxY});
+        }
+    }
+
+    added.clear();
+    removed.clear();
+    selected.clear();
+    changed.clear();
+    shrinkBorders = false;
+    dirtyEverywhere = false;
+    double const inf = std::numeric_limits<double>::infinity();
+    dirty = {inf, inf, -inf, -inf};
+}
@@ -0,0 +1,101 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2018 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+#ifndef LC_BULKEDIT_H
+#define LC_BULKEDIT_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "lc_spatialindex.h"
+#include "lc_undosection.h"
+
+class RS_Document;
+class RS_Entity;
+class RS_EntityContainer;
+class RS_GraphicView;
+
+/** \brief Collects changes of many direct children of a container and
+ * applies them at once
+ *
+ * Entities are added, removed (undone), (de)selected or changed in place.
+ * apply() adds all new entities after reserving room for them, updates
+ * the borders of the container and its spatial index incrementally, and
+ * redraws only the part of the view the changed entities cover, instead
+ * of recalculating all borders and redrawing the whole drawing per edit.
+ *
+ * Like LC_UndoSection, all undoables go into one undo cycle, which ends
+ * when the instance goes out of scope.
+ */
+class LC_BulkEdit
+{
+public:
+    LC_BulkEdit(RS_EntityContainer& container, RS_Document* document = nullptr,
+                RS_GraphicView* graphicView = nullptr, bool handleUndo = true);
+    //! applies the changes not applied yet
+    ~LC_BulkEdit();
+
+    //! room for count entities to add
+    void reserve(size_t count);
+    void add(RS_Entity* entity);
+    //! removes the entity by undoing it
+    void remove(RS_Entity* entity);
+    void select(RS_Entity* entity, bool select = true);
+    void deselect(RS_Entity* entity) {
+        select(entity, false);
+    }
+    /**
+     * @brief change announce an entity which is about to be changed in
+     * place, its new geometry is read by apply()
+     */
+    void change(RS_Entity* entity);
+    //! adds an undoable to the undo cycle
+    void addUndoable(RS_Undoable* undoable);
+
+    void apply();
+
+private:
+    //! include the area covered by entity in the area to redraw
+    void extendDirty(RS_Entity const* entity);
+    //! @return true, if the entity is on the border of the container
+    bool touchesBorders(RS_Entity const* entity) const;
+
+    RS_EntityContainer& container;
+    RS_GraphicView* graphicView;
+    LC_UndoSection undo;
+
+    std::vector<RS_Entity*> added;
+    std::vector<RS_Entity*> removed;
+    std::vector<std::pair<RS_Entity*, bool>> selected;
+    std::vector<RS_Entity*> changed;
+
+    //! area to redraw
+    LC_SpatialIndex::Box dirty;
+    bool dirtyEverywhere {false};
+    //! borders may shrink, because an entity on them was removed or changed
+    bool shrinkBorders {false};
+};
+
+#endif // LC_BULKEDIT_H
@@ -0,0 +1,150 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2018 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include "lc_endpointmap.h"
+#include "rs_entity.h"
+
+namespace {
+//! cell numbers are clamped to this range, far beyond any drawing
+constexpr double maxCell = 1e18;
+}
+
+LC_EndpointMap::LC_EndpointMap(double tolerance):
+    tolerance(tolerance)
+{
+}
+
+size_t LC_EndpointMap::CellHash::operator () (const Cell& cell) const
+{
+    unsigned long long const x = static_cast<unsigned long long>(cell.x);
+    unsigned long long const y = static_cast<unsigned long long>(cell.y);
+    return std::hash<unsigned long long>()(x * 0x9E3779B97F4A7C15ULL ^ y);
+}
+
+LC_EndpointMap::Cell LC_EndpointMap::cellOf(const RS_Vector& v) const
+{
+    auto const index = [this](double x) {
+        double const i = std::floor(x / tolerance);
+        return static_cast<long long>(std::max(-maxCell, std::min(maxCell, i)));
+    };
+    return {index(v.x), index(v.y)};
+}
+
+bool LC_EndpointMap::insert(RS_Entity* entity, long order)
+{
+    if (!entity) {
+        return false;
+    }
+    RS_Vector const start = entity->getStartpoint();
+    RS_Vector const end = entity->getEndpoint();
+    if (!start.valid || !end.valid) {
+        return false;
+    }
+    add(start, entity, order, true);
+    add(end, entity, order, false);
+    ++count;
+    return true;
+}
+
+void LC_EndpointMap::add(const RS_Vector& point, RS_Entity* entity, long order, bool start)
+{
+    cells[cellOf(point)].push_back({point, entity, order, start});
+}
+
+void LC_EndpointMap::remove(RS_Entity const* entity)
+{
+    if (!entity) {
+        return;
+    }
+    RS_Vector const start = entity->getStartpoint();
+    RS_Vector const end = entity->getEndpoint();
+    if (!start.valid || !end.valid) {
+        return;
+    }
+    erase(start, entity);
+    erase(end, entity);
+    --count;
+}
+
+void LC_EndpointMap::erase(const RS_Vector& point, RS_Entity const* entity)
+{
+    auto it = cells.find(cellOf(point));
+    if (it == cells.end()) {
+        return;
+    }
+    std::vector<Endpoint>& list = it->second;
+    list.erase(std::remove_if(list.begin(), list.end(), [entity](const Endpoint& p) {
+        return p.entity == entity;
+    }), list.end());
+    if (list.empty()) {
+        cells.erase(it);
+    }
+}
+
+RS_Entity* LC_EndpointMap::nearest(const RS_Vector& coord, double* dist, bool* start) const
+{
+    if (!coord.valid || cells.empty()) {
+        return nullptr;
+    }
+    Cell const center = cellOf(coord);
+    Endpoint const* found = nullptr;
+    double minDist = tolerance;
+
+    for (long long x = center.x - 1; x <= center.x + 1; ++x) {
+        for (long long y = center.y - 1; y <= center.y + 1; ++y) {
+            auto it = cells.find({x, y});
+            if (it == cells.end()) {
+                continue;
+            }
+            for (const Endpoint& p: it->second) {
+                double const d = p.point.distanceTo(coord);
+                if (d > minDist) {
+                    continue;
+                }
+                // on ties, the first entity in the list wins
+                if (found && d == minDist && p.order > found->order) {
+                    continue;
+                }
+                found = &p;
+                minDist = d;
+            }
+        }
+    }
+
+    if (!found) {
+        return nullptr;
+    }
+    if (dist) {
+        *dist = minDist;
+    }
+    if (start) {
+        *start = found->start;
+    }
+    return found->entity;
+}
@@ -0,0 +1,103 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2018 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+
+#ifndef LC_ENDPOINTMAP_H
+#define LC_ENDPOINTMAP_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include "rs_vector.h"
+
+class RS_Entity;
+
+/** \brief Hash of the endpoints of entities, used to chain contours
+ *
+ * The endpoints are stored in a grid of square cells whose size is the
+ * tolerance, so all endpoints within the tolerance of a point are found
+ * by looking at the nine cells around it. Building the map and every
+ * query take constant time per endpoint, instead of a scan over all
+ * entities.
+ *
+ * Every entity carries an order number, normally its position in the
+ * owner's entity list, which resolves ties the same way a linear scan
+ * over the list would.
+ */
+class LC_EndpointMap
+{
+public:
+    //! endpoints closer than tolerance to a query point are matched
+    explicit LC_EndpointMap(double tolerance);
+
+    /**
+     * @brief insert add the start and the end point of an entity
+     * @return false, if the entity has no valid endpoints, e.g. a circle
+     */
+    bool insert(RS_Entity* entity, long order);
+    //! remove an entity, its endpoints must not have changed since insert()
+    void remove(RS_Entity const* entity);
+    bool isEmpty() const {
+        return count == 0;
+    }
+
+    /**
+     * @brief nearest find the entity with the endpoint closest to coord
+     * @param dist set to the distance of the endpoint found
+     * @param start set to true, if the startpoint of the entity was found
+     * @return nullptr, if no endpoint is within the tolerance
+     */
+    RS_Entity* nearest(const RS_Vector& coord, double* dist = nullptr,
+                       bool* start = nullptr) const;
+
+private:
+    struct Endpoint {
+        RS_Vector point;
+        RS_Entity* entity;
+        long order;
+        bool start;
+    };
+    struct Cell {
+        long long x;
+        long long y;
+
+        bool operator == (const Cell& other) const {
+            return x == other.x && y == other.y;
+        }
+    };
+    struct CellHash {
+        size_t operator () (const Cell& cell) const;
+    };
+
+    Cell cellOf(const RS_Vector& v) const;
+    void add(const RS_Vector& point, RS_Entity* entity, long order, bool start);
+    void erase(const RS_Vector& point, RS_Entity const* entity);
+
+    std::unordered_map<Cell, std::vector<Endpoint>, CellHash> cells;
+    double tolerance;
+    size_t count = 0;
+};
+
+#endif // LC_ENDPOINTMAP_H
@@ -0,0 +1,275 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2018 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <QTransform>
+#include "lc_glyphrun.h"
+#include "lc_rect.h"
+#include "rs_graphicview.h"
+#include "rs_line.h"
+#include "rs_math.h"
+#include "rs_painter.h"
+
+namespace {
+RS_Vector toDrawing(const LC_GlyphRun::Placement& p, const QPainterPath::Element& e)
+{
+    return p.position + p.xAxis * e.x + p.yAxis * e.y;
+}
+
+/**
+ * Calls f(start, end) for every stroke of the placed glyphs, the strokes
+ * of a glyph are lines only, arcs are polygonized by the font.
+ */
+template <class F>
+void forEachStroke(const std::vector<LC_GlyphRun::Placement>& placements, F f)
+{
+    for (const LC_GlyphRun::Placement& p: placements) {
+        const QPainterPath& strokes = p.glyph->strokes;
+        RS_Vector last;
+        for (int i = 0; i < strokes.elementCount(); ++i) {
+            const QPainterPath::Element& e = strokes.elementAt(i);
+            RS_Vector const current = toDrawing(p, e);
+            if (e.isLineTo()) {
+                f(last, current);
+            }
+            last = current;
+        }
+    }
+}
+
+RS_Vector nearestOnStroke(const RS_Vector& coord, const RS_Vector& start,
+                          const RS_Vector& end)
+{
+    RS_Vector const direction = end - start;
+    double const length2 = direction.squared();
+    if (length2 < RS_TOLERANCE2) {
+        return start;
+    }
+    double const t = (coord - start).dotP(direction) / length2;
+    return start + direction * std::min(1., std::max(0., t));
+}
+}
+
+LC_GlyphRun::LC_GlyphRun(RS_EntityContainer* parent):
+    RS_AtomicEntity(parent)
+{
+}
+
+RS_Entity* LC_GlyphRun::clone() const {
+    LC_GlyphRun* r = new LC_GlyphRun(*this);
+    r->initId();
+    return r;
+}
+
+void LC_GlyphRun::append(const RS_Font::Glyph* glyph, const RS_Vector& position,
+                         const RS_Vector& factor, double angle) {
+    // the glyph is scaled and then rotated, like the letter by an insert
+    placements.push_back({glyph, position,
+                          RS_Vector::polar(factor.x, angle),
+                          RS_Vector::polar(factor.y, angle + M_PI_2)});
+    adjustBorders(placements.back());
+}
+
+std::vector<RS_Line> LC_GlyphRun::getStrokes() const {
+    std::vector<RS_Line> ret;
+    forEachStroke(placements, [&ret](const RS_Vector& start, const RS_Vector& end) {
+        ret.emplace_back(start, end);
+    });
+    return ret;
+}
+
+bool LC_GlyphRun::isInCrossWindow(const RS_Vector& v1, const RS_Vector& v2) const {
+    LC_Rect const window(v1, v2);
+    bool ret = false;
+    forEachStroke(placements, [&](RS_Vector start, RS_Vector end) {
+        ret = ret || window.clipLine(start, end);
+    });
+    return ret;
+}
+
+RS_Vector LC_GlyphRun::getNearestEndpoint(const RS_Vector& coord, double* dist) const {
+    double minDist = RS_MAXDOUBLE;
+    RS_Vector ret(false);
+    forEachStroke(placements, [&](const RS_Vector& start, const RS_Vector& end) {
+        for (const RS_Vector& v: {start, end}) {
+            double const d = v.distanceTo(coord);
+            if (d < minDist) {
+                minDist = d;
+                ret = v;
+            }
+        }
+    });
+    if (dist) {
+        *dist = minDist;
+    }
+    return ret;
+}
+
+RS_Vector LC_GlyphRun::getNearestPointOnEntity(const RS_Vector& coord,
+                                               bool /*onEntity*/, double* dist,
+                                               RS_Entity** entity) const {
+    if (entity) {
+        *entity = const_cast<LC_GlyphRun*>(this);
+    }
+    double minDist = RS_MAXDOUBLE;
+    RS_Vector ret(false);
+    forEachStroke(placements, [&](const RS_Vector& start, const RS_Vector& end) {
+        RS_Vector const v = nearestOnStroke(coord, start, end);
+        double const d = v.distanceTo(coord);
+        if (d < minDist) {
+            minDist = d;
+            ret = v;
+        }
+    });
+    if (dist) {
+        *dist = minDist;
+    }
+    return ret;
+}
+
+RS_Vector LC_GlyphRun::getNearestCenter(const RS_Vector& /*coord*/, double* dist) const {
+    if (dist) {
+        *dist = RS_MAXDOUBLE;
+    }
+    return RS_Vector(false);
+}
+
+RS_Vector LC_GlyphRun::getNearestMiddle(const RS_Vector& /*coord*/, double* dist,
+                                        int /*middlePoints*/) const {
+    if (dist) {
+        *dist = RS_MAXDOUBLE;
+    }
+    return RS_Vector(false);
+}
+
+RS_Vector LC_GlyphRun::getNearestDist(double /*distance*/, const RS_Vector& /*coord*/,
+                                      double* dist) const {
+    if (dist) {
+        *dist = RS_MAXDOUBLE;
+    }
+    return RS_Vector(false);
+}
+
+double LC_GlyphRun::getDistanceToPoint(const RS_Vector& coord, RS_Entity** entity,
+                                       RS2::ResolveLevel /*level*/,
+                                       double /*solidDist*/) const {
+    double dist = RS_MAXDOUBLE;
+    getNearestPointOnEntity(coord, true, &dist, entity);
+    return dist;
+}
+
+void LC_GlyphRun::move(const RS_Vector& offset) {
+    for (Placement& p: placements) {
+        p.position.move(offset);
+    }
+    moveBorders(offset);
+}
+
+void LC_GlyphRun::rotate(const RS_Vector& center, const double& angle) {
+    rotate(center, RS_Vector(angle));
+}
+
+void LC_GlyphRun::rotate(const RS_Vector& center, const RS_Vector& angleVector) {
+    for (Placement& p: placements) {
+        p.position.rotate(center, angleVector);
+        p.xAxis.rotate(angleVector);
+        p.yAxis.rotate(angleVector);
+    }
+    calculateBorders();
+}
+
+void LC_GlyphRun::scale(const RS_Vector& center, const RS_Vector& factor) {
+    for (Placement& p: placements) {
+        p.position.scale(center, factor);
+        p.xAxis.scale(factor);
+        p.yAxis.scale(factor);
+    }
+    calculateBorders();
+}
+
+void LC_GlyphRun::mirror(const RS_Vector& axisPoint1, const RS_Vector& axisPoint2) {
+    RS_Vector const origin(0.0, 0.0);
+    RS_Vector const axis = axisPoint2 - axisPoint1;
+    for (Placement& p: placements) {
+        p.position.mirror(axisPoint1, axisPoint2);
+        p.xAxis.mirror(origin, axis);
+        p.yAxis.mirror(origin, axis);
+    }
+    calculateBorders();
+}
+
+/**
+ * Draws all letters as one path, the strokes of a glyph are shared by
+ * all of its placements.
+ */
+void LC_GlyphRun::draw(RS_Painter* painter, RS_GraphicView* view, double& /*patternOffset*/) {
+    if (!(painter && view) || placements.empty()) {
+        return;
+    }
+
+    RS_Vector const origin = view->toGui(RS_Vector(0.0, 0.0));
+    RS_Vector const ex = view->toGui(RS_Vector(1.0, 0.0)) - origin;
+    RS_Vector const ey = view->toGui(RS_Vector(0.0, 1.0)) - origin;
+    QTransform const toGui(ex.x, ex.y, ey.x, ey.y, origin.x, origin.y);
+
+    QPainterPath path;
+    for (const Placement& p: placements) {
+        QTransform const toDrawing(p.xAxis.x, p.xAxis.y, p.yAxis.x, p.yAxis.y,
+                                   p.position.x, p.position.y);
+        path.addPath((toDrawing * toGui).map(p.glyph->strokes));
+    }
+
+    QBrush const brush = painter->brush();
+    painter->setBrush(QBrush());
+    painter->drawPath(path);
+    painter->setBrush(brush);
+}
+
+void LC_GlyphRun::calculateBorders() {
+    resetBorders();
+    for (const Placement& p: placements) {
+        adjustBorders(p);
+    }
+}
+
+void LC_GlyphRun::adjustBorders(const Placement& p) {
+    const QPainterPath& strokes = p.glyph->strokes;
+    for (int i = 0; i < strokes.elementCount(); ++i) {
+        RS_Vector const v = toDrawing(p, strokes.elementAt(i));
+        minV = RS_Vector::minimum(minV, v);
+        maxV = RS_Vector::maximum(maxV, v);
+    }
+}
+
+/**
+ * Dumps the glyph run to stdout.
+ */
+std::ostream& operator << (std::ostream& os, const LC_GlyphRun& r) {
+    os << " GlyphRun: " << r.getPlacements().size() << " letters\n";
+    return os;
+}
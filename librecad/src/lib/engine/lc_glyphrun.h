@@ -0,0 +1,128 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2018 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+
+#ifndef LC_GLYPHRUN_H
+#define LC_GLYPHRUN_H
+
+#include <vector>
+#include "rs_atomicentity.h"
+#include "rs_font.h"
+
+class RS_Line;
+
+/** \brief The letters of a text as references to the glyphs of their font
+ *
+ * Texts keep their letters in a glyph run instead of creating an insert
+ * with a copy of the font entities for every letter. A letter is only a
+ * glyph of the font and the placement of the glyph, all letters of the
+ * run are drawn as one path. Letter inserts are still created by the
+ * texts when the letters are needed as entities, e.g. for exploding.
+ */
+class LC_GlyphRun : public RS_AtomicEntity
+{
+public:
+    /**
+     * A glyph in the drawing: the point (x, y) of the glyph, relative to
+     * its base point, is at position + x * xAxis + y * yAxis.
+     */
+    struct Placement {
+        const RS_Font::Glyph* glyph;
+        RS_Vector position;
+        RS_Vector xAxis;
+        RS_Vector yAxis;
+    };
+
+    LC_GlyphRun(RS_EntityContainer* parent);
+
+    RS_Entity* clone() const override;
+
+    /** @return RS2::EntityGlyphRun */
+    RS2::EntityType rtti() const override {
+        return RS2::EntityGlyphRun;
+    }
+
+    /**
+     * Adds a letter, placed like an insert of the letter block.
+     *
+     * @param position Position of the base point of the glyph
+     * @param factor Scale factor in x and y of the glyph
+     * @param angle Rotation angle of the glyph
+     */
+    void append(const RS_Font::Glyph* glyph, const RS_Vector& position,
+                const RS_Vector& factor, double angle);
+
+    bool isEmpty() const {
+        return placements.empty();
+    }
+
+    const std::vector<Placement>& getPlacements() const {
+        return placements;
+    }
+
+    /** @return the strokes of all letters as lines */
+    std::vector<RS_Line> getStrokes() const;
+
+    /** @return true if any stroke has a point inside the window */
+    bool isInCrossWindow(const RS_Vector& v1, const RS_Vector& v2) const;
+
+    RS_Vector getNearestEndpoint(const RS_Vector& coord,
+                                 double* dist = nullptr) const override;
+    RS_Vector getNearestPointOnEntity(const RS_Vector& coord,
+                                      bool onEntity = true, double* dist = nullptr,
+                                      RS_Entity** entity = nullptr) const override;
+    RS_Vector getNearestCenter(const RS_Vector& coord,
+                               double* dist = nullptr) const override;
+    RS_Vector getNearestMiddle(const RS_Vector& coord,
+                               double* dist = nullptr,
+                               int middlePoints = 1) const override;
+    RS_Vector getNearestDist(double distance,
+                             const RS_Vector& coord,
+                             double* dist = nullptr) const override;
+    double getDistanceToPoint(const RS_Vector& coord,
+                              RS_Entity** entity = nullptr,
+                              RS2::ResolveLevel level = RS2::ResolveNone,
+                              double solidDist = RS_MAXDOUBLE) const override;
+
+    void move(const RS_Vector& offset) override;
+    void rotate(const RS_Vector& center, const double& angle) override;
+    void rotate(const RS_Vector& center, const RS_Vector& angleVector) override;
+    void scale(const RS_Vector& center, const RS_Vector& factor) override;
+    void mirror(const RS_Vector& axisPoint1, const RS_Vector& axisPoint2) override;
+
+    void draw(RS_Painter* painter, RS_GraphicView* view, double& patternOffset) override;
+
+    void calculateBorders() override;
+
+    friend std::ostream& operator << (std::ostream& os, const LC_GlyphRun& r);
+
+private:
+    //! extends the borders by the strokes of a placed glyph
+    void adjustBorders(const Placement& p);
+
+    std::vector<Placement> placements;
+};
+
+#endif
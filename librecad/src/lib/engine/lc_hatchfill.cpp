@@ -0,0 +1,836 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2018 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "lc_hatchfill.h"
+#include "lc_splinepoints.h"
+#include "rs_arc.h"
+#include "rs_circle.h"
+#include "rs_ellipse.h"
+#include "rs_entitycontainer.h"
+#include "rs_line.h"
+#include "rs_math.h"
+
+namespace {
+//! lattice vectors along pattern lines are searched up to this multiple of the tile
+constexpr long maxLatticeFactor = 64;
+
+//! upper limit of segments for one curved boundary edge
+constexpr size_t maxCurveSegments = 4096;
+
+constexpr size_t maxBands = 1024;
+
+typedef std::vector<std::pair<double, double>> Runs;
+
+Runs mergeRuns(Runs runs, double eps)
+{
+    std::sort(runs.begin(), runs.end());
+    Runs merged;
+    for (const auto& run: runs) {
+        if (!merged.empty() && run.first <= merged.back().second + eps) {
+            merged.back().second = std::max(merged.back().second, run.second);
+        } else {
+            merged.push_back(run);
+        }
+    }
+    return merged;
+}
+
+//! solves p * x + q * y = g, g is the greatest common divisor up to its sign
+long extendedGcd(long p, long q, long& x, long& y)
+{
+    if (q == 0) {
+        x = 1;
+        y = 0;
+        return p;
+    }
+    long x1 = 0, y1 = 0;
+    long const g = extendedGcd(q, p % q, x1, y1);
+    x = y1;
+    y = x1 - (p / q) * y1;
+    return g;
+}
+
+//! number of segments to approximate an arc within tolerance
+size_t curveSegments(double radius, double angleLength, double tolerance)
+{
+    if (radius <= tolerance) {
+        return 1;
+    }
+    double const step = 2. * std::acos(1. - tolerance / radius);
+    double const n = std::ceil(std::fabs(angleLength) / step);
+    return static_cast<size_t>(std::max(1., std::min(n, double(maxCurveSegments))));
+}
+}
+
+LC_HatchFill::LC_HatchFill(const RS_EntityContainer& loops, double tolerance):
+    tolerance(tolerance)
+{
+    double const inf = std::numeric_limits<double>::infinity();
+    vMin = RS_Vector(inf, inf);
+    vMax = RS_Vector(-inf, -inf);
+    for (RS_Entity const* loop: loops) {
+        if (loop->rtti() == RS2::EntityContainer && !loop->getFlag(RS2::FlagTemp)) {
+            for (RS_Entity const* e: *static_cast<RS_EntityContainer const*>(loop)) {
+                addLoopEntity(e);
+            }
+        }
+    }
+}
+
+void LC_HatchFill::setWindow(const RS_Vector& v1, const RS_Vector& v2)
+{
+    windowMin = RS_Vector::minimum(v1, v2);
+    windowMax = RS_Vector::maximum(v1, v2);
+}
+
+void LC_HatchFill::addEdge(const RS_Vector& a, const RS_Vector& b)
+{
+    if (!a.valid || !b.valid || a.squaredTo(b) < RS_TOLERANCE * RS_TOLERANCE) {
+        return;
+    }
+    edges.push_back({a, b});
+    vMin = RS_Vector::minimum(vMin, RS_Vector::minimum(a, b));
+    vMax = RS_Vector::maximum(vMax, RS_Vector::maximum(a, b));
+}
+
+/**
+ * Adds the edges of a polygon approximating a boundary entity. Curves
+ * keep their exact end points, so the polygon stays closed.
+ */
+void LC_HatchFill::addLoopEntity(RS_Entity const* e)
+{
+    switch (e->rtti()) {
+    case RS2::EntityLine:
+        addEdge(e->getStartpoint(), e->getEndpoint());
+        break;
+    case RS2::EntityArc:
+    case RS2::EntityCircle: {
+        bool const circle = e->rtti() == RS2::EntityCircle;
+        auto arc = static_cast<RS_Arc const*>(e);
+        RS_Vector const center = circle ? e->getCenter() : arc->getCenter();
+        double const radius = circle ? static_cast<RS_Circle const*>(e)->getRadius()
+                                     : arc->getRadius();
+        double const angle1 = circle ? 0. : arc->getAngle1();
+        double sweep = circle ? 2. * M_PI : arc->getAngleLength();
+        if (!circle && arc->isReversed()) {
+            sweep = -sweep;
+        }
+        size_t n = curveSegments(radius, sweep, tolerance);
+        if (circle) {
+            n = std::max<size_t>(n, 3);
+        }
+        RS_Vector const start = circle ? center + RS_Vector(radius, 0.)
+                                       : arc->getStartpoint();
+        RS_Vector const end = circle ? start : arc->getEndpoint();
+        RS_Vector previous = start;
+        for (size_t i = 1; i < n; ++i) {
+            RS_Vector const p = center + RS_Vector(angle1 + sweep * i / n) * radius;
+            addEdge(previous, p);
+            previous = p;
+        }
+        addEdge(previous, end);
+        break;
+    }
+    case RS2::EntityEllipse: {
+        auto ellipse = static_cast<RS_Ellipse const*>(e);
+        bool const arc = ellipse->isEllipticArc();
+        double const angle1 = arc ? ellipse->getAngle1() : 0.;
+        double sweep = arc ? ellipse->getAngleLength() : 2. * M_PI;
+        if (arc && ellipse->isReversed()) {
+            sweep = -sweep;
+        }
+        size_t const n = std::max<size_t>(arc ? 1 : 3,
+                curveSegments(ellipse->getMajorRadius(), sweep, tolerance));
+        RS_Vector const start = arc ? ellipse->getStartpoint()
+                                    : ellipse->getEllipsePoint(angle1);
+        RS_Vector const end = arc ? ellipse->getEndpoint() : start;
+        RS_Vector previous = start;
+        for (size_t i = 1; i < n; ++i) {
+            RS_Vector const p = ellipse->getEllipsePoint(angle1 + sweep * i / n);
+            addEdge(previous, p);
+            previous = p;
+        }
+        addEdge(previous, end);
+        break;
+    }
+    case RS2::EntitySplinePoints: {
+        auto spline = static_cast<LC_SplinePoints const*>(e);
+        std::vector<RS_Vector> const points = spline->getStrokePoints();
+        for (size_t i = 1; i < points.size(); ++i) {
+            addEdge(points[i - 1], points[i]);
+        }
+        if (spline->isClosed() && points.size() > 2) {
+            addEdge(points.back(), points.front());
+        }
+        break;
+    }
+    default:
+        if (e->isContainer()) {
+            for (RS_Entity const* child: *static_cast<RS_EntityContainer const*>(e)) {
+                addLoopEntity(child);
+            }
+        } else {
+            addEdge(e->getStartpoint(), e->getEndpoint());
+        }
+        break;
+    }
+}
+
+bool LC_HatchFill::fill(const RS_EntityContainer& pattern,
+                        const RS_Vector& dvx, const RS_Vector& dvy,
+                        RS_EntityContainer* target, size_t maxCount)
+{
+    this->dvx = dvx;
+    this->dvy = dvy;
+    this->maxCount = maxCount;
+    overflow = false;
+    created.clear();
+    boxMin = vMin;
+    boxMax = vMax;
+    if (windowMin.valid) {
+        boxMin = RS_Vector::maximum(boxMin, windowMin);
+        boxMax = RS_Vector::minimum(boxMax, windowMax);
+    }
+    if (edges.empty() || boxMin.x > boxMax.x || boxMin.y > boxMax.y) {
+        return true;
+    }
+
+    std::vector<PatternLine> lines;
+    std::vector<RS_Entity const*> curves;
+    for (RS_Entity const* e: pattern) {
+        switch (e->rtti()) {
+        case RS2::EntityLine: {
+            PatternLine line{e->getStartpoint(), e->getEndpoint() - e->getStartpoint(), 0., 0.};
+            line.length = line.direction.magnitude();
+            if (line.length < RS_TOLERANCE) {
+                break;
+            }
+            line.direction /= line.length;
+            line.angle = line.direction.angle();
+            // lines in opposite directions belong to the same family
+            if (line.angle >= M_PI - RS_TOLERANCE_ANGLE) {
+                line.start = e->getEndpoint();
+                line.direction = -line.direction;
+                line.angle -= M_PI;
+            }
+            lines.push_back(line);
+            break;
+        }
+        case RS2::EntityArc:
+        case RS2::EntityCircle:
+            curves.push_back(e);
+            break;
+        default:
+            break;
+        }
+    }
+
+    std::sort(lines.begin(), lines.end(), [](const PatternLine& a, const PatternLine& b) {
+        return a.angle < b.angle;
+    });
+    for (size_t first = 0; first < lines.size() && !overflow;) {
+        size_t last = first + 1;
+        while (last < lines.size()
+               && lines[last].angle - lines[first].angle <= RS_TOLERANCE_ANGLE) {
+            ++last;
+        }
+        addLines(std::vector<PatternLine>(lines.begin() + first, lines.begin() + last));
+        first = last;
+    }
+
+    if (!curves.empty() && !overflow) {
+        buildBands();
+        for (RS_Entity const* e: curves) {
+            if (!addCurve(e)) {
+                break;
+            }
+        }
+    }
+
+    if (overflow) {
+        for (RS_Entity* e: created) {
+            delete e;
+        }
+        created.clear();
+        return false;
+    }
+    for (RS_Entity* e: created) {
+        e->reparent(target);
+        target->addEntity(e);
+    }
+    created.clear();
+    return true;
+}
+
+/**
+ * Fills the boundary with pattern lines of one direction.
+ *
+ * If a short lattice vector v points along the lines, every line of the
+ * pattern is repeated along v, and with a second lattice vector w both
+ * span the lattice: the copies of a pattern line lie on parallel lines
+ * with the distance s = n * w. Pattern lines whose distances only differ
+ * by multiples of s share these lines and are combined to one family,
+ * the runs of a family repeat with the period T = d * v along each line.
+ */
+bool LC_HatchFill::addLines(const std::vector<PatternLine>& lines)
+{
+    RS_Vector const d = lines.front().direction;
+    RS_Vector const n(-d.y, d.x);
+
+    double cMin = std::numeric_limits<double>::infinity();
+    double cMax = -cMin;
+    for (const Edge& edge: edges) {
+        double const ca = n.dotP(edge.a);
+        double const cb = n.dotP(edge.b);
+        cMin = std::min(cMin, std::min(ca, cb));
+        cMax = std::max(cMax, std::max(ca, cb));
+    }
+    if (windowMin.valid) {
+        double const c1 = n.dotP(windowMin);
+        double const c2 = n.dotP(windowMax);
+        double const c3 = n.dotP(RS_Vector(windowMin.x, windowMax.y));
+        double const c4 = n.dotP(RS_Vector(windowMax.x, windowMin.y));
+        cMin = std::max(cMin, std::min(std::min(c1, c2), std::min(c3, c4)));
+        cMax = std::min(cMax, std::max(std::max(c1, c2), std::max(c3, c4)));
+    }
+    double const extent = (vMax - vMin).magnitude();
+
+    // shortest lattice vector along the lines, the perpendicular drift of
+    // its multiples over the whole boundary must stay within tolerance
+    double const a = n.dotP(dvx);
+    double const b = n.dotP(dvy);
+    long p = 0, q = 0;
+    double period = std::numeric_limits<double>::infinity();
+    for (long i = -maxLatticeFactor; i <= maxLatticeFactor; ++i) {
+        for (long j = 0; j <= maxLatticeFactor; ++j) {
+            long x = 0, y = 0;
+            if (std::abs(extendedGcd(std::abs(i), j, x, y)) != 1) {
+                continue;
+            }
+            double const t = std::fabs(d.dotP(dvx * i + dvy * j));
+            if (t > RS_TOLERANCE && t < period
+                    && std::fabs(i * a + j * b) * extent <= tolerance * t) {
+                p = i;
+                q = j;
+                period = t;
+            }
+        }
+    }
+
+    std::vector<Family> families;
+    std::vector<Job> jobs;
+
+    RS_Vector v = dvx * p + dvy * q;
+    RS_Vector w(false);
+    double s = 0.;
+    if (p != 0 || q != 0) {
+        if (d.dotP(v) < 0.) {
+            p = -p;
+            q = -q;
+            v = -v;
+        }
+        // second basis vector: p * u - q * r = 1
+        long x = 0, y = 0;
+        long const g = extendedGcd(p, q, x, y);
+        long const u = x / g;
+        long const r = -y / g;
+        w = dvx * r + dvy * u;
+        s = n.dotP(w);
+        if (s < 0.) {
+            w = -w;
+            s = -s;
+        }
+    }
+
+    if (s <= RS_TOLERANCE) {
+        // the lines are not repeated along their direction, every copy is placed alone
+        for (const PatternLine& line: lines) {
+            if (!addTiledLine(line, families, jobs)) {
+                return false;
+            }
+        }
+        sweep(d, families, jobs);
+        return !overflow;
+    }
+
+    double const dw = d.dotP(w);
+    // sort pattern lines by their distance modulo s
+    std::vector<std::pair<double, size_t>> remainders;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        double const c = n.dotP(lines[i].start);
+        remainders.emplace_back(c - s * std::floor(c / s), i);
+    }
+    std::sort(remainders.begin(), remainders.end());
+
+    std::vector<std::vector<size_t>> groups;
+    double groupStart = 0.;
+    for (const auto& remainder: remainders) {
+        if (groups.empty() || remainder.first - groupStart > 0.1 * tolerance) {
+            groups.emplace_back();
+            groupStart = remainder.first;
+        }
+        groups.back().push_back(remainder.second);
+    }
+    if (groups.size() > 1 && remainders.front().first + s - groupStart <= 0.1 * tolerance) {
+        groups.front().insert(groups.front().end(), groups.back().begin(), groups.back().end());
+        groups.pop_back();
+    }
+
+    double carriers = 0.;
+    for (const std::vector<size_t>& group: groups) {
+        double const cRef = n.dotP(lines[group.front()].start);
+        Family family{Runs{}, period, true, false};
+        for (size_t i: group) {
+            const PatternLine& line = lines[i];
+            double const k = std::round((n.dotP(line.start) - cRef) / s);
+            double const alpha = d.dotP(line.start) - k * dw;
+            double const start = alpha - period * std::floor(alpha / period);
+            family.runs.emplace_back(start, start + line.length);
+            family.full = family.full || line.length >= period - tolerance;
+        }
+        family.runs = mergeRuns(family.runs, tolerance);
+
+        // the runs cover the whole line, if their periodic union has no gap
+        Runs repeated;
+        for (const auto& run: family.runs) {
+            for (int shift = -1; shift <= 1; ++shift) {
+                repeated.emplace_back(run.first + shift * period, run.second + shift * period);
+            }
+        }
+        for (const auto& run: mergeRuns(repeated, tolerance)) {
+            family.full = family.full || run.second - run.first >= period - tolerance;
+        }
+
+        double const kMin = std::ceil((cMin - cRef) / s);
+        double const kMax = std::floor((cMax - cRef) / s);
+        if (kMax < kMin) {
+            continue;
+        }
+        carriers += kMax - kMin + 1.;
+        if (carriers > maxCount) {
+            overflow = true;
+            return false;
+        }
+        families.push_back(family);
+        for (double k = kMin; k <= kMax; ++k) {
+            jobs.push_back({cRef + k * s, k * dw, families.size() - 1});
+        }
+    }
+
+    sweep(d, families, jobs);
+    return !overflow;
+}
+
+/**
+ * Adds one job for every copy of line which may cross the boundary.
+ */
+bool LC_HatchFill::addTiledLine(const PatternLine& line, std::vector<Family>& families,
+                                std::vector<Job>& jobs)
+{
+    RS_Vector const end = line.start + line.direction * line.length;
+    RS_Vector const lower = RS_Vector::minimum(line.start, end);
+    RS_Vector const upper = RS_Vector::maximum(line.start, end);
+    long i0 = 0, i1 = 0, j0 = 0, j1 = 0;
+    if (jobs.size() + tileRange(boxMin - upper, boxMax - lower, i0, i1, j0, j1) > maxCount) {
+        overflow = true;
+        return false;
+    }
+
+    RS_Vector const n(-line.direction.y, line.direction.x);
+    families.push_back({Runs{{0., line.length}}, 0., false, false});
+    for (long i = i0; i <= i1; ++i) {
+        for (long j = j0; j <= j1; ++j) {
+            RS_Vector const offset = dvx * i + dvy * j;
+            if (lower.x + offset.x > boxMax.x || upper.x + offset.x < boxMin.x
+                    || lower.y + offset.y > boxMax.y || upper.y + offset.y < boxMin.y) {
+                continue;
+            }
+            RS_Vector const start = line.start + offset;
+            jobs.push_back({n.dotP(start), line.direction.dotP(start), families.size() - 1});
+        }
+    }
+    return true;
+}
+
+/**
+ * Intersects the lines of all jobs with the boundary. The jobs are
+ * processed by ascending distance, edges enter the active edge table
+ * when the lines reach them and leave it when the lines have passed.
+ */
+void LC_HatchFill::sweep(const RS_Vector& direction, const std::vector<Family>& families,
+                         std::vector<Job>& jobs)
+{
+    RS_Vector const& d = direction;
+    RS_Vector const n(-d.y, d.x);
+
+    struct Projected {
+        double na;
+        double nb;
+        double da;
+        double db;
+    };
+    std::vector<Projected> projected;
+    projected.reserve(edges.size());
+    for (const Edge& edge: edges) {
+        projected.push_back({n.dotP(edge.a), n.dotP(edge.b), d.dotP(edge.a), d.dotP(edge.b)});
+    }
+    std::vector<size_t> order(edges.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&projected](size_t a, size_t b) {
+        return std::min(projected[a].na, projected[a].nb)
+                < std::min(projected[b].na, projected[b].nb);
+    });
+    std::sort(jobs.begin(), jobs.end(), [](const Job& a, const Job& b) {
+        return a.c < b.c;
+    });
+
+    std::vector<size_t> active;
+    std::vector<double> crossings;
+    size_t next = 0;
+    for (const Job& job: jobs) {
+        while (next < order.size()
+               && std::min(projected[order[next]].na, projected[order[next]].nb) <= job.c) {
+            active.push_back(order[next++]);
+        }
+
+        crossings.clear();
+        for (size_t i = 0; i < active.size();) {
+            const Projected& edge = projected[active[i]];
+            double const sa = edge.na - job.c;
+            double const sb = edge.nb - job.c;
+            if (sa < 0. && sb < 0.) {
+                // passed, later lines are farther away
+                active[i] = active.back();
+                active.pop_back();
+                continue;
+            }
+            // half open, so a line through a vertex counts one of its edges
+            if ((sa >= 0.) != (sb >= 0.)) {
+                crossings.push_back(edge.da + (edge.db - edge.da) * sa / (sa - sb));
+            }
+            ++i;
+        }
+
+        std::sort(crossings.begin(), crossings.end());
+        double t0 = -std::numeric_limits<double>::infinity();
+        double t1 = -t0;
+        if (windowMin.valid) {
+            clipToWindow(d, n, job.c, t0, t1);
+        }
+        for (size_t i = 0; i + 1 < crossings.size(); i += 2) {
+            double const a = std::max(t0, crossings[i]);
+            double const b = std::min(t1, crossings[i + 1]);
+            if (a < b) {
+                addPieces(d, n, families[job.family], job, a, b);
+            }
+            if (overflow) {
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * Adds the runs of a family within [t0, t1] of the line of job, runs
+ * which touch are joined.
+ */
+void LC_HatchFill::addPieces(const RS_Vector& d, const RS_Vector& n, const Family& family,
+                             const Job& job, double t0, double t1)
+{
+    RS_Vector const base = n * job.c;
+    if (family.full) {
+        addSegment(base + d * t0, base + d * t1);
+        return;
+    }
+
+    long first = 0;
+    long last = 0;
+    if (family.periodic) {
+        first = static_cast<long>(std::floor((t0 - job.offset) / family.period)) - 2;
+        last = static_cast<long>(std::floor((t1 - job.offset) / family.period));
+    }
+
+    bool pending = false;
+    double pendingStart = 0.;
+    double pendingEnd = 0.;
+    for (long k = first; k <= last; ++k) {
+        double const shift = job.offset + k * family.period;
+        for (const auto& run: family.runs) {
+            double const a = std::max(t0, shift + run.first);
+            double const b = std::min(t1, shift + run.second);
+            if (b - a <= RS_TOLERANCE) {
+                continue;
+            }
+            if (pending && a <= pendingEnd + tolerance) {
+                pendingEnd = std::max(pendingEnd, b);
+                continue;
+            }
+            if (pending) {
+                addSegment(base + d * pendingStart, base + d * pendingEnd);
+            }
+            pending = true;
+            pendingStart = a;
+            pendingEnd = b;
+        }
+        if (overflow) {
+            return;
+        }
+    }
+    if (pending) {
+        addSegment(base + d * pendingStart, base + d * pendingEnd);
+    }
+}
+
+void LC_HatchFill::addSegment(const RS_Vector& p0, const RS_Vector& p1)
+{
+    if (overflow) {
+        return;
+    }
+    if (created.size() >= maxCount) {
+        overflow = true;
+        return;
+    }
+    created.push_back(new RS_Line{nullptr, p0, p1});
+}
+
+/**
+ * Places every copy of a pattern arc or circle which may overlap the
+ * boundary, splits it at the boundary and keeps the inside pieces.
+ */
+bool LC_HatchFill::addCurve(RS_Entity const* e)
+{
+    bool const circle = e->rtti() == RS2::EntityCircle;
+    RS_Vector const center = e->getCenter();
+    double radius = 0.;
+    double angle1 = 0.;
+    double angleLength = 2. * M_PI;
+    if (circle) {
+        radius = static_cast<RS_Circle const*>(e)->getRadius();
+    } else {
+        auto arc = static_cast<RS_Arc const*>(e);
+        radius = arc->getRadius();
+        angle1 = arc->isReversed() ? arc->getAngle2() : arc->getAngle1();
+        angleLength = arc->getAngleLength();
+    }
+    if (radius < RS_TOLERANCE) {
+        return true;
+    }
+
+    RS_Vector const r(radius, radius);
+    long i0 = 0, i1 = 0, j0 = 0, j1 = 0;
+    double const tiles = tileRange(boxMin - center - r, boxMax - center + r, i0, i1, j0, j1);
+    if (created.size() + tiles > maxCount) {
+        overflow = true;
+        return false;
+    }
+
+    std::vector<double> cuts;
+    auto addArc = [&](const RS_Vector& c, double a, double b) {
+        if (b - a < RS_TOLERANCE_ANGLE || overflow) {
+            return;
+        }
+        if (created.size() >= maxCount) {
+            overflow = true;
+        } else if (circle && b - a >= 2. * M_PI - RS_TOLERANCE_ANGLE) {
+            created.push_back(new RS_Circle(nullptr, RS_CircleData(c, radius)));
+        } else {
+            created.push_back(new RS_Arc(nullptr, RS_ArcData(c, radius, angle1 + a,
+                                                             angle1 + b, false)));
+        }
+    };
+
+    for (long i = i0; i <= i1 && !overflow; ++i) {
+        for (long j = j0; j <= j1 && !overflow; ++j) {
+            RS_Vector const c = center + dvx * i + dvy * j;
+            if (c.x - radius > boxMax.x || c.x + radius < boxMin.x
+                    || c.y - radius > boxMax.y || c.y + radius < boxMin.y) {
+                continue;
+            }
+
+            // angles of the intersections relative to the start angle
+            cuts.clear();
+            size_t const b0 = bandOf(c.y - radius);
+            size_t const b1 = bandOf(c.y + radius);
+            for (size_t band = b0; band <= b1; ++band) {
+                for (size_t index: bands[band]) {
+                    const Edge& edge = edges[index];
+                    // visit edges in several bands only once
+                    if (std::max(bandOf(std::min(edge.a.y, edge.b.y)), b0) != band) {
+                        continue;
+                    }
+                    RS_Vector const dir = edge.b - edge.a;
+                    RS_Vector const f = edge.a - c;
+                    double const qa = dir.squared();
+                    double const qb = 2. * f.dotP(dir);
+                    double const qc = f.squared() - radius * radius;
+                    double const disc = qb * qb - 4. * qa * qc;
+                    if (disc < 0.) {
+                        continue;
+                    }
+                    double const root = std::sqrt(disc);
+                    for (double u: {(-qb - root) / (2. * qa), (-qb + root) / (2. * qa)}) {
+                        if (u < 0. || u > 1.) {
+                            continue;
+                        }
+                        double const angle = RS_Math::correctAngle(
+                                    (f + dir * u).angle() - angle1);
+                        if (angle > RS_TOLERANCE_ANGLE
+                                && angle < angleLength - RS_TOLERANCE_ANGLE) {
+                            cuts.push_back(angle);
+                        }
+                    }
+                }
+            }
+            cuts.push_back(0.);
+            cuts.push_back(angleLength);
+            std::sort(cuts.begin(), cuts.end());
+
+            bool inside = false;
+            double runStart = 0.;
+            for (size_t k = 0; k + 1 < cuts.size(); ++k) {
+                if (cuts[k + 1] - cuts[k] < RS_TOLERANCE_ANGLE) {
+                    continue;
+                }
+                double const middle = 0.5 * (cuts[k] + cuts[k + 1]);
+                bool const in = isInside(c + RS_Vector(angle1 + middle) * radius);
+                if (in && !inside) {
+                    runStart = cuts[k];
+                } else if (!in && inside) {
+                    addArc(c, runStart, cuts[k]);
+                }
+                inside = in;
+            }
+            if (inside) {
+                addArc(c, runStart, angleLength);
+            }
+        }
+    }
+    return !overflow;
+}
+
+/**
+ * Even-odd test with a ray in positive x direction.
+ */
+bool LC_HatchFill::isInside(const RS_Vector& p) const
+{
+    if (p.y < vMin.y || p.y > vMax.y || p.x < vMin.x || p.x > vMax.x) {
+        return false;
+    }
+    bool inside = false;
+    for (size_t index: bands[bandOf(p.y)]) {
+        const Edge& edge = edges[index];
+        if ((edge.a.y > p.y) != (edge.b.y > p.y)) {
+            double const x = edge.a.x + (p.y - edge.a.y) * (edge.b.x - edge.a.x)
+                    / (edge.b.y - edge.a.y);
+            if (x > p.x) {
+                inside = !inside;
+            }
+        }
+    }
+    return inside;
+}
+
+void LC_HatchFill::clipToWindow(const RS_Vector& d, const RS_Vector& n, double c,
+                                double& t0, double& t1) const
+{
+    // the line runs through n * c + d * t
+    for (int axis = 0; axis < 2; ++axis) {
+        double const dir = axis ? d.y : d.x;
+        double const base = axis ? n.y * c : n.x * c;
+        double const low = axis ? windowMin.y : windowMin.x;
+        double const high = axis ? windowMax.y : windowMax.x;
+        if (std::fabs(dir) < RS_TOLERANCE) {
+            if (base < low || base > high) {
+                t1 = t0;
+                return;
+            }
+            continue;
+        }
+        double const a = (low - base) / dir;
+        double const b = (high - base) / dir;
+        t0 = std::max(t0, std::min(a, b));
+        t1 = std::min(t1, std::max(a, b));
+    }
+}
+
+double LC_HatchFill::tileRange(const RS_Vector& lower, const RS_Vector& upper,
+                               long& i0, long& i1, long& j0, long& j1) const
+{
+    double const det = dvx.x * dvy.y - dvx.y * dvy.x;
+    if (std::fabs(det) < RS_TOLERANCE * RS_TOLERANCE) {
+        return std::numeric_limits<double>::infinity();
+    }
+    double const inf = std::numeric_limits<double>::infinity();
+    double iMin = inf, iMax = -inf, jMin = inf, jMax = -inf;
+    for (const RS_Vector& k: {lower, upper, RS_Vector(lower.x, upper.y),
+                              RS_Vector(upper.x, lower.y)}) {
+        double const i = (k.x * dvy.y - k.y * dvy.x) / det;
+        double const j = (dvx.x * k.y - dvx.y * k.x) / det;
+        iMin = std::min(iMin, i);
+        iMax = std::max(iMax, i);
+        jMin = std::min(jMin, j);
+        jMax = std::max(jMax, j);
+    }
+    double const count = (std::ceil(iMax) - std::floor(iMin) + 1.)
+            * (std::ceil(jMax) - std::floor(jMin) + 1.);
+    // the caller gives up on too many tiles, avoid overflowing the indices
+    if (!(count < 1e15)) {
+        return inf;
+    }
+    i0 = static_cast<long>(std::floor(iMin));
+    i1 = static_cast<long>(std::ceil(iMax));
+    j0 = static_cast<long>(std::floor(jMin));
+    j1 = static_cast<long>(std::ceil(jMax));
+    return count;
+}
+
+void LC_HatchFill::buildBands()
+{
+    size_t const count = std::max<size_t>(1, std::min(edges.size(), maxBands));
+    bandHeight = (vMax.y - vMin.y) / count;
+    bands.assign(count, std::vector<size_t>());
+    for (size_t i = 0; i < edges.size(); ++i) {
+        size_t const first = bandOf(std::min(edges[i].a.y, edges[i].b.y));
+        size_t const last = bandOf(std::max(edges[i].a.y, edges[i].b.y));
+        for (size_t band = first; band <= last; ++band) {
+            bands[band].push_back(i);
+        }
+    }
+}
+
+size_t LC_HatchFill::bandOf(double y) const
+{
+    if (!(bandHeight > 0.) || y <= vMin.y) {
+        return 0;
+    }
+    double const band = std::floor((y - vMin.y) / bandHeight);
+    return static_cast<size_t>(std::min(band, double(bands.size() - 1)));
+}
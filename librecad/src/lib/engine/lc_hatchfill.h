@@ -0,0 +1,152 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2018 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+
+#ifndef LC_HATCHFILL_H
+#define LC_HATCHFILL_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "rs_vector.h"
+
+class RS_Entity;
+class RS_EntityContainer;
+
+/** \brief Clips a hatch pattern to the loops of a hatch
+ *
+ * The loops are approximated by a polygon, curved edges deviate at most
+ * by the given tolerance. Pattern lines are not cloned tile by tile:
+ * lines of the same direction which are repeated by the pattern lattice
+ * lie on a family of parallel lines. Each line of a family crossing the
+ * boundary is intersected once with the polygon edges, which are kept in
+ * an active edge table while the lines are swept across the boundary.
+ * The inside intervals (even-odd rule) are then filled with the runs of
+ * pattern lines, collinear runs which touch are merged. The work is
+ * proportional to the size of the boundary and to the number of
+ * segments created, independent of the number of tiles.
+ *
+ * Lines which are not repeated along their direction by the lattice,
+ * and arcs and circles of the pattern are placed tile by tile.
+ */
+class LC_HatchFill
+{
+public:
+    /**
+     * @param loops hatch or container whose child containers are the loops
+     * @param tolerance maximum distance of the polygon from curved edges
+     */
+    LC_HatchFill(const RS_EntityContainer& loops, double tolerance);
+
+    /**
+     * @brief setWindow restrict the fill to a window, pattern lines are cut
+     * at its border, arcs and circles overlapping it are kept whole
+     */
+    void setWindow(const RS_Vector& v1, const RS_Vector& v2);
+
+    /**
+     * @brief fill add the pattern, clipped to the loops, to target
+     * @param pattern entities of the tile at the lattice origin, the tile
+     * is repeated by all integer combinations of dvx and dvy
+     * @param maxCount maximum number of entities to create
+     * @return false, if more entities would be needed, target is not
+     * changed in this case
+     */
+    bool fill(const RS_EntityContainer& pattern,
+              const RS_Vector& dvx, const RS_Vector& dvy,
+              RS_EntityContainer* target, size_t maxCount);
+
+private:
+    struct Edge {
+        RS_Vector a;
+        RS_Vector b;
+    };
+    struct PatternLine {
+        RS_Vector start;
+        RS_Vector direction;
+        double length;
+        double angle;
+    };
+    /**
+     * Segments along a line: the runs, repeated with the period if the
+     * family is periodic. A full family covers the whole line.
+     */
+    struct Family {
+        std::vector<std::pair<double, double>> runs;
+        double period;
+        bool periodic;
+        bool full;
+    };
+    //! a line of a family at distance c from the origin, the runs are shifted by offset
+    struct Job {
+        double c;
+        double offset;
+        size_t family;
+    };
+
+    void addEdge(const RS_Vector& a, const RS_Vector& b);
+    void addLoopEntity(RS_Entity const* e);
+    bool addLines(const std::vector<PatternLine>& lines);
+    bool addTiledLine(const PatternLine& line, std::vector<Family>& families,
+                      std::vector<Job>& jobs);
+    void sweep(const RS_Vector& direction, const std::vector<Family>& families,
+               std::vector<Job>& jobs);
+    void addPieces(const RS_Vector& d, const RS_Vector& n, const Family& family,
+                   const Job& job, double t0, double t1);
+    void addSegment(const RS_Vector& p0, const RS_Vector& p1);
+    bool addCurve(RS_Entity const* e);
+    bool isInside(const RS_Vector& p) const;
+    //! range of t where the line at distance c runs within the window
+    void clipToWindow(const RS_Vector& d, const RS_Vector& n, double c,
+                      double& t0, double& t1) const;
+    //! number of tiles whose box lies within the given distances of the box to fill
+    double tileRange(const RS_Vector& lower, const RS_Vector& upper,
+                     long& i0, long& i1, long& j0, long& j1) const;
+    void buildBands();
+    size_t bandOf(double y) const;
+
+    std::vector<Edge> edges;
+    RS_Vector vMin;
+    RS_Vector vMax;
+    double tolerance;
+    RS_Vector windowMin{false};
+    RS_Vector windowMax{false};
+
+    // per fill()
+    RS_Vector dvx;
+    RS_Vector dvy;
+    //! boundary box, within the window if there is one
+    RS_Vector boxMin;
+    RS_Vector boxMax;
+    std::vector<RS_Entity*> created;
+    size_t maxCount = 0;
+    bool overflow = false;
+
+    //! edges by horizontal bands, for point tests and curves of the pattern
+    std::vector<std::vector<size_t>> bands;
+    double bandHeight = 0.;
+};
+
+#endif // LC_HATCHFILL_H
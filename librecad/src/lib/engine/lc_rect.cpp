@@ -21,8 +21,10 @@ along with this program; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 **********************************************************************/
 #include<iostream>
+#include <algorithm>
 #include <QDebug>
 #include <cassert>
+#include <limits>
 #include "lc_rect.h"
 
 #define INTERT_TEST(s) qDebug()<<"\ntesting " #s; \
@@ -275,6 +277,41 @@ Area(coord, {coord.x + width, coord.y + height})
 					upperRightCorner(), upperLeftCorner()}};
 	}
 
+	bool LC_Rect::clipLine(Coordinate& p1, Coordinate& p2, bool infinite) const
+	{
+		Coordinate const d = p2 - p1;
+		if (infinite && d.x == 0. && d.y == 0.)
+			return inArea(p1);
+
+		// p1 + t*d is inside for t1 <= t <= t2
+		double t1 = infinite ? -std::numeric_limits<double>::infinity() : 0.;
+		double t2 = infinite ? std::numeric_limits<double>::infinity() : 1.;
+		// one pair per border: direction towards the outside, distance inside
+		std::array<std::pair<double, double>, 4> const borders{{
+				{-d.x, p1.x - _minP.x}, {d.x, _maxP.x - p1.x},
+				{-d.y, p1.y - _minP.y}, {d.y, _maxP.y - p1.y}}};
+		for (auto const& border: borders) {
+			if (border.first == 0.) {
+				// parallel to this border
+				if (border.second < 0.)
+					return false;
+				continue;
+			}
+			double const t = border.second / border.first;
+			if (border.first < 0.)
+				t1 = std::max(t1, t);
+			else
+				t2 = std::min(t2, t);
+			if (t1 > t2)
+				return false;
+		}
+
+		Coordinate const start = p1;
+		p1 = start + d * t1;
+		p2 = start + d * t2;
+		return true;
+	}
+
 	std::ostream& operator<<(std::ostream& os, const Area& area) {
 		os << "Area(" << area.minP() << " " << area.maxP() << ")";
 		return os;
@@ -305,5 +342,23 @@ void LC_Rect::unitTest() {
 	INTERT_TEST(!rect0.inArea({1.1, 1.1}))
 	INTERT_TEST(!rect0.inArea({-1.1, -1.1}))
 
+	// clipLine() tests
+	RS_Vector p1{-1., 0.5};
+	RS_Vector p2{2., 0.5};
+	INTERT_TEST(rect0.clipLine(p1, p2) && p1 == RS_Vector(0., 0.5) && p2 == RS_Vector(1., 0.5))
+	p1 = {0.25, 0.25};
+	p2 = {0.5, 0.5};
+	INTERT_TEST(rect0.clipLine(p1, p2) && p1 == RS_Vector(0.25, 0.25) && p2 == RS_Vector(0.5, 0.5))
+	INTERT_TEST(rect0.clipLine(p1, p2, true) && p1 == RS_Vector(0., 0.) && p2 == RS_Vector(1., 1.))
+	p1 = {1.5, 0.};
+	p2 = {0., 1.5};
+	INTERT_TEST(rect0.clipLine(p1, p2) && p1 == RS_Vector(1., 0.5) && p2 == RS_Vector(0.5, 1.))
+	p1 = {2., 0.};
+	p2 = {2., 1.};
+	INTERT_TEST(!rect0.clipLine(p1, p2, true))
+	p1 = {1.1, 1.1};
+	p2 = {3., 3.};
+	INTERT_TEST(!rect0.clipLine(p1, p2) && p1 == RS_Vector(1.1, 1.1))
+
 }
 
@@ -200,6 +200,17 @@ public:
 	 */
 	std::array<Coordinate, 4> vertices() const;
 
+	/**
+	 * @brief clipLine clip a line to this area (Liang-Barsky)
+	 * @param p1 start point, moved onto the border if outside
+	 * @param p2 end point, moved onto the border if outside
+	 * @param infinite clip the infinite line through p1 and p2 instead of
+	 * the segment, the direction from p1 to p2 is kept
+	 * @return false if no part of the line is inside, p1 and p2 are not
+	 * changed then
+	 */
+	bool clipLine(Coordinate& p1, Coordinate& p2, bool infinite = false) const;
+
 	static void unitTest();
 
 private:
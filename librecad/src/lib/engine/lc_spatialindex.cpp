@@ -0,0 +1,347 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2018 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "lc_spatialindex.h"
+#include "rs_entity.h"
+#include "rs_entitycontainer.h"
+#include "rs_insert.h"
+
+namespace {
+//! maximum number of children of a tree node
+constexpr size_t nodeCapacity = 16;
+
+//! number of pending items which are always tolerated before repacking
+constexpr size_t pendingAllowance = 256;
+
+double centerX(const LC_SpatialIndex::Box& box)
+{
+    return 0.5 * (box.minX + box.maxX);
+}
+
+double centerY(const LC_SpatialIndex::Box& box)
+{
+    return 0.5 * (box.minY + box.maxY);
+}
+
+void extend(LC_SpatialIndex::Box& box, const RS_Vector& v)
+{
+    if (!v.valid) {
+        return;
+    }
+    box.minX = std::min(box.minX, v.x);
+    box.minY = std::min(box.minY, v.y);
+    box.maxX = std::max(box.maxX, v.x);
+    box.maxY = std::max(box.maxY, v.y);
+}
+
+bool isEmpty(const LC_SpatialIndex::Box& box)
+{
+    return box.minX > box.maxX || box.minY > box.maxY;
+}
+
+LC_SpatialIndex::Box emptyBox()
+{
+    double const inf = std::numeric_limits<double>::infinity();
+    return {inf, inf, -inf, -inf};
+}
+
+/**
+ * @brief extendBox grow box by all points a query could report for entity
+ * @return false, if the entity can be reported far outside of any box
+ */
+bool extendBox(RS_Entity const* entity, LC_SpatialIndex::Box& box)
+{
+    if (entity->rtti() == RS2::EntityConstructionLine) {
+        return false;
+    }
+
+    RS_Vector const& vMin = entity->getMin();
+    RS_Vector const& vMax = entity->getMax();
+    // borders are reset to inverted values for empty entities
+    if (vMin.x <= vMax.x && vMin.y <= vMax.y
+            && vMin.x >= RS_MINDOUBLE && vMax.x <= RS_MAXDOUBLE
+            && vMin.y >= RS_MINDOUBLE && vMax.y <= RS_MAXDOUBLE) {
+        extend(box, vMin);
+        extend(box, vMax);
+    }
+
+    if (entity->rtti() == RS2::EntityInsert) {
+        // the entities of inserts are mapped from the block when queried
+        RS_Vector eMin, eMax;
+        if (!static_cast<RS_Insert const*>(entity)->getExtent(eMin, eMax)) {
+            return false;
+        }
+        extend(box, eMin);
+        extend(box, eMax);
+    } else if (entity->isContainer()) {
+        auto container = static_cast<RS_EntityContainer const*>(entity);
+        for (RS_Entity const* e: *container) {
+            if (!extendBox(e, box)) {
+                return false;
+            }
+        }
+    } else {
+        // centers are snapped and picked, e.g. the center of an arc
+        extend(box, entity->getCenter());
+    }
+
+    for (RS_Vector const& vp: entity->getRefPoints()) {
+        extend(box, vp);
+    }
+    return true;
+}
+
+/**
+ * @brief strSort sort-tile-recursive order: sort by x, then sort vertical
+ * slices by y, so consecutive runs of nodeCapacity elements are compact
+ */
+template<class T>
+void strSort(std::vector<T>& list)
+{
+    auto const byX = [](const T& a, const T& b) {
+        return centerX(a.box) < centerX(b.box);
+    };
+    auto const byY = [](const T& a, const T& b) {
+        return centerY(a.box) < centerY(b.box);
+    };
+
+    std::sort(list.begin(), list.end(), byX);
+
+    size_t const leaves = (list.size() + nodeCapacity - 1) / nodeCapacity;
+    size_t const slices = static_cast<size_t>(std::ceil(std::sqrt(double(leaves))));
+    size_t const sliceSize = std::max<size_t>(1, slices) * nodeCapacity;
+    for (size_t i = 0; i < list.size(); i += sliceSize) {
+        auto const last = list.begin() + std::min(list.size(), i + sliceSize);
+        std::sort(list.begin() + i, last, byY);
+    }
+}
+
+template<class T>
+LC_SpatialIndex::Box unite(const std::vector<T>& list, size_t first, size_t count)
+{
+    LC_SpatialIndex::Box box = emptyBox();
+    for (size_t i = first; i < first + count; ++i) {
+        box.minX = std::min(box.minX, list[i].box.minX);
+        box.minY = std::min(box.minY, list[i].box.minY);
+        box.maxX = std::max(box.maxX, list[i].box.maxX);
+        box.maxY = std::max(box.maxY, list[i].box.maxY);
+    }
+    return box;
+}
+}
+
+double LC_SpatialIndex::Box::squaredDistanceTo(double x, double y) const
+{
+    double const dx = x < minX ? minX - x : (x > maxX ? x - maxX : 0.);
+    double const dy = y < minY ? minY - y : (y > maxY ? y - maxY : 0.);
+    return dx * dx + dy * dy;
+}
+
+bool LC_SpatialIndex::entityBox(RS_Entity const* entity, Box& box)
+{
+    box = emptyBox();
+    return extendBox(entity, box) && !isEmpty(box);
+}
+
+LC_SpatialIndex::Box LC_SpatialIndex::windowBox(const RS_Vector& v1, const RS_Vector& v2)
+{
+    return {std::min(v1.x, v2.x), std::min(v1.y, v2.y),
+                std::max(v1.x, v2.x), std::max(v1.y, v2.y)};
+}
+
+void LC_SpatialIndex::clear()
+{
+    items.clear();
+    nodes.clear();
+    pending.clear();
+    unbounded.clear();
+    locations.clear();
+    changed.clear();
+    deadItems = 0;
+    minOrder = 0;
+    maxOrder = -1;
+    invalidate();
+}
+
+void LC_SpatialIndex::addItem(RS_Entity* entity, long order)
+{
+    if (!entity) {
+        return;
+    }
+    minOrder = std::min(minOrder, order);
+    maxOrder = std::max(maxOrder, order);
+
+    Item item{emptyBox(), entity, order};
+    if (entityBox(entity, item.box)) {
+        locations[entity] = {PendingItem, pending.size()};
+        pending.push_back(item);
+    } else {
+        locations[entity] = {UnboundedItem, unbounded.size()};
+        unbounded.push_back(item);
+    }
+}
+
+void LC_SpatialIndex::insert(RS_Entity* entity, bool front)
+{
+    // an outdated index is rebuilt from the owner's list anyway
+    if (!valid || !entity || locations.count(entity)) {
+        return;
+    }
+    addItem(entity, front ? minOrder - 1 : maxOrder + 1);
+}
+
+void LC_SpatialIndex::eraseFrom(std::vector<Item>& list, size_t index)
+{
+    if (index + 1 < list.size()) {
+        list[index] = list.back();
+        locations[list[index].entity].index = index;
+    }
+    list.pop_back();
+}
+
+void LC_SpatialIndex::remove(RS_Entity const* entity)
+{
+    if (!valid) {
+        return;
+    }
+    auto it = locations.find(entity);
+    if (it == locations.end()) {
+        return;
+    }
+    Location const location = it->second;
+    locations.erase(it);
+    changed.erase(const_cast<RS_Entity*>(entity));
+
+    switch (location.list) {
+    case TreeItem:
+        items[location.index].entity = nullptr;
+        ++deadItems;
+        break;
+    case PendingItem:
+        eraseFrom(pending, location.index);
+        break;
+    case UnboundedItem:
+        eraseFrom(unbounded, location.index);
+        break;
+    }
+}
+
+void LC_SpatialIndex::markChanged(RS_Entity* entity)
+{
+    if (valid && locations.count(entity)) {
+        changed.insert(entity);
+    }
+}
+
+void LC_SpatialIndex::update(RS_Entity* entity)
+{
+    auto it = locations.find(entity);
+    if (it == locations.end()) {
+        return;
+    }
+
+    long order = 0;
+    switch (it->second.list) {
+    case TreeItem:
+        order = items[it->second.index].order;
+        break;
+    case PendingItem:
+        order = pending[it->second.index].order;
+        break;
+    case UnboundedItem:
+        order = unbounded[it->second.index].order;
+        break;
+    }
+    remove(entity);
+    addItem(entity, order);
+}
+
+void LC_SpatialIndex::refresh()
+{
+    if (!valid) {
+        return;
+    }
+    std::unordered_set<RS_Entity*> entities;
+    entities.swap(changed);
+    for (RS_Entity* entity: entities) {
+        update(entity);
+    }
+
+    size_t const live = items.size() - deadItems;
+    if (pending.size() > pendingAllowance + live / 64
+            || deadItems > pendingAllowance + live / 4) {
+        pack();
+    }
+}
+
+/**
+ * Moves all pending items into the tree and repacks it from scratch.
+ */
+void LC_SpatialIndex::pack()
+{
+    items.erase(std::remove_if(items.begin(), items.end(), [](const Item& item) {
+        return item.entity == nullptr;
+    }), items.end());
+    items.insert(items.end(), pending.begin(), pending.end());
+    pending.clear();
+    deadItems = 0;
+    nodes.clear();
+    valid = true;
+    scans = 0;
+
+    if (items.empty()) {
+        return;
+    }
+
+    strSort(items);
+    for (size_t i = 0; i < items.size(); ++i) {
+        locations[items[i].entity] = {TreeItem, i};
+    }
+
+    // leaves
+    std::vector<Node> level;
+    for (size_t i = 0; i < items.size(); i += nodeCapacity) {
+        size_t const count = std::min(nodeCapacity, items.size() - i);
+        level.push_back({unite(items, i, count), i, count, true});
+    }
+
+    // inner nodes, one level at a time, the root comes last
+    while (level.size() > 1) {
+        strSort(level);
+        size_t const base = nodes.size();
+        nodes.insert(nodes.end(), level.begin(), level.end());
+
+        std::vector<Node> parents;
+        for (size_t i = 0; i < level.size(); i += nodeCapacity) {
+            size_t const count = std::min(nodeCapacity, level.size() - i);
+            parents.push_back({unite(level, i, count), base + i, count, false});
+        }
+        level.swap(parents);
+    }
+    nodes.push_back(level.front());
+}
@@ -0,0 +1,283 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2018 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+#ifndef LC_SPATIALINDEX_H
+#define LC_SPATIALINDEX_H
+
+#include <cstddef>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "rs_vector.h"
+
+class RS_Entity;
+
+/** \brief Bounding box index over the direct children of an entity container
+ *
+ * The index is a packed R-tree (sort-tile-recursive bulk loading). Entities
+ * added after the last packing are kept in a small pending list, removed
+ * entities are only marked dead in the tree, refresh() repacks the tree once
+ * too much has changed. The owner invalidates the index when the geometry of
+ * its children changed in a way the index is not told about, and rebuilds it
+ * from its entity list before the next query.
+ *
+ * The box stored for each entity does not only cover its borders, but also
+ * every point a snap query might return for it, e.g. the center of an arc
+ * and the reference points of dimensions. Entities without a finite box,
+ * like construction lines, are reported by every query.
+ *
+ * Every entity carries an order number which follows the order of the
+ * owner's entity list, so queries can resolve ties the same way a linear
+ * scan over the list would.
+ */
+class LC_SpatialIndex
+{
+public:
+    struct Box {
+        double minX;
+        double minY;
+        double maxX;
+        double maxY;
+
+        bool overlaps(const Box& other) const {
+            return minX <= other.maxX && other.minX <= maxX
+                    && minY <= other.maxY && other.minY <= maxY;
+        }
+        //! squared distance from (x, y) to this box, 0 for points inside
+        double squaredDistanceTo(double x, double y) const;
+    };
+
+    LC_SpatialIndex() = default;
+
+    //! forget everything, the index must be rebuilt before it is queried
+    void clear();
+    //! drop all entries and index the given range of entities in list order
+    template<class Iterator>
+    void rebuild(Iterator first, Iterator last) {
+        clear();
+        long order = 0;
+        for (Iterator it = first; it != last; ++it) {
+            addItem(*it, order++);
+        }
+        pack();
+    }
+
+    /**
+     * @brief insert add an entity after the last packing
+     * @param front true, if the entity was put in front of the owner's entity list
+     */
+    void insert(RS_Entity* entity, bool front = false);
+    void remove(RS_Entity const* entity);
+    //! the geometry of an entity changed, its box is re-read by refresh()
+    void markChanged(RS_Entity* entity);
+    //! re-read changed boxes and repack the tree if too much has changed
+    void refresh();
+
+    //! mark the index outdated, e.g. after borders of all children changed
+    void invalidate() {
+        valid = false;
+        scans = 0;
+    }
+    bool isValid() const {
+        return valid;
+    }
+    /**
+     * @brief countScan record a linear scan the owner did because the index
+     * was outdated
+     * @return true, once the scans since the index became outdated cost
+     * about as much as rebuilding it
+     */
+    bool countScan() {
+        return ++scans > scansPerRebuild;
+    }
+
+    /**
+     * @brief visitNearest visit entities in ascending order of the distance
+     * between coord and their boxes
+     * @param visitor called as double visitor(RS_Entity*, long order), returns
+     * the distance of the best candidate found so far. The query stops once
+     * no remaining box is closer than that distance.
+     */
+    template<class Visitor>
+    void visitNearest(const RS_Vector& coord, Visitor visitor) const;
+
+    /**
+     * @brief visitWindow visit all entities whose boxes overlap the window
+     * @param visitor called as void visitor(RS_Entity*, long order)
+     */
+    template<class Visitor>
+    void visitWindow(const RS_Vector& v1, const RS_Vector& v2,
+                     Visitor visitor) const;
+
+    /**
+     * @brief entityBox calculate the box indexed for an entity
+     * @return false, if the entity has no finite box
+     */
+    static bool entityBox(RS_Entity const* entity, Box& box);
+
+private:
+    struct Item {
+        Box box;
+        RS_Entity* entity;
+        long order;
+    };
+    struct Node {
+        Box box;
+        size_t first;
+        size_t count;
+        bool leaf;
+    };
+    enum ItemList {
+        TreeItem,
+        PendingItem,
+        UnboundedItem
+    };
+    struct Location {
+        ItemList list;
+        size_t index;
+    };
+
+    void addItem(RS_Entity* entity, long order);
+    void update(RS_Entity* entity);
+    void eraseFrom(std::vector<Item>& list, size_t index);
+    void pack();
+    static Box windowBox(const RS_Vector& v1, const RS_Vector& v2);
+
+    //! items packed into the tree, entity is nullptr for removed items
+    std::vector<Item> items;
+    //! tree nodes, the root is the last node
+    std::vector<Node> nodes;
+    //! items added after the last packing
+    std::vector<Item> pending;
+    //! items without a finite box
+    std::vector<Item> unbounded;
+    std::unordered_map<RS_Entity const*, Location> locations;
+    std::unordered_set<RS_Entity*> changed;
+    size_t deadItems = 0;
+    unsigned scans = 0;
+    //! a rebuild takes about as long as this number of linear scans
+    static constexpr unsigned scansPerRebuild = 8;
+    long minOrder = 0;
+    long maxOrder = -1;
+    bool valid = false;
+};
+
+template<class Visitor>
+void LC_SpatialIndex::visitNearest(const RS_Vector& coord, Visitor visitor) const
+{
+    struct Candidate {
+        double distance2;
+        ItemList list;
+        bool node;
+        size_t index;
+
+        bool operator < (const Candidate& other) const {
+            // std::priority_queue pops the largest element first
+            return distance2 > other.distance2;
+        }
+    };
+
+    double const cx = coord.x;
+    double const cy = coord.y;
+    // negative until the visitor reported a distance
+    double cutoff = -1.;
+    std::priority_queue<Candidate> queue;
+
+    for (const Item& item: unbounded) {
+        cutoff = visitor(item.entity, item.order);
+    }
+    for (size_t i = 0; i < pending.size(); ++i) {
+        queue.push({pending[i].box.squaredDistanceTo(cx, cy), PendingItem, false, i});
+    }
+    if (!nodes.empty()) {
+        queue.push({nodes.back().box.squaredDistanceTo(cx, cy), TreeItem, true, nodes.size() - 1});
+    }
+
+    while (!queue.empty()) {
+        Candidate const candidate = queue.top();
+        queue.pop();
+        // the slack keeps entities at exactly the cutoff distance despite
+        // rounding, so ties are resolved by the visitor
+        if (cutoff >= 0. && candidate.distance2 > cutoff * cutoff * (1. + 1e-12)) {
+            break;
+        }
+
+        if (candidate.node) {
+            const Node& node = nodes[candidate.index];
+            for (size_t i = node.first; i < node.first + node.count; ++i) {
+                if (node.leaf) {
+                    if (items[i].entity) {
+                        queue.push({items[i].box.squaredDistanceTo(cx, cy), TreeItem, false, i});
+                    }
+                } else {
+                    queue.push({nodes[i].box.squaredDistanceTo(cx, cy), TreeItem, true, i});
+                }
+            }
+            continue;
+        }
+
+        const Item& item = candidate.list == PendingItem ? pending[candidate.index]
+                                                          : items[candidate.index];
+        cutoff = visitor(item.entity, item.order);
+    }
+}
+
+template<class Visitor>
+void LC_SpatialIndex::visitWindow(const RS_Vector& v1, const RS_Vector& v2,
+                                  Visitor visitor) const
+{
+    Box const window = windowBox(v1, v2);
+
+    for (const Item& item: unbounded) {
+        visitor(item.entity, item.order);
+    }
+    for (const Item& item: pending) {
+        if (item.box.overlaps(window)) {
+            visitor(item.entity, item.order);
+        }
+    }
+    if (nodes.empty()) {
+        return;
+    }
+
+    std::vector<size_t> stack{nodes.size() - 1};
+    while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+        if (!node.box.overlaps(window)) {
+            continue;
+        }
+        for (size_t i = node.first; i < node.first + node.count; ++i) {
+            if (!node.leaf) {
+                stack.push_back(i);
+            } else if (items[i].entity && items[i].box.overlaps(window)) {
+                visitor(items[i].entity, items[i].order);
+            }
+        }
+    }
+}
+
+#endif // LC_SPATIALINDEX_H
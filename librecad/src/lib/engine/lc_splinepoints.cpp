@@ -21,6 +21,8 @@ along with this program; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 **********************************************************************/
 
+#include <algorithm>
+#include <array>
 #include <QPainterPath>
 #include <QPolygonF>
 #include "lc_splinepoints.h"
@@ -45,6 +47,58 @@ RS_Vector GetQuadPoint(const RS_Vector& x1,
 	return x1*(1.0 - dt)*(1.0 - dt) + c1*2.0*dt*(1.0 - dt) + x2*dt*dt;
 }
 
+// extends *pvMin, *pvMax by the tight bounds of the quadratic segment
+void GetQuadExtent(const RS_Vector& x1, const RS_Vector& c1, const RS_Vector& x2,
+	RS_Vector* pvMin, RS_Vector* pvMax)
+{
+	RS_Vector locMinV = RS_Vector::minimum(x1, x2);
+	RS_Vector locMaxV = RS_Vector::maximum(x1, x2);
+
+	RS_Vector vDer = x2 - c1*2.0 + x1;
+	double dt, dx;
+
+	if(fabs(vDer.x) > RS_TOLERANCE)
+	{
+		dt = (x1.x - c1.x)/vDer.x;
+		if(dt > RS_TOLERANCE && dt < 1.0 - RS_TOLERANCE)
+		{
+			dx = x1.x*(1.0 - dt)*(1.0 - dt) + 2.0*c1.x*dt*(1.0 - dt) + x2.x*dt*dt;
+			if(dx < locMinV.x) locMinV.x = dx;
+			if(dx > locMaxV.x) locMaxV.x = dx;
+		}
+	}
+
+	if(fabs(vDer.y) > RS_TOLERANCE)
+	{
+		dt = (x1.y - c1.y)/vDer.y;
+		if(dt > RS_TOLERANCE && dt < 1.0 - RS_TOLERANCE)
+		{
+			dx = x1.y*(1.0 - dt)*(1.0 - dt) + 2.0*c1.y*dt*(1.0 - dt) + x2.y*dt*dt;
+			if(dx < locMinV.y) locMinV.y = dx;
+			if(dx > locMaxV.y) locMaxV.y = dx;
+		}
+	}
+
+	*pvMin = RS_Vector::minimum(locMinV, *pvMin);
+	*pvMax = RS_Vector::maximum(locMaxV, *pvMax);
+}
+
+// squared distance from coord to the box, 0 for points inside
+double GetDistToBoxSquared(const RS_Vector& coord, const RS_Vector& vMin,
+	const RS_Vector& vMax)
+{
+	double dx = coord.x < vMin.x ? vMin.x - coord.x : (coord.x > vMax.x ? coord.x - vMax.x : 0.0);
+	double dy = coord.y < vMin.y ? vMin.y - coord.y : (coord.y > vMax.y ? coord.y - vMax.y : 0.0);
+	return dx*dx + dy*dy;
+}
+
+bool BoxesOverlap(const RS_Vector& vMin1, const RS_Vector& vMax1,
+	const RS_Vector& vMin2, const RS_Vector& vMax2, double margin)
+{
+	return vMin1.x <= vMax2.x + margin && vMin2.x <= vMax1.x + margin &&
+		vMin1.y <= vMax2.y + margin && vMin2.y <= vMax1.y + margin;
+}
+
 void StrokeQuad(std::vector<RS_Vector>* plist,
 				RS_Vector const& vx1,
 				RS_Vector const&  vc1,
@@ -386,21 +440,15 @@ double GetDistToQuadSquared(const RS_Vector& coord, const RS_Vector& x1,
 		(x1.y - coord.y)*(x2.y - 2.0*c1.y + x1.y);
 	a4 = (x1.x - coord.x)*(c1.x - x1.x) + (x1.y - coord.y)*(c1.y - x1.y);
 
-	std::vector<double> dCoefs(0, 0.);
-	std::vector<double> dSol(0, 0.);
+	RS_Math::Roots<3> dSol;
 
 	if(fabs(a1) > RS_TOLERANCE) // solve as cubic
 	{
-		dCoefs.push_back(a2/a1);
-		dCoefs.push_back(a3/a1);
-		dCoefs.push_back(a4/a1);
-		dSol = RS_Math::cubicSolver(dCoefs);
+		dSol = RS_Math::cubicRoots({{a2/a1, a3/a1, a4/a1}});
 	}
 	else if(fabs(a2) > RS_TOLERANCE) // solve as quadratic
 	{
-		dCoefs.push_back(a3/a2);
-		dCoefs.push_back(a4/a2);
-		dSol = RS_Math::quadraticSolver(dCoefs);
+		dSol.assign(RS_Math::quadraticRoots({{a3/a2, a4/a2}}));
 	}
 	else if(fabs(a3) > RS_TOLERANCE) // solve as linear
 	{
@@ -466,16 +514,11 @@ void AddQuadTangentPoints(RS_VectorSolutions *pVS, const RS_Vector& point,
 	double a2 = vx3.x*vx1.y - vx3.y*vx1.x;
 	double a3 = vx3.x*vx2.y - vx3.y*vx2.x;
 
-	std::vector<double> dSol(0, 0.);
+	RS_Math::Roots<2> dSol;
 
 	if(fabs(a1) > RS_TOLERANCE)
 	{
-		std::vector<double> dCoefs(0, 0.);
-
-		dCoefs.push_back(a2/a1);
-		dCoefs.push_back(a3/a1);
-		dSol = RS_Math::quadraticSolver(dCoefs);
-
+		dSol = RS_Math::quadraticRoots({{a2/a1, a3/a1}});
 	}
 	else if(fabs(a2) > RS_TOLERANCE)
 	{
@@ -506,16 +549,11 @@ void addLineQuadIntersect(RS_VectorSolutions *pVS,
 	double a2 = 2.0*(x2.x*x4.y - x2.y*x4.x);
 	double a3 = x3.x*x4.y - x3.y*x4.x;
 
-	std::vector<double> dSol(0, 0.);
+	RS_Math::Roots<2> dSol;
 
 	if(fabs(a1) > RS_TOLERANCE)
 	{
-		std::vector<double> dCoefs(0, 0.);
-
-		dCoefs.push_back(a2/a1);
-		dCoefs.push_back(a3/a1);
-		dSol = RS_Math::quadraticSolver(dCoefs);
-
+		dSol = RS_Math::quadraticRoots({{a2/a1, a3/a1}});
 	}
 	else if(fabs(a2) > RS_TOLERANCE)
 	{
@@ -574,44 +612,9 @@ RS_Entity* LC_SplinePoints::clone() const
 	return l;
 }
 
-void LC_SplinePoints::update()
-{
-	UpdateControlPoints();
-	calculateBorders();
-}
-
 void LC_SplinePoints::UpdateQuadExtent(const RS_Vector& x1, const RS_Vector& c1, const RS_Vector& x2)
 {
-    RS_Vector locMinV = RS_Vector::minimum(x1, x2);
-    RS_Vector locMaxV = RS_Vector::maximum(x1, x2);
-
-	RS_Vector vDer = x2 - c1*2.0 + x1;
-	double dt, dx;
-
-	if(fabs(vDer.x) > RS_TOLERANCE)
-	{
-		dt = (x1.x - c1.x)/vDer.x;
-		if(dt > RS_TOLERANCE && dt < 1.0 - RS_TOLERANCE)
-		{
-			dx = x1.x*(1.0 - dt)*(1.0 - dt) + 2.0*c1.x*dt*(1.0 - dt) + x2.x*dt*dt;
-			if(dx < locMinV.x) locMinV.x = dx;
-			if(dx > locMaxV.x) locMaxV.x = dx;
-		}
-	}
-
-	if(fabs(vDer.y) > RS_TOLERANCE)
-	{
-		dt = (x1.y - c1.y)/vDer.y;
-		if(dt > RS_TOLERANCE && dt < 1.0 - RS_TOLERANCE)
-		{
-			dx = x1.y*(1.0 - dt)*(1.0 - dt) + 2.0*c1.y*dt*(1.0 - dt) + x2.y*dt*dt;
-			if(dx < locMinV.y) locMinV.y = dx;
-			if(dx > locMaxV.y) locMaxV.y = dx;
-		}
-	}
-
-    minV = RS_Vector::minimum(locMinV, minV);
-    maxV = RS_Vector::maximum(locMaxV, maxV);
+	GetQuadExtent(x1, c1, x2, &minV, &maxV);
 }
 
 void LC_SplinePoints::calculateBorders()
@@ -810,108 +813,267 @@ int LC_SplinePoints::GetQuadPoints(int iSeg, RS_Vector *pvStart, RS_Vector *pvCo
 	return 3;
 }
 
-// returns the index to the nearest segment, dt holds the t parameter
-// we will make an extrodrinary exception here and make the index 1-based
-// return values:
-//   -1: no segment found
-//   0: segment is one point only
-//   >0: index to then non-degenerated segment, depends on closed flag
-int LC_SplinePoints::GetNearestQuad(const RS_Vector& coord,
-	double* dist, double* dt) const
+/**
+ * The quadratic pieces of a spline, piece k is the segment k + 1 of
+ * GetQuadPoints(). A binary tree of bounding boxes over runs of consecutive
+ * pieces prunes nearest point and intersection queries, the cumulative arc
+ * lengths turn distances along the spline into a binary search.
+ */
+struct LC_SplinePoints::Pieces
 {
-	size_t n = data.controlPoints.size();
+	struct Quad
+	{
+		RS_Vector x1, c1, x2;
+		RS_Vector minV, maxV;
+	};
+	struct Node
+	{
+		RS_Vector minV, maxV;
+		// range of pieces, children are 0 for leaves
+		size_t first, last;
+		size_t left, right;
+	};
 
-	RS_Vector vStart(false), vControl(false), vEnd(false), vRes(false);
+	explicit Pieces(LC_SplinePoints const& spline);
 
-	double dDist = 0., dNewDist = 0.;
-	double dRes, dNewRes;
-	int iRes = -1;
+	//! same as GetNearestQuad(), dist is squared
+	int nearest(const RS_Vector& coord, double* dist, double* dt) const;
+	//! pairs of pieces (this, other) with overlapping boxes, in order
+	std::vector<std::pair<size_t, size_t>> overlaps(Pieces const& other) const;
 
-	if(data.closed)
-	{
-		if(n < 3) return -1;
+	std::vector<Quad> quads;
+	//! the root comes first
+	std::vector<Node> nodes;
+	//! lengths[k] is the arc length of the pieces before piece k
+	std::vector<double> lengths;
+	//! the control points the pieces were built from
+	std::vector<RS_Vector> controlPoints;
+	bool closed;
 
-		vStart = (data.controlPoints.at(n - 1) + data.controlPoints.at(0))/2.0;
-		vControl = data.controlPoints.at(0);
-		vEnd = (data.controlPoints.at(0) + data.controlPoints.at(1))/2.0;
+private:
+	size_t build(size_t first, size_t last);
+};
 
-		dRes = GetDistToQuadSquared(coord, vStart, vControl, vEnd, &dDist);
-		iRes = 1;
+namespace {
+//! maximum number of pieces in a leaf
+constexpr size_t leafPieces = 4;
+}
 
-		for(size_t i = 1; i < n - 1; ++i)
-		{
-			vStart = vEnd;
-			vControl = data.controlPoints.at(i);
-			vEnd = (data.controlPoints.at(i) + data.controlPoints.at(i + 1))/2.0;
+LC_SplinePoints::Pieces::Pieces(LC_SplinePoints const& spline):
+	controlPoints(spline.data.controlPoints)
+  ,closed(spline.data.closed)
+{
+	size_t const n = closed ? controlPoints.size() : controlPoints.size() - 2;
+	quads.resize(n);
+	lengths.resize(n + 1, 0.0);
+	for(size_t k = 0; k < n; ++k)
+	{
+		Quad& q = quads[k];
+		spline.GetQuadPoints(k + 1, &q.x1, &q.c1, &q.x2);
+		q.minV = RS_Vector(false);
+		q.maxV = RS_Vector(false);
+		GetQuadExtent(q.x1, q.c1, q.x2, &q.minV, &q.maxV);
+		lengths[k + 1] = lengths[k] + GetQuadLength(q.x1, q.c1, q.x2, 0.0, 1.0);
+	}
+	nodes.reserve(2*(n/leafPieces + 1));
+	build(0, n);
+}
 
-			dNewRes = GetDistToQuadSquared(coord, vStart, vControl, vEnd, &dNewDist);
-			if(SetNewDist(true, dNewDist, dNewRes, &dDist, &dRes)) iRes = i + 1;
+size_t LC_SplinePoints::Pieces::build(size_t first, size_t last)
+{
+	size_t const index = nodes.size();
+	nodes.push_back({quads[first].minV, quads[first].maxV, first, last, 0, 0});
+	if(last - first <= leafPieces)
+	{
+		for(size_t k = first + 1; k < last; ++k)
+		{
+			nodes[index].minV = RS_Vector::minimum(nodes[index].minV, quads[k].minV);
+			nodes[index].maxV = RS_Vector::maximum(nodes[index].maxV, quads[k].maxV);
 		}
+		return index;
+	}
 
-		vStart = vEnd;
-		vControl = data.controlPoints.at(n - 1);
-		vEnd = (data.controlPoints.at(n - 1) + data.controlPoints.at(0))/2.0;
+	size_t const middle = first + (last - first)/2;
+	size_t const left = build(first, middle);
+	size_t const right = build(middle, last);
+	Node& node = nodes[index];
+	node.left = left;
+	node.right = right;
+	node.minV = RS_Vector::minimum(nodes[left].minV, nodes[right].minV);
+	node.maxV = RS_Vector::maximum(nodes[left].maxV, nodes[right].maxV);
+	return index;
+}
 
-		dNewRes = GetDistToQuadSquared(coord, vStart, vControl, vEnd, &dNewDist);
-		if(SetNewDist(true, dNewDist, dNewRes, &dDist, &dRes)) iRes = n;
-	}
-	else
-	{
-		if(n < 1) return -1;
+int LC_SplinePoints::Pieces::nearest(const RS_Vector& coord, double* dist,
+	double* dt) const
+{
+	double dDist = RS_MAXDOUBLE, dRes = 0.0;
+	size_t iRes = 0;
+	bool bResSet = false;
 
-		vStart = data.controlPoints.at(0);
+	// the tree is balanced, its depth is far below the stack size
+	std::array<size_t, 128> stack;
+	size_t top = 0;
+	stack[top++] = 0;
+	while(top > 0)
+	{
+		Node const& node = nodes[stack[--top]];
+		// the slack keeps pieces at the same distance despite rounding, ties
+		// are resolved by index like a linear scan would
+		if(bResSet && GetDistToBoxSquared(coord, node.minV, node.maxV) >
+			dDist*(1.0 + 1e-12) + RS_TOLERANCE2) continue;
 
-		if(n < 2)
+		if(node.left == 0)
 		{
-			if(dist) *dist = (coord - vStart).magnitude();
-			return 0;
+			for(size_t k = node.first; k < node.last; ++k)
+			{
+				Quad const& q = quads[k];
+				double dNewDist = -1.0;
+				double dNewRes = GetDistToQuadSquared(coord, q.x1, q.c1, q.x2, &dNewDist);
+				if(dNewDist < 0.0)
+				{
+					// degenerated piece
+					dNewDist = (coord - q.x1).squared();
+					dNewRes = 0.0;
+				}
+				if(!bResSet || dNewDist < dDist || (dNewDist == dDist && k < iRes))
+				{
+					dDist = dNewDist;
+					dRes = dNewRes;
+					iRes = k;
+					bResSet = true;
+				}
+			}
+			continue;
 		}
 
-		vEnd = data.controlPoints.at(1);
-
-		if(n < 3)
+		// visit the closer child first
+		Node const& left = nodes[node.left];
+		Node const& right = nodes[node.right];
+		if(GetDistToBoxSquared(coord, left.minV, left.maxV) <=
+			GetDistToBoxSquared(coord, right.minV, right.maxV))
+		{
+			stack[top++] = node.right;
+			stack[top++] = node.left;
+		}
+		else
 		{
-			*dt = GetDistToLine(coord, vStart, vEnd, &dDist);
-			if(dist) *dist = sqrt(dDist);
-			return 1;
+			stack[top++] = node.left;
+			stack[top++] = node.right;
 		}
+	}
 
-		vControl = vEnd;
-		vEnd = data.controlPoints.at(2);
+	*dist = dDist;
+	*dt = dRes;
+	return iRes + 1;
+}
 
-		if(n < 4)
+std::vector<std::pair<size_t, size_t>> LC_SplinePoints::Pieces::overlaps(
+	Pieces const& other) const
+{
+	std::vector<std::pair<size_t, size_t>> ret;
+
+	// points reported at the tolerance of the segment parameters may lie
+	// slightly outside of the boxes
+	RS_Vector const span = RS_Vector::maximum(nodes[0].maxV - nodes[0].minV,
+		other.nodes[0].maxV - other.nodes[0].minV);
+	double const margin = RS_TOLERANCE*(1.0 + 8.0*(span.x + span.y));
+
+	std::vector<std::pair<size_t, size_t>> stack{{0, 0}};
+	while(!stack.empty())
+	{
+		Node const& n0 = nodes[stack.back().first];
+		Node const& n1 = other.nodes[stack.back().second];
+		size_t const i0 = stack.back().first;
+		size_t const i1 = stack.back().second;
+		stack.pop_back();
+		if(!BoxesOverlap(n0.minV, n0.maxV, n1.minV, n1.maxV, margin)) continue;
+
+		bool const leaf0 = n0.left == 0;
+		bool const leaf1 = n1.left == 0;
+		if(leaf0 && leaf1)
+		{
+			for(size_t k0 = n0.first; k0 < n0.last; ++k0)
+			{
+				for(size_t k1 = n1.first; k1 < n1.last; ++k1)
+				{
+					if(BoxesOverlap(quads[k0].minV, quads[k0].maxV,
+						other.quads[k1].minV, other.quads[k1].maxV, margin))
+						ret.emplace_back(k0, k1);
+				}
+			}
+		}
+		else if(leaf1 || (!leaf0 && n0.last - n0.first >= n1.last - n1.first))
+		{
+			stack.emplace_back(n0.left, i1);
+			stack.emplace_back(n0.right, i1);
+		}
+		else
 		{
-			*dt = GetDistToQuadSquared(coord, vStart, vControl, vEnd, &dDist);
-			if(dist) *dist = sqrt(dDist);
-			return 1;
+			stack.emplace_back(i0, n1.left);
+			stack.emplace_back(i0, n1.right);
 		}
+	}
 
-		vEnd = (data.controlPoints.at(1) + data.controlPoints.at(2))/2.0;
+	std::sort(ret.begin(), ret.end());
+	return ret;
+}
 
-		dRes = GetDistToQuadSquared(coord, vStart, vControl, vEnd, &dDist);
-		iRes = 1;
+LC_SplinePoints::Pieces const* LC_SplinePoints::getPieces() const
+{
+	size_t const n = data.controlPoints.size();
+	if(n < 3) return nullptr;
 
-		for(size_t i = 2; i < n - 2; i++)
-		{
-			vStart = vEnd;
-			vControl = data.controlPoints.at(i);
-			vEnd = (data.controlPoints.at(i) + data.controlPoints.at(i + 1))/2.0;
+	// writers of the control points reset the pieces, the count and
+	// closed flag catch edits that did not
+	if(!pieces || pieces->controlPoints.size() != n || pieces->closed != data.closed)
+		pieces = std::make_shared<const Pieces>(*this);
+	return pieces.get();
+}
 
-			dNewRes = GetDistToQuadSquared(coord, vStart, vControl, vEnd, &dNewDist);
-			if(SetNewDist(true, dNewDist, dNewRes, &dDist, &dRes)) iRes = i;
-		}
+void LC_SplinePoints::update()
+{
+	UpdateControlPoints();
+	// draw() updates on every paint, keep the pieces unless the curve changed
+	if(pieces && (pieces->controlPoints != data.controlPoints
+				  || pieces->closed != data.closed))
+		pieces.reset();
+	calculateBorders();
+}
 
-		vStart = vEnd;
-		vControl = data.controlPoints.at(n - 2);
-		vEnd = data.controlPoints.at(n - 1);
+// returns the index to the nearest segment, dt holds the t parameter
+// we will make an extrodrinary exception here and make the index 1-based
+// return values:
+//   -1: no segment found
+//   0: segment is one point only
+//   >0: index to then non-degenerated segment, depends on closed flag
+int LC_SplinePoints::GetNearestQuad(const RS_Vector& coord,
+	double* dist, double* dt) const
+{
+	if(Pieces const* p = getPieces())
+	{
+		double dDist = 0.;
+		int iRes = p->nearest(coord, &dDist, dt);
+		if(dist) *dist = sqrt(dDist);
+		return iRes;
+	}
+
+	// less than three control points
+	size_t n = data.controlPoints.size();
+	if(data.closed || n < 1) return -1;
 
-		dNewRes = GetDistToQuadSquared(coord, vStart, vControl, vEnd, &dNewDist);
-		if(SetNewDist(true, dNewDist, dNewRes, &dDist, &dRes)) iRes = n - 2;
+	RS_Vector vStart = data.controlPoints.at(0);
+
+	if(n < 2)
+	{
+		if(dist) *dist = (coord - vStart).magnitude();
+		return 0;
 	}
 
-	*dt = dRes;
+	double dDist = 0.;
+	*dt = GetDistToLine(coord, vStart, data.controlPoints.at(1), &dDist);
 	if(dist) *dist = sqrt(dDist);
-	return iRes;
+	return 1;
 }
 
 RS_Vector LC_SplinePoints::getNearestPointOnEntity(const RS_Vector& coord,
@@ -968,42 +1130,21 @@ RS_Vector LC_SplinePoints::GetSplinePointAtDist(double dDist, int iStartSeg,
 	RS_Vector vRes(false);
 	if(data.closed) return vRes;
 
-	RS_Vector vStart(false), vControl(false), vEnd(false);
+	Pieces const* p = getPieces();
+	if(!p || iStartSeg < 1 || size_t(iStartSeg) > p->quads.size()) return vRes;
 
-	size_t n = data.controlPoints.size();
-	size_t i = iStartSeg;
+	// distance from the start of the spline
+	Pieces::Quad const* q = &p->quads.at(iStartSeg - 1);
+	dDist += p->lengths.at(iStartSeg - 1) + GetQuadLength(q->x1, q->c1, q->x2, 0.0, dStartT);
+	if(dDist > p->lengths.back()) return vRes;
 
-	GetQuadPoints(i, &vStart, &vControl, &vEnd);
-	double dQuadDist = GetQuadLength(vStart, vControl, vEnd, dStartT, 1.0);
-	i++;
-
-	while(dDist > dQuadDist && i < n - 2)
-	{
-		dDist -= dQuadDist;
-		vStart = vEnd;
-		vControl = data.controlPoints.at(i);
-		vEnd = (data.controlPoints.at(i) + data.controlPoints.at(i + 1))/2.0;
-		dQuadDist = GetQuadLength(vStart, vControl, vEnd, 0.0, 1.0);
-		i++;
-	}
-
-	if(dDist > dQuadDist)
-	{
-		dDist -= dQuadDist;
-		vStart = vEnd;
-		vControl = data.controlPoints.at(n - 2);
-		vEnd = data.controlPoints.at(n - 1);
-		dQuadDist = GetQuadLength(vStart, vControl, vEnd, 0.0, 1.0);
-		i++;
-	}
-
-	if(dDist <= dQuadDist)
-	{
-		double dt = GetQuadPointAtDist(vStart, vControl, vEnd, 0.0, dDist);
-		vRes = GetQuadPoint(vStart, vControl, vEnd, dt);
-		*piSeg = i - 1;
-		*pdt = dt;
-	}
+	size_t i = std::lower_bound(p->lengths.begin() + 1, p->lengths.end(), dDist) -
+		(p->lengths.begin() + 1);
+	q = &p->quads.at(i);
+	double dt = GetQuadPointAtDist(q->x1, q->c1, q->x2, 0.0, dDist - p->lengths.at(i));
+	vRes = GetQuadPoint(q->x1, q->c1, q->x2, dt);
+	*piSeg = i + 1;
+	*pdt = dt;
 
 	return vRes;
 }
@@ -1241,6 +1382,7 @@ void LC_SplinePoints::removeLastPoint()
 
 void LC_SplinePoints::addControlPoint(const RS_Vector& v)
 {
+	pieces.reset();
 	data.controlPoints.push_back(v);
 }
 
@@ -1947,74 +2089,11 @@ double LC_SplinePoints::getLength() const
 
 	if(n < 2) return 0;
 
-	RS_Vector vStart(false), vControl(false), vEnd(false);
-
-	//UpdateControlPoints();
-
-	double dRes = 0.0;
-
-	if(data.closed)
-	{
-		if(n < 3) return 0.0;
-
-		vStart = (data.controlPoints.at(n - 1) + data.controlPoints.at(0))/2.0;
-		vControl = data.controlPoints.at(0);
-		vEnd = (data.controlPoints.at(0) + data.controlPoints.at(1))/2.0;
+	if(Pieces const* p = getPieces()) return p->lengths.back();
 
-		dRes = GetQuadLength(vStart, vControl, vEnd, 0.0, 1.0);
+	if(data.closed) return 0.0;
 
-		for(size_t i = 1; i < n - 1; i++)
-		{
-			vStart = vEnd;
-			vControl = data.controlPoints.at(i);
-			vEnd = (data.controlPoints.at(i) + data.controlPoints.at(i + 1))/2.0;
-
-			dRes += GetQuadLength(vStart, vControl, vEnd, 0.0, 1.0);
-		}
-
-		vStart = vEnd;
-		vControl = data.controlPoints.at(n - 1);
-		vEnd = (data.controlPoints.at(n - 1) + data.controlPoints.at(0))/2.0;
-
-		dRes += GetQuadLength(vStart, vControl, vEnd, 0.0, 1.0);
-	}
-	else
-	{
-		vStart = data.controlPoints.at(0);
-		vEnd = data.controlPoints.at(1);
-		if(n < 3)
-		{
-			return (vEnd - vStart).magnitude();
-		}
-
-		vControl = vEnd;
-		vEnd = data.controlPoints.at(2);
-		if(n < 4)
-		{
-			return GetQuadLength(vStart, vControl, vEnd, 0.0, 1.0);
-		}
-
-		vEnd = (data.controlPoints.at(1) + data.controlPoints.at(2))/2.0;
-
-		dRes = GetQuadLength(vStart, vControl, vEnd, 0.0, 1.0);
-
-		for(size_t i = 2; i < n - 2; i++)
-		{
-			vStart = vEnd;
-			vControl = data.controlPoints.at(i);
-			vEnd = (data.controlPoints.at(i) + data.controlPoints.at(i + 1))/2.0;
-
-			dRes += GetQuadLength(vStart, vControl, vEnd, 0.0, 1.0);
-		}
-
-		vStart = vEnd;
-		vControl = data.controlPoints.at(n - 2);
-		vEnd = data.controlPoints.at(n - 1);
-
-		dRes += GetQuadLength(vStart, vControl, vEnd, 0.0, 1.0);
-	}
-
-	return dRes;
+	return (data.controlPoints.at(1) - data.controlPoints.at(0)).magnitude();
 }
 
 double LC_SplinePoints::getDirection1() const
@@ -2551,6 +2630,8 @@ bool LC_SplinePoints::offsetSpline(const RS_Vector& coord, const double& distanc
 
 bool LC_SplinePoints::offset(const RS_Vector& coord, const double& distance)
 {
+	// the offset replaces the data, not all paths update() it
+	pieces.reset();
 	if(data.cut) return offsetCut(coord, distance);
 	return offsetSpline(coord, distance);
 }
@@ -3292,6 +3373,21 @@ RS_VectorSolutions LC_SplinePoints::getSplinePointsIntersect(LC_SplinePoints* l1
 {
 	RS_VectorSolutions ret;
 
+	Pieces const* p0 = getPieces();
+	Pieces const* p1 = l1->getPieces();
+	if(p0 && p1)
+	{
+		// only pieces with overlapping boxes can intersect, the pairs come in
+		// the order of the full scan below
+		for(auto const& pair: p0->overlaps(*p1))
+		{
+			Pieces::Quad const& q0 = p0->quads[pair.first];
+			Pieces::Quad const& q1 = p1->quads[pair.second];
+			addQuadQuadIntersect(&ret, q1.x1, q1.c1, q1.x2, q0.x1, q0.c1, q0.x2);
+		}
+		return ret;
+	}
+
 	size_t n = data.controlPoints.size();
 	if(n < 2) return ret;
 
@@ -3614,6 +3710,8 @@ LC_SplinePointsData const& LC_SplinePoints::getData() const
 /** @return Copy of data that defines the spline. */
 LC_SplinePointsData& LC_SplinePoints::getData()
 {
+	// the caller may edit the control points
+	pieces.reset();
 	return data;
 }
 
@@ -3666,6 +3764,8 @@ LC_SplinePoints* LC_SplinePoints::cut(const RS_Vector& pos)
 	else vPoint = GetQuadPoint(vStart, vControl, vEnd, dt);
 
 	size_t n = data.controlPoints.size();
+	// the control points are edited below without an update()
+	pieces.reset();
 
 	if(data.closed)
 	{
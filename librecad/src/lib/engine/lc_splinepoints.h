@@ -25,6 +25,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #ifndef LC_SPLINEPOINTS_H
 #define LC_SPLINEPOINTS_H
 
+#include <memory>
 #include <vector>
 #include "rs_atomicentity.h"
 
@@ -82,11 +83,17 @@ private:
 	int GetQuadPoints(int iSeg, RS_Vector *pvStart, RS_Vector *pvControl,
 		RS_Vector *pvEnd) const;
 
+	struct Pieces;
+	//! \return the quadratic pieces, nullptr for less than 3 control points
+	Pieces const* getPieces() const;
+
     bool offsetCut(const RS_Vector& coord, const double& distance);
     bool offsetSpline(const RS_Vector& coord, const double& distance);
 	std::vector<RS_Entity*> offsetTwoSidesSpline(const double& distance) const;
 	std::vector<RS_Entity*> offsetTwoSidesCut(const double& distance) const;
     LC_SplinePointsData data;
+	//! built on demand, dropped whenever the control points change
+	mutable std::shared_ptr<const Pieces> pieces;
 
 public:
     LC_SplinePoints(RS_EntityContainer* parent, const LC_SplinePointsData& d);
@@ -0,0 +1,129 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2018 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+#include <utility>
+#include "lc_transformundoable.h"
+#include "lc_bulkedit.h"
+#include "rs_entitycontainer.h"
+#include "rs_insert.h"
+
+namespace {
+unsigned long sequenceCounter = 0;
+}
+
+LC_TransformUndoable::LC_TransformUndoable(RS_EntityContainer* container,
+                                           std::vector<RS_Entity*> entities):
+    container(container)
+  , entities(std::move(entities))
+  , sequence(++sequenceCounter)
+{
+}
+
+void LC_TransformUndoable::move(const RS_Vector& offset)
+{
+    steps.push_back({Move, offset, RS_Vector(false), 0.});
+}
+
+void LC_TransformUndoable::rotate(const RS_Vector& center, double angle)
+{
+    steps.push_back({Rotate, center, RS_Vector(false), angle});
+}
+
+void LC_TransformUndoable::scale(const RS_Vector& center, const RS_Vector& factor)
+{
+    steps.push_back({Scale, center, factor, 0.});
+}
+
+void LC_TransformUndoable::mirror(const RS_Vector& axisPoint1, const RS_Vector& axisPoint2)
+{
+    steps.push_back({Mirror, axisPoint1, axisPoint2, 0.});
+}
+
+void LC_TransformUndoable::apply(LC_BulkEdit& edit)
+{
+    transform(false, edit);
+}
+
+bool LC_TransformUndoable::canMirrorBack(RS_Entity const* e)
+{
+    switch (e->rtti()) {
+    case RS2::EntityHatch:
+    case RS2::EntityText:
+    case RS2::EntityMText:
+        return false;
+    case RS2::EntityContainer:
+        for (RS_Entity const* child: *static_cast<RS_EntityContainer const*>(e)) {
+            if (!canMirrorBack(child)) {
+                return false;
+            }
+        }
+        return true;
+    default:
+        return true;
+    }
+}
+
+void LC_TransformUndoable::undoStateChanged(bool undone)
+{
+    LC_BulkEdit edit(*container);
+    transform(undone, edit);
+}
+
+void LC_TransformUndoable::transform(bool inverse, LC_BulkEdit& edit)
+{
+    for (RS_Entity* e: entities) {
+        edit.change(e);
+        if (inverse) {
+            for (auto it = steps.crbegin(); it != steps.crend(); ++it) {
+                transform(e, *it, true);
+            }
+        } else {
+            for (const Step& step: steps) {
+                transform(e, step, false);
+            }
+        }
+        if (e->rtti() == RS2::EntityInsert) {
+            static_cast<RS_Insert*>(e)->update();
+        }
+    }
+}
+
+void LC_TransformUndoable::transform(RS_Entity* e, const Step& step, bool inverse) const
+{
+    switch (step.type) {
+    case Move:
+        e->move(inverse ? -step.v1 : step.v1);
+        break;
+    case Rotate:
+        e->rotate(step.v1, inverse ? -step.angle : step.angle);
+        break;
+    case Scale:
+        e->scale(step.v1, inverse ? RS_Vector(1. / step.v2.x, 1. / step.v2.y) : step.v2);
+        break;
+    case Mirror:
+        e->mirror(step.v1, step.v2);
+        break;
+    }
+}
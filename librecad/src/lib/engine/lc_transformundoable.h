@@ -0,0 +1,115 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2018 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+#ifndef LC_TRANSFORMUNDOABLE_H
+#define LC_TRANSFORMUNDOABLE_H
+
+#include <vector>
+#include "rs_undoable.h"
+#include "rs_vector.h"
+
+class LC_BulkEdit;
+class RS_Entity;
+class RS_EntityContainer;
+
+/** \brief Undoable transformation of entities in place
+ *
+ * Instead of replacing the entities by transformed clones, move, rotate,
+ * scale and mirror modifications transform the entities themselves and
+ * record the transformation here. Undo applies the inverse transformation,
+ * redo applies the transformation again.
+ *
+ * The transformation is a short list of steps, e.g. a move followed by a
+ * rotation. Undo cycles own their transformation undoables.
+ */
+class LC_TransformUndoable : public RS_Undoable
+{
+public:
+    /**
+     * @param container Container the entities are direct children of.
+     * @param entities Entities to transform.
+     */
+    LC_TransformUndoable(RS_EntityContainer* container,
+                         std::vector<RS_Entity*> entities);
+
+    RS2::UndoableType undoRtti() const override {
+        return RS2::UndoableTransform;
+    }
+
+    //! \{ append a step to the transformation
+    void move(const RS_Vector& offset);
+    void rotate(const RS_Vector& center, double angle);
+    void scale(const RS_Vector& center, const RS_Vector& factor);
+    void mirror(const RS_Vector& axisPoint1, const RS_Vector& axisPoint2);
+    //! \}
+
+    //! transform the entities, done once after the steps were appended
+    void apply(LC_BulkEdit& edit);
+
+    /**
+     * @return false, if mirroring the entity twice does not restore it, e.g.
+     * a hatch adds the axis angle to its pattern angle and a text keeps its
+     * letters readable. Such entities are replaced by mirrored clones.
+     */
+    static bool canMirrorBack(RS_Entity const* e);
+
+    //! transformations applied later have higher sequence numbers
+    unsigned long getSequence() const {
+        return sequence;
+    }
+    size_t count() const {
+        return entities.size();
+    }
+    const std::vector<RS_Entity*>& getEntities() const {
+        return entities;
+    }
+
+    void undoStateChanged(bool undone) override;
+
+private:
+    enum StepType {
+        Move,
+        Rotate,
+        Scale,
+        Mirror
+    };
+    struct Step {
+        StepType type;
+        RS_Vector v1;
+        RS_Vector v2;
+        double angle;
+    };
+
+    //! apply all steps, or their inverse steps in reverse order
+    void transform(bool inverse, LC_BulkEdit& edit);
+    void transform(RS_Entity* e, const Step& step, bool inverse) const;
+
+    RS_EntityContainer* container;
+    std::vector<RS_Entity*> entities;
+    std::vector<Step> steps;
+    unsigned long sequence;
+};
+
+#endif // LC_TRANSFORMUNDOABLE_H
@@ -152,7 +152,8 @@ public:
         EntityOverlayBox,    /**< OverlayBox */
         EntityPreview,    /**< Preview Container */
         EntityPattern,
-        EntityOverlayLine
+        EntityOverlayLine,
+        EntityGlyphRun      /**< Letters of a text */
     };
 
 
@@ -435,7 +436,8 @@ public:
     enum UndoableType {
         UndoableUnknown,    /**< Unknown undoable */
         UndoableEntity,     /**< Entity */
-        UndoableLayer       /**< Layer */
+        UndoableLayer,      /**< Layer */
+        UndoableTransform   /**< Transformation of entities in place */
     };
 
     /**
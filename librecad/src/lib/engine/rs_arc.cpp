@@ -454,8 +454,9 @@ RS_Vector RS_Arc::getNearestMiddle(const RS_Vector& coord,
         double angle=getCenter().angleTo(vp);
         int counts=middlePoints+1;
         int i( static_cast<int>(fmod(angle-amin+2.*M_PI,2.*M_PI)/da*counts+0.5));
-        if(!i) i++; // remove end points
-        if(i==counts) i--;
+        // remove end points, rounding may put the nearest point just outside the arc
+        if(i<1) i=1;
+        if(i>=counts) i=counts-1;
         angle=amin + da*(double(i)/double(counts));
         vp.setPolar(getRadius(), angle);
         vp.move(getCenter());
@@ -27,8 +27,11 @@
 #include<iostream>
 #include "rs_block.h"
 
+#include "lc_spatialindex.h"
+#include "rs_debug.h"
 #include "rs_graphic.h"
 #include "rs_insert.h"
+#include "rs_layer.h"
 
 RS_BlockData::RS_BlockData(const QString& _name,
 						   const RS_Vector& _basePoint,
@@ -195,6 +198,64 @@ QStringList RS_Block::findNestedInsert(const QString& bName) {
     return bnChain;
 }
 
+/**
+ * The entities of nested inserts are resolved for all rows and cols, so
+ * inserts of this block map the geometry without a further lookup.
+ * Entities on layer "0" are kept without a layer, they are drawn on the
+ * layer of the insert.
+ */
+const RS_BlockGeometry* RS_Block::getGeometry() {
+    if (geometry) {
+        return geometry.get();
+    }
+    if (buildingGeometry) {
+        RS_DEBUG->print(RS_Debug::D_WARNING,
+                        "RS_Block::getGeometry: block %s inserts itself",
+                        data.name.toLatin1().data());
+        return nullptr;
+    }
+    buildingGeometry = true;
+
+    std::shared_ptr<RS_BlockGeometry> g = std::make_shared<RS_BlockGeometry>();
+    RS_Vector const offset = data.basePoint*-1;
+    for (RS_Entity* e: entities) {
+        if (e->rtti()==RS2::EntityInsert) {
+            // hidden inserts hide the entities on their own layers too
+            if (e->isVisible()) {
+                static_cast<RS_Insert*>(e)->appendFlattened(g->entities, offset);
+            }
+        } else {
+            RS_Entity* ne = e->clone();
+            ne->move(offset);
+            ne->reparent(&g->entities);
+            g->entities.appendEntity(ne);
+        }
+    }
+
+    for (RS_Entity* e: g->entities) {
+        RS_Layer* l = e->getLayer(false);
+        if (l && l->getName()=="0") {
+            e->setLayer(static_cast<RS_Layer*>(nullptr));
+        }
+
+        LC_SpatialIndex::Box box;
+        if (LC_SpatialIndex::entityBox(e, box)) {
+            g->extentMin = RS_Vector::minimum(g->extentMin, {box.minX, box.minY});
+            g->extentMax = RS_Vector::maximum(g->extentMax, {box.maxX, box.maxY});
+        } else if (e->rtti()==RS2::EntityConstructionLine) {
+            g->bounded = false;
+        }
+    }
+
+    buildingGeometry = false;
+    geometry = g;
+    return geometry.get();
+}
+
+void RS_Block::invalidateGeometry() {
+    geometry.reset();
+}
+
 std::ostream& operator << (std::ostream& os, const RS_Block& b) {
     os << " name: " << b.getName().toLatin1().data() << "\n";
     os << " entities: " << (RS_EntityContainer&)b << "\n";
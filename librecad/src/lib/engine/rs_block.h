@@ -28,6 +28,7 @@
 #ifndef RS_BLOCK_H
 #define RS_BLOCK_H
 
+#include <memory>
 #include "rs_document.h"
 
 /**
@@ -59,6 +60,22 @@ struct RS_BlockData {
 
 
 
+/**
+ * The entities of a block relative to its base point, with the entities
+ * of nested inserts resolved. All inserts of a block share its geometry
+ * and map it into the drawing when they are drawn or queried.
+ */
+struct RS_BlockGeometry {
+	RS_EntityContainer entities;
+	//! all points reported by queries on the entities, e.g. centers of arcs
+	RS_Vector extentMin {RS_MAXDOUBLE, RS_MAXDOUBLE};
+	RS_Vector extentMax {RS_MINDOUBLE, RS_MINDOUBLE};
+	//! false, if the entities reach out of any box, e.g. construction lines
+	bool bounded {true};
+};
+
+
+
 /**
  * A block is a group of entities. A block unlike an other entity
  * container has a base point which defines the offset of the
@@ -219,9 +236,26 @@ public:
      */
     QStringList findNestedInsert(const QString& bName);
 
+	/**
+	 * @return the geometry shared by the inserts of this block, built on
+	 * first use, nullptr if the block is inserted into itself
+	 */
+	const RS_BlockGeometry* getGeometry();
+	/**
+	 * Drops the geometry after the entities of this block or of a nested
+	 * block changed.
+	 */
+	void invalidateGeometry();
+
 protected:
 	//! Block data
 	RS_BlockData data;
+
+private:
+	//! shared with clones of this block until one of them changes
+	std::shared_ptr<RS_BlockGeometry> geometry;
+	//! the geometry is being built, guards against recursive blocks
+	bool buildingGeometry {false};
 };
 
 
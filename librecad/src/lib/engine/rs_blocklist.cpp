@@ -53,6 +53,7 @@ RS_BlockList::RS_BlockList(bool owner) {
  */
 void RS_BlockList::clear() {
     blocks.clear();
+    blocksByName.clear();
 	activeBlock = nullptr;
 	setModified(true);
 }
@@ -98,6 +99,7 @@ bool RS_BlockList::add(RS_Block* block, bool notify) {
     RS_Block* b = find(block->getName());
 	if (!b) {
         blocks.append(block);
+        blocksByName.insert(block->getName(), block);
 
         if (notify) {
             addNotification();
@@ -140,6 +142,9 @@ void RS_BlockList::remove(RS_Block* block) {
 
     // here the block is removed from the list but not deleted
     blocks.removeOne(block);
+    if (block && blocksByName.value(block->getName())==block) {
+        blocksByName.remove(block->getName());
+    }
 
 	for(auto l: blockListListeners){
 		l->blockRemoved(block);
@@ -173,6 +178,10 @@ void RS_BlockList::remove(RS_Block* block) {
 bool RS_BlockList::rename(RS_Block* block, const QString& name) {
 	if (block) {
 		if (!find(name)) {
+			if (blocksByName.value(block->getName())==block) {
+				blocksByName.remove(block->getName());
+				blocksByName.insert(name, block);
+			}
 			block->setName(name);
 			setModified(true);
 			return true;
@@ -212,15 +221,11 @@ RS_Block* RS_BlockList::find(const QString& name) {
         RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_BlockList::find(): wrong name to find");
         return nullptr;
     }
-	// Todo : reduce this from O(N) to O(log(N)) complexity based on sorted list or hash
-	//DFS
-	for(RS_Block* b: blocks) {
-		if (b->getName()==name) {
-			return b;
-		}
+	RS_Block* b = blocksByName.value(name, nullptr);
+	if (!b) {
+		RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_BlockList::find(): bad");
 	}
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_BlockList::find(): bad");
-	return nullptr;
+	return b;
 }
 
 /**
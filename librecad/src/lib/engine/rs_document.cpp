@@ -26,8 +26,15 @@
 **********************************************************************/
 
 
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
 #include "rs_document.h"
+#include "lc_transformundoable.h"
+#include "rs_block.h"
+#include "rs_blocklist.h"
 #include "rs_debug.h"
+#include "rs_insert.h"
 
 
 /**
@@ -49,6 +56,17 @@ RS_Document::RS_Document(RS_EntityContainer* parent)
     activePen = RS_Pen(col, RS2::WidthByLayer, RS2::LineByLayer);
 
     gv = NULL;//used to read/save current view
+    trackSelection();
+}
+
+
+RS_Document::~RS_Document()
+{
+    if (isOwner()) {
+        for (auto const& p: undoneEntities) {
+            delete p.first;
+        }
+    }
 }
 
 /**
@@ -63,3 +81,201 @@ void RS_Document::endUndoCycle()
     RS_Undo::endUndoCycle();
 }
 
+
+
+
+void RS_Document::updateInserts()
+{
+    // the blocks may have changed, their geometry is built again
+    if (RS_BlockList* blocks = getBlockList()) {
+        for (RS_Block* blk: *blocks) {
+            blk->invalidateGeometry();
+        }
+    }
+    RS_EntityContainer::updateInserts();
+    for (auto const& p: undoneEntities) {
+        RS_Entity* e = p.first;
+        if (e->rtti()==RS2::EntityInsert) {
+            static_cast<RS_Insert*>(e)->update();
+        } else if (e->isContainer() && e->rtti()!=RS2::EntityHatch) {
+            static_cast<RS_EntityContainer*>(e)->updateInserts();
+        }
+    }
+}
+
+
+/**
+ * Renames the inserts kept for redo as well, so they still find their
+ * block when they are restored.
+ */
+void RS_Document::renameInserts(const QString& oldName,
+                                const QString& newName)
+{
+    RS_EntityContainer::renameInserts(oldName, newName);
+    for (auto const& p: undoneEntities) {
+        RS_Entity* e = p.first;
+        if (e->rtti()==RS2::EntityInsert) {
+            RS_Insert* i = static_cast<RS_Insert*>(e);
+            if (i->getName()==oldName) {
+                i->setName(newName);
+            }
+        } else if (e->isContainer()) {
+            static_cast<RS_EntityContainer*>(e)->renameInserts(oldName, newName);
+        }
+    }
+}
+
+
+
+/**
+ * Removes an entity from the entiy container. Implementation
+ * from RS_Undo.
+ */
+void RS_Document::removeUndoable(RS_Undoable* u)
+{
+    removeUndoables(std::vector<RS_Undoable*>{u});
+}
+
+
+void RS_Document::removeUndoables(std::vector<RS_Undoable*> const& undoables)
+{
+    std::unordered_set<RS_Entity*> listed;
+    for (auto u: undoables) {
+        if (!u || u->undoRtti()!=RS2::UndoableEntity || !u->isUndone()) {
+            continue;
+        }
+        RS_Entity* e = static_cast<RS_Entity*>(u);
+        auto it = undoneEntities.find(e);
+        if (it == undoneEntities.end()) {
+            listed.insert(e);
+            continue;
+        }
+        undoneEntities.erase(it);
+        if (isOwner()) {
+            delete e;
+        }
+    }
+    if (listed.empty()) {
+        return;
+    }
+
+    std::vector<RS_Entity*> kept;
+    std::vector<RS_Entity*> dropped;
+    kept.reserve(entities.size());
+    for (RS_Entity* e: entities) {
+        if (listed.count(e)) {
+            dropped.push_back(e);
+        } else {
+            kept.push_back(e);
+        }
+    }
+    if (!dropped.empty()) {
+        // one border recalculation instead of one per removed entity
+        replaceEntities(kept, std::vector<RS_Entity*>(), dropped);
+    }
+}
+
+
+void RS_Document::clear()
+{
+    if (isOwner()) {
+        for (auto const& p: undoneEntities) {
+            delete p.first;
+        }
+    }
+    undoneEntities.clear();
+    RS_EntityContainer::clear();
+}
+
+
+/**
+ * Takes the undone entities out of the entity list and puts restored ones
+ * back where they were, in a single pass over the list. Without this undone
+ * entities would stay in the list until their undo cycle is dropped and
+ * slow down every loop over the document.
+ */
+void RS_Document::undoablesChanged(std::set<RS_Undoable*> const& undoables)
+{
+    std::unordered_set<RS_Entity*> undone;
+    std::vector<std::pair<std::pair<int, unsigned long>, RS_Entity*>> restored;
+    for (auto u: undoables) {
+        if (u->undoRtti() != RS2::UndoableEntity) {
+            continue;
+        }
+        RS_Entity* e = static_cast<RS_Entity*>(u);
+        if (e->getParent() != this) {
+            continue;
+        }
+        if (e->getFlag(RS2::FlagUndone)) {
+            undone.insert(e);
+            continue;
+        }
+        auto it = undoneEntities.find(e);
+        if (it != undoneEntities.end()) {
+            restored.emplace_back(it->second, e);
+            undoneEntities.erase(it);
+        }
+    }
+    if (undone.empty() && restored.empty()) {
+        return;
+    }
+    std::sort(restored.begin(), restored.end());
+
+    QList<RS_Entity*> list;
+    list.reserve(entities.size() + int(restored.size()));
+    auto next = restored.cbegin();
+    int kept = 0;
+    for (RS_Entity* e: entities) {
+        // restored entities go before the first entity which was not in
+        // front of them when they were taken out
+        for (; next != restored.cend() && next->first.first <= kept; ++next) {
+            list.append(next->second);
+        }
+        if (undone.count(e)) {
+            undoneEntities[e] = std::make_pair(list.size(), undoneCounter++);
+            unlistEntity(e);
+            continue;
+        }
+        list.append(e);
+        ++kept;
+    }
+    for (; next != restored.cend(); ++next) {
+        list.append(next->second);
+    }
+    entities.swap(list);
+    for (auto const& p: restored) {
+        listEntity(p.second);
+    }
+
+    if (restored.empty()) {
+        for (RS_Entity* e: undone) {
+            entityRemoved(e);
+        }
+    } else {
+        // the index orders entities like the list, restored ones go in between
+        invalidateSpatialIndex();
+    }
+    if (autoUpdateBorders) {
+        for (auto const& p: restored) {
+            adjustBorders(p.second);
+        }
+    }
+}
+
+
+/**
+ * A rough estimate of the memory held by an entity, so the undo history can
+ * be limited in bytes.
+ */
+size_t RS_Document::undoableMemory(RS_Undoable* u) const
+{
+    constexpr size_t bytesPerEntity = 512;
+    if (u->undoRtti() == RS2::UndoableTransform) {
+        return bytesPerEntity + sizeof(RS_Entity*)
+                * static_cast<LC_TransformUndoable*>(u)->count();
+    }
+    if (u->undoRtti() != RS2::UndoableEntity) {
+        return bytesPerEntity;
+    }
+    return std::max(1u, static_cast<RS_Entity*>(u)->countDeep()) * bytesPerEntity;
+}
@@ -29,6 +29,8 @@
 #ifndef RS_DOCUMENT_H
 #define RS_DOCUMENT_H
 
+#include <unordered_map>
+#include <utility>
 #include "rs_layerlist.h"
 #include "rs_entitycontainer.h"
 #include "rs_undo.h"
@@ -47,7 +49,7 @@ class RS_Document : public RS_EntityContainer,
     public RS_Undo {
 public:
 	RS_Document(RS_EntityContainer* parent=nullptr);
-	virtual ~RS_Document() = default;
+	virtual ~RS_Document();
 
     virtual RS_LayerList* getLayerList() = 0;
     virtual RS_BlockList* getBlockList() = 0;
@@ -70,11 +72,16 @@ public:
      * Removes an entity from the entiy container. Implementation
      * from RS_Undo.
      */
-    virtual void removeUndoable(RS_Undoable* u) {
-        if (u && u->undoRtti()==RS2::UndoableEntity && u->isUndone()) {
-			removeEntity(static_cast<RS_Entity*>(u));
-        }
-    }
+    virtual void removeUndoable(RS_Undoable* u);
+    /**
+     * Removes the given entities in one pass over the entity list.
+     */
+    virtual void removeUndoables(std::vector<RS_Undoable*> const& undoables) override;
+
+    /**
+     * Erases all entities, including the undone ones kept for redo.
+     */
+    virtual void clear() override;
 
     /**
      * @return Currently active drawing pen.
@@ -133,10 +140,33 @@ public:
      */
     virtual void endUndoCycle() override;
 
+    /**
+     * Overwritten to also update the undone entities, which are kept
+     * out of the entity list, and to build the block geometry again.
+     */
+    void updateInserts() override;
+    void renameInserts(const QString& oldName,
+                       const QString& newName) override;
+
     void setGraphicView(RS_GraphicView * g) {gv = g;}
     RS_GraphicView* getGraphicView() {return gv;}
 
 protected:
+    /**
+     * Moves entities which were undone out of the entity list and restored
+     * ones back into it.
+     */
+    virtual void undoablesChanged(std::set<RS_Undoable*> const& undoables) override;
+    virtual size_t undoableMemory(RS_Undoable* u) const override;
+
+    /**
+     * Undone entities taken out of the entity list. Each one maps to the
+     * number of entities which were before it in the list and the order in
+     * which it was taken out, to put it back in place when it is restored.
+     */
+    std::unordered_map<RS_Entity*, std::pair<int, unsigned long>> undoneEntities;
+    unsigned long undoneCounter {0};
+
     /** Flag set if the document was modified and not yet saved. */
     bool modified;
     /** Active pen. */
@@ -500,8 +500,8 @@ RS_Vector RS_Ellipse::getNearestPointOnEntity(const RS_Vector& coord,
     double twoax=2*a*x;
     double twoby=2*b*y;
     double a0=twoa2b2*twoa2b2;
-    std::vector<double> ce(4,0.);
-    std::vector<double> roots(0,0.);
+    std::array<double, 4> ce{{0., 0., 0., 0.}};
+    RS_Math::Roots<4> roots;
 
     //need to handle a=b
     if(a0 > RS_TOLERANCE2 ) { // a != b , ellipse
@@ -510,7 +510,7 @@ RS_Vector RS_Ellipse::getNearestPointOnEntity(const RS_Vector& coord,
         ce[2]= - ce[0];
         ce[3]= -twoax*twoax/a0;
         //std::cout<<"1::find cosine, variable c, solve(c^4 +("<<ce[0]<<")*c^3+("<<ce[1]<<")*c^2+("<<ce[2]<<")*c+("<<ce[3]<<")=0,c)\n";
-        roots=RS_Math::quarticSolver(ce);
+        roots=RS_Math::quarticRoots(ce);
     } else {//a=b, quadratic equation for circle
         a0=twoby/twoax;
         roots.push_back(sqrt(1./(1.+a0*a0)));
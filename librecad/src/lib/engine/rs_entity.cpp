@@ -63,6 +63,14 @@ RS_Entity::RS_Entity(RS_EntityContainer* parent) {
 }
 
 
+RS_Entity::~RS_Entity()
+{
+    if (listedIn.container) {
+        listedIn.container->unlistEntity(this);
+    }
+}
+
+
 /**
  * Copy constructor.
  */
@@ -139,6 +147,9 @@ bool RS_Entity::setSelected(bool select) {
     } else {
         delFlag(RS2::FlagSelected);
     }
+    if (listedIn.container) {
+        listedIn.container->selectionChanged(this);
+    }
 
     return true;
 }
@@ -61,7 +61,7 @@ class QString;
 class RS_Entity : public RS_Undoable {
 public:
 	RS_Entity(RS_EntityContainer* parent=nullptr);
-	virtual ~RS_Entity() = default;
+	virtual ~RS_Entity();
 
     void init();
     virtual void initId();
@@ -194,7 +194,7 @@ public:
 	bool isParentSelected() const;
     virtual bool isProcessed() const;
     virtual void setProcessed(bool on);
-	bool isInWindow(RS_Vector v1, RS_Vector v2) const;
+	virtual bool isInWindow(RS_Vector v1, RS_Vector v2) const;
     virtual bool hasEndpointsWithinWindow(const RS_Vector& /*v1*/, const RS_Vector& /*v2*/) {
         return false;
     }
@@ -579,7 +579,22 @@ protected:
     bool updateEnabled;
 
 private:
+	friend class RS_EntityContainer;
+	//! not copied, a clone is not listed anywhere until it is added
+	struct ListingContainer {
+		RS_EntityContainer* container = nullptr;
+		//! last known index in the entity list of the container
+		mutable int position = -1;
+		ListingContainer() = default;
+		ListingContainer(const ListingContainer&) {}
+		ListingContainer& operator = (const ListingContainer&) {
+			return *this;
+		}
+	};
+
 	std::map<QString, QString> varList;
+	//! the container which keeps this entity in its selection set
+	ListingContainer listedIn;
 };
 
 #endif
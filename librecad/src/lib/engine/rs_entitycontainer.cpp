@@ -26,12 +26,20 @@
 
 #include <iostream>
 #include <cmath>
+#include <algorithm>
+#include <climits>
+#include <limits>
 #include <set>
+#include <unordered_map>
 #include <QObject>
 
 #include "rs_dialogfactory.h"
 #include "qg_dialogfactory.h"
 #include "rs_entitycontainer.h"
+#include "lc_endpointmap.h"
+#include "lc_glyphrun.h"
+#include "lc_rect.h"
+#include "lc_spatialindex.h"
 
 #include "rs_debug.h"
 #include "rs_dimension.h"
@@ -48,6 +56,82 @@
 
 bool RS_EntityContainer::autoUpdateBorders = true;
 
+namespace {
+//! containers with fewer children are always scanned linearly
+constexpr int spatialIndexThreshold = 512;
+
+/**
+ * @return true, if firstEntity(level) and nextEntity(level) descend into
+ * the given entity
+ */
+bool isResolved(RS_Entity const* entity, RS2::ResolveLevel level)
+{
+	if (!entity->isContainer())
+		return false;
+	switch (level) {
+	case RS2::ResolveAll:
+		return true;
+	case RS2::ResolveAllButInserts:
+		return entity->rtti() != RS2::EntityInsert;
+	case RS2::ResolveAllButTextImage:
+	case RS2::ResolveAllButTexts:
+		return entity->rtti() != RS2::EntityText && entity->rtti() != RS2::EntityMText;
+	default:
+		return false;
+	}
+}
+
+/**
+ * @brief crossesWindow whether an atomic entity has any point inside the
+ * window, lines are clipped to the window, other entities are intersected
+ * with its borders
+ * @param borders the four border lines of the window
+ */
+bool crossesWindow(RS_Entity* entity, const LC_Rect& window,
+				   RS_EntityContainer& borders)
+{
+	if (entity->rtti() == RS2::EntityConstructionLine) {
+		RS_Vector p1 = static_cast<RS_ConstructionLine*>(entity)->getPoint1();
+		RS_Vector p2 = static_cast<RS_ConstructionLine*>(entity)->getPoint2();
+		return window.clipLine(p1, p2, true);
+	}
+
+	// boxes fully outside or inside the window need no exact test
+	LC_Rect const box(entity->getMin(), entity->getMax());
+	if (!window.intersects(box))
+		return false;
+	if (box.inArea(window))
+		return true;
+
+	switch (entity->rtti()) {
+	case RS2::EntityLine: {
+		RS_Vector p1 = static_cast<RS_Line*>(entity)->getStartpoint();
+		RS_Vector p2 = static_cast<RS_Line*>(entity)->getEndpoint();
+		return window.clipLine(p1, p2);
+	}
+	case RS2::EntitySolid:
+		return static_cast<RS_Solid*>(entity)->isInCrossWindow(window.minP(),
+																window.maxP());
+	case RS2::EntityGlyphRun:
+		return static_cast<LC_GlyphRun*>(entity)->isInCrossWindow(window.minP(),
+																   window.maxP());
+	default:
+		break;
+	}
+
+	if (entity->isAtomic()) {
+		RS_Vector const start = static_cast<RS_AtomicEntity*>(entity)->getStartpoint();
+		if (start.valid && window.inArea(start))
+			return true;
+	}
+	for (RS_Entity* border: borders) {
+		if (RS_Information::getIntersection(entity, border, true).hasValid())
+			return true;
+	}
+	return false;
+}
+}
+
 /**
  * Default constructor.
  *
@@ -67,14 +151,33 @@ RS_EntityContainer::RS_EntityContainer(RS_EntityContainer* parent,
 
 
 /**
- * Copy constructor. Makes a deep copy of all entities.
+ * Copy constructor. Makes a shallow copy, call detach() to create
+ * deep copies of all entities.
  */
-/*
-RS_EntityContainer::RS_EntityContainer(const RS_EntityContainer& ec)
- : RS_Entity(ec) {
+RS_EntityContainer::RS_EntityContainer(const RS_EntityContainer& other)
+    : RS_Entity(other)
+    , entities(other.entities)
+    , subContainer(other.subContainer)
+    , entIdx(other.entIdx)
+    , autoDelete(other.autoDelete)
+{
+}
 
+RS_EntityContainer& RS_EntityContainer::operator = (const RS_EntityContainer& other)
+{
+    if (this != &other) {
+        RS_Entity::operator = (other);
+        // like a copy, the assigned container does not track its selection
+        unlistEntities();
+        selection.reset();
+        entities = other.entities;
+        subContainer = other.subContainer;
+        entIdx = other.entIdx;
+        autoDelete = other.autoDelete;
+        spatialIndex.reset();
+    }
+    return *this;
 }
-*/
 
 
 
@@ -82,6 +185,7 @@ RS_EntityContainer::RS_EntityContainer(const RS_EntityContainer& ec)
  * Destructor.
  */
 RS_EntityContainer::~RS_EntityContainer() {
+    unlistEntities();
     if (autoDelete) {
         while (!entities.isEmpty())
             delete entities.takeFirst();
@@ -128,13 +232,16 @@ void RS_EntityContainer::detach() {
     }
 
     // clear shared pointers:
+    unlistEntities();
     entities.clear();
     setOwner(autoDel);
+    invalidateSpatialIndex();
 
     // point to new deep copies:
 	for(auto e: tmp){
         entities.append(e);
         e->reparent(this);
+        listEntity(e);
     }
 }
 
@@ -238,53 +345,31 @@ bool RS_EntityContainer::toggleSelected() {
 void RS_EntityContainer::selectWindow(RS_Vector v1, RS_Vector v2,
                                       bool select, bool cross) {
 
-    bool included;
-
-	for(auto e: entities){
-
-        included = false;
+	LC_Rect const window = LC_Rect(v1, v2).increaseBy(RS_TOLERANCE);
+	RS_EntityContainer borders;
+	if (cross) {
+		borders.addRectangle(v1, v2);
+	}
 
-        if (e->isVisible()) {
-            if (e->isInWindow(v1, v2)) {
-                //e->setSelected(select);
-                included = true;
-			} else if (cross) {
-				RS_EntityContainer l;
-				l.addRectangle(v1, v2);
-                RS_VectorSolutions sol;
-
-                if (e->isContainer()) {
-                    RS_EntityContainer* ec = (RS_EntityContainer*)e;
-                    for (RS_Entity* se=ec->firstEntity(RS2::ResolveAll);
-						 se && included==false;
-                         se=ec->nextEntity(RS2::ResolveAll)) {
-
-                        if (se->rtti() == RS2::EntitySolid){
-							included = static_cast<RS_Solid*>(se)->isInCrossWindow(v1,v2);
-                        } else {
-							for (auto line: l) {
-                                sol = RS_Information::getIntersection(
-											se, line, true);
-                                if (sol.hasValid()) {
-                                    included = true;
-                                    break;
-                                }
-                            }
-                        }
-                    }
-                } else if (e->rtti() == RS2::EntitySolid){
-					included = static_cast<RS_Solid*>(e)->isInCrossWindow(v1,v2);
-                } else {
-					for (auto line: l) {
-						sol = RS_Information::getIntersection(e, line, true);
-                        if (sol.hasValid()) {
-                            included = true;
-                            break;
-                        }
-                    }
-                }
-            }
-        }
+	// entities inside the window or crossing it overlap it
+	for (RS_Entity* e: getEntitiesOverlappingWindow(v1, v2)) {
+		if (!e->isVisible()) {
+			continue;
+		}
+
+		bool included = e->isInWindow(v1, v2);
+		if (!included && cross) {
+			if (e->isContainer()) {
+				RS_EntityContainer* ec = static_cast<RS_EntityContainer*>(e);
+				for (RS_Entity* se=ec->firstEntity(RS2::ResolveAll);
+					 se && !included;
+					 se=ec->nextEntity(RS2::ResolveAll)) {
+					included = crossesWindow(se, window, borders);
+				}
+			} else {
+				included = crossesWindow(e, window, borders);
+			}
+		}
 
         if (included) {
             e->setSelected(select);
@@ -313,15 +398,21 @@ void RS_EntityContainer::addEntity(RS_Entity* entity) {
 
 	if (!entity) return;
 
-    if (entity->rtti()==RS2::EntityImage ||
-            entity->rtti()==RS2::EntityHatch) {
+    bool const front = entity->rtti()==RS2::EntityImage ||
+            entity->rtti()==RS2::EntityHatch;
+    if (front) {
         entities.prepend(entity);
     } else {
         entities.append(entity);
     }
+    listEntity(entity);
+    if (spatialIndex) {
+        spatialIndex->insert(entity, front);
+    }
     if (autoUpdateBorders) {
         adjustBorders(entity);
     }
+    notifyParent();
 }
 
 
@@ -333,8 +424,12 @@ void RS_EntityContainer::appendEntity(RS_Entity* entity){
 	if (!entity)
         return;
     entities.append(entity);
+    listEntity(entity);
+    if (spatialIndex)
+        spatialIndex->insert(entity);
     if (autoUpdateBorders)
         adjustBorders(entity);
+    notifyParent();
 }
 
 /**
@@ -344,8 +439,12 @@ void RS_EntityContainer::appendEntity(RS_Entity* entity){
 void RS_EntityContainer::prependEntity(RS_Entity* entity){
 	if (!entity) return;
     entities.prepend(entity);
+    listEntity(entity);
+    if (spatialIndex)
+        spatialIndex->insert(entity, true);
     if (autoUpdateBorders)
         adjustBorders(entity);
+    notifyParent();
 }
 
 /**
@@ -381,6 +480,7 @@ void RS_EntityContainer::moveEntity(int index, QList<RS_Entity *>& entList){
 	for(auto e: entList){
             entities.insert(ci++, e);
     }
+    invalidateSpatialIndex();
 }
 
 /**
@@ -391,6 +491,8 @@ void RS_EntityContainer::insertEntity(int index, RS_Entity* entity) {
 	if (!entity) return;
 
     entities.insert(index, entity);
+    listEntity(entity);
+    invalidateSpatialIndex();
 
     if (autoUpdateBorders) {
         adjustBorders(entity);
@@ -430,6 +532,12 @@ bool RS_EntityContainer::removeEntity(RS_Entity* entity) {
 	//    in LibreCAD is never called with nullptr
     bool ret;
     ret = entities.removeOne(entity);
+    if (ret) {
+        unlistEntity(entity);
+        if (spatialIndex) {
+            spatialIndex->remove(entity);
+        }
+    }
 
     if (autoDelete && ret) {
         delete entity;
@@ -437,6 +545,7 @@ bool RS_EntityContainer::removeEntity(RS_Entity* entity) {
     if (autoUpdateBorders) {
         calculateBorders();
     }
+    notifyParent();
     return ret;
 }
 
@@ -446,12 +555,15 @@ bool RS_EntityContainer::removeEntity(RS_Entity* entity) {
  * Erases all entities in this container and resets the borders..
  */
 void RS_EntityContainer::clear() {
+    unlistEntities();
     if (autoDelete) {
         while (!entities.isEmpty())
             delete entities.takeFirst();
     } else
         entities.clear();
+    spatialIndex.reset();
     resetBorders();
+    notifyParent();
 }
 
 unsigned int RS_EntityContainer::count() const{
@@ -479,6 +591,20 @@ unsigned int RS_EntityContainer::countSelected(bool deep, std::initializer_list<
     unsigned int c=0;
 	std::set<RS2::EntityType> type = types;
 
+	// selected children of unselected sub-containers are not in the set,
+	// they are only selected together with their container
+	if (selection) {
+		for (RS_Entity* t: *selection) {
+			if (!t->isSelected())
+				continue;
+			if (!types.size() || type.count(t->rtti()))
+				c++;
+			if (t->isContainer())
+				c += static_cast<RS_EntityContainer*>(t)->countSelected(deep);
+		}
+		return c;
+	}
+
 	for (RS_Entity* t: entities){
 
 		if (t->isSelected())
@@ -497,7 +623,7 @@ unsigned int RS_EntityContainer::countSelected(bool deep, std::initializer_list<
  */
 double RS_EntityContainer::totalSelectedLength() {
     double ret(0.0);
-	for (RS_Entity* e: entities){
+	for (RS_Entity* e: selectedEntities()){
 
         if (e->isVisible() && e->isSelected()) {
             double l = e->getLength();
@@ -519,8 +645,10 @@ void RS_EntityContainer::adjustBorders(RS_Entity* entity) {
 
 	if (entity) {
         // make sure a container is not empty (otherwise the border
-        //   would get extended to 0/0):
-        if (!entity->isContainer() || entity->count()>0) {
+        //   would get extended to 0/0), inserts map their borders from
+        //   the block:
+        if (!entity->isContainer() || entity->count()>0
+                || entity->rtti()==RS2::EntityInsert) {
             minV = RS_Vector::minimum(entity->getMin(),minV);
             maxV = RS_Vector::maximum(entity->getMax(),maxV);
         }
@@ -540,6 +668,8 @@ void RS_EntityContainer::adjustBorders(RS_Entity* entity) {
 void RS_EntityContainer::calculateBorders() {
     RS_DEBUG->print("RS_EntityContainer::calculateBorders");
 
+	// children recalculate their borders, too
+	invalidateSpatialIndex();
 	resetBorders();
 	for (RS_Entity* e: entities){
 
@@ -597,12 +727,13 @@ void RS_EntityContainer::calculateBorders() {
 void RS_EntityContainer::forcedCalculateBorders() {
     //RS_DEBUG->print("RS_EntityContainer::calculateBorders");
 
+    invalidateSpatialIndex();
     resetBorders();
     for (RS_Entity* e: entities){
 
         //RS_Layer* layer = e->getLayer();
 
-        if (e->isContainer()) {
+        if (e->isContainer() && e->rtti()!=RS2::EntityInsert) {
             ((RS_EntityContainer*)e)->forcedCalculateBorders();
         } else {
             e->calculateBorders();
@@ -639,6 +770,7 @@ void RS_EntityContainer::forcedCalculateBorders() {
 void RS_EntityContainer::updateDimensions(bool autoText) {
 
     RS_DEBUG->print("RS_EntityContainer::updateDimensions()");
+    invalidateSpatialIndex();
 
     //for (RS_Entity* e=firstEntity(RS2::ResolveNone);
 	//        e;
@@ -666,6 +798,7 @@ void RS_EntityContainer::updateDimensions(bool autoText) {
 void RS_EntityContainer::updateInserts() {
 
     RS_DEBUG->print("RS_EntityContainer::updateInserts() ID/type: %d/%d", getId(), rtti());
+    invalidateSpatialIndex();
 
     for (RS_Entity* e: entities){
         //// Only update our own inserts and not inserts of inserts
@@ -721,6 +854,7 @@ void RS_EntityContainer::renameInserts(const QString& oldName,
 void RS_EntityContainer::updateSplines() {
 
     RS_DEBUG->print("RS_EntityContainer::updateSplines()");
+    invalidateSpatialIndex();
 
 	for (RS_Entity* e: entities){
         //// Only update our own inserts and not inserts of inserts
@@ -739,6 +873,7 @@ void RS_EntityContainer::updateSplines() {
  * Updates the sub entities of this container.
  */
 void RS_EntityContainer::update() {
+	invalidateSpatialIndex();
 	for (RS_Entity* e: entities){
 		e->update();
     }
@@ -1103,10 +1238,17 @@ RS_Entity* RS_EntityContainer::entityAt(int index) {
 }
 
 void RS_EntityContainer::setEntityAt(int index,RS_Entity* en){
+	if (entities.at(index)) {
+		unlistEntity(entities.at(index));
+	}
 	if(autoDelete && entities.at(index)) {
 		delete entities.at(index);
 	}
 	entities[index] = en;
+	if (en) {
+		listEntity(en);
+	}
+	invalidateSpatialIndex();
 }
 
 /**
@@ -1126,6 +1268,20 @@ int RS_EntityContainer::findEntity(RS_Entity const* const entity) {
     return entIdx;
 }
 
+template<class Visitor>
+void RS_EntityContainer::visitNearest(const RS_Vector& coord, Visitor visitor) const
+{
+	LC_SpatialIndex* index = getSpatialIndex();
+	if (index) {
+		index->visitNearest(coord, visitor);
+		return;
+	}
+	long order = 0;
+	for (RS_Entity* e: entities) {
+		visitor(e, order++);
+	}
+}
+
 /**
  * @return The point which is closest to 'coord'
  * (one of the vertices)
@@ -1137,22 +1293,27 @@ RS_Vector RS_EntityContainer::getNearestEndpoint(const RS_Vector& coord,
     double curDist;                 // currently measured distance
     RS_Vector closestPoint(false);  // closest found endpoint
     RS_Vector point;                // endpoint found
+    long closestOrder = 0;          // list position of the closest entity
 
-	for (RS_Entity* en: entities){
+	visitNearest(coord, [&](RS_Entity* en, long order) {
 
 		if (en->isVisible()
                 && !en->getParent()->ignoredOnModification()
 				){//no end point for Insert, text, Dim
             point = en->getNearestEndpoint(coord, &curDist);
-            if (point.valid && curDist<minDist) {
+            // on ties, the first entity in the list wins
+            if (point.valid && (curDist<minDist
+                                || (closestPoint.valid && curDist==minDist && order<closestOrder))) {
                 closestPoint = point;
                 minDist = curDist;
+                closestOrder = order;
 				if (dist) {
                     *dist = minDist;
                 }
             }
         }
-    }
+        return minDist;
+    });
 
     return closestPoint;
 }
@@ -1171,19 +1332,16 @@ RS_Vector RS_EntityContainer::getNearestEndpoint(const RS_Vector& coord,
     RS_Vector closestPoint(false);  // closest found endpoint
     RS_Vector point;                // endpoint found
 
-    //QListIterator<RS_Entity> it = createIterator();
-    //RS_Entity* en;
-	//while ( (en = it.current())  ) {
-    //    ++it;
+    long closestOrder = 0;          // list position of the closest entity
 
-    unsigned i0=0;
-	for(auto en: entities){
+	visitNearest(coord, [&](RS_Entity* en, long order) {
         if (!en->getParent()->ignoredOnModification() ){//no end point for Insert, text, Dim
-//            std::cout<<"find nearest for entity "<<i0<<std::endl;
             point = en->getNearestEndpoint(coord, &curDist);
-            if (point.valid && curDist<minDist) {
+            if (point.valid && (curDist<minDist
+                                || (closestPoint.valid && curDist==minDist && order<closestOrder))) {
                 closestPoint = point;
                 minDist = curDist;
+                closestOrder = order;
 				if (dist) {
                     *dist = minDist;
                 }
@@ -1192,8 +1350,8 @@ RS_Vector RS_EntityContainer::getNearestEndpoint(const RS_Vector& coord,
                 }
             }
         }
-        i0++;
-    }
+        return minDist;
+    });
 
 //    std::cout<<__FILE__<<" : "<<__func__<<" : line "<<__LINE__<<std::endl;
 //    std::cout<<"count()="<<const_cast<RS_EntityContainer*>(this)->count()<<"\tminDist= "<<minDist<<"\tclosestPoint="<<closestPoint;
@@ -1228,19 +1386,23 @@ RS_Vector RS_EntityContainer::getNearestCenter(const RS_Vector& coord,
     double curDist = RS_MAXDOUBLE;  // currently measured distance
     RS_Vector closestPoint(false);  // closest found endpoint
     RS_Vector point;                // endpoint found
+    long closestOrder = 0;          // list position of the closest entity
 
-	for(auto en: entities){
+	visitNearest(coord, [&](RS_Entity* en, long order) {
 
         if (en->isVisible()
 				&& !en->getParent()->ignoredSnap()
 				){//no center point for spline, text, Dim
             point = en->getNearestCenter(coord, &curDist);
-            if (point.valid && curDist<minDist) {
+            if (point.valid && (curDist<minDist
+                                || (closestPoint.valid && curDist==minDist && order<closestOrder))) {
                 closestPoint = point;
                 minDist = curDist;
+                closestOrder = order;
             }
         }
-    }
+        return minDist;
+    });
 	if (dist) {
         *dist = minDist;
     }
@@ -1258,19 +1420,23 @@ RS_Vector RS_EntityContainer::getNearestMiddle(const RS_Vector& coord,
     double curDist = RS_MAXDOUBLE;  // currently measured distance
     RS_Vector closestPoint(false);  // closest found endpoint
     RS_Vector point;                // endpoint found
+    long closestOrder = 0;          // list position of the closest entity
 
-	for(auto en: entities){
+	visitNearest(coord, [&](RS_Entity* en, long order) {
 
         if (en->isVisible()
 				&& !en->getParent()->ignoredSnap()
 				){//no midle point for spline, text, Dim
             point = en->getNearestMiddle(coord, &curDist, middlePoints);
-            if (point.valid && curDist<minDist) {
+            if (point.valid && (curDist<minDist
+                                || (closestPoint.valid && curDist==minDist && order<closestOrder))) {
                 closestPoint = point;
                 minDist = curDist;
+                closestOrder = order;
             }
         }
-    }
+        return minDist;
+    });
 	if (dist) {
         *dist = minDist;
     }
@@ -1314,9 +1480,16 @@ RS_Vector RS_EntityContainer::getNearestIntersection(const RS_Vector& coord,
 	closestEntity = getNearestEntity(coord, nullptr, RS2::ResolveAllButTextImage);
 
 	if (closestEntity) {
-        for (RS_Entity* en = firstEntity(RS2::ResolveAllButTextImage);
-             en;
-             en = nextEntity(RS2::ResolveAllButTextImage)) {
+        // all intersections lie on closestEntity, so only entities overlapping
+        // its box can contribute
+        LC_SpatialIndex::Box box;
+        if (!LC_SpatialIndex::entityBox(closestEntity, box)) {
+            double const inf = std::numeric_limits<double>::infinity();
+            box = {-inf, -inf, inf, inf};
+        }
+        for (RS_Entity* en: getEntitiesOverlappingWindow({box.minX, box.minY},
+                                                         {box.maxX, box.maxY},
+                                                         RS2::ResolveAllButTextImage)) {
             if (
                     !en->isVisible()
 					|| en->getParent()->ignoredSnap()
@@ -1388,20 +1561,24 @@ RS_Vector RS_EntityContainer::getNearestRef(const RS_Vector& coord,
     double curDist;                 // currently measured distance
     RS_Vector closestPoint(false);  // closest found endpoint
     RS_Vector point;                // endpoint found
+    long closestOrder = 0;          // list position of the closest entity
 
-	for(auto en: entities){
+	visitNearest(coord, [&](RS_Entity* en, long order) {
 
         if (en->isVisible()) {
             point = en->getNearestRef(coord, &curDist);
-            if (point.valid && curDist<minDist) {
+            if (point.valid && (curDist<minDist
+                                || (closestPoint.valid && curDist==minDist && order<closestOrder))) {
                 closestPoint = point;
                 minDist = curDist;
+                closestOrder = order;
 				if (dist) {
                     *dist = minDist;
                 }
             }
         }
-    }
+        return minDist;
+    });
 
     return closestPoint;
 }
@@ -1414,20 +1591,24 @@ RS_Vector RS_EntityContainer::getNearestSelectedRef(const RS_Vector& coord,
     double curDist;                 // currently measured distance
     RS_Vector closestPoint(false);  // closest found endpoint
     RS_Vector point;                // endpoint found
+    long closestOrder = 0;          // list position of the closest entity
 
-	for(auto en: entities){
+	visitNearest(coord, [&](RS_Entity* en, long order) {
 
         if (en->isVisible() && en->isSelected() && !en->isParentSelected()) {
             point = en->getNearestSelectedRef(coord, &curDist);
-            if (point.valid && curDist<minDist) {
+            if (point.valid && (curDist<minDist
+                                || (closestPoint.valid && curDist==minDist && order<closestOrder))) {
                 closestPoint = point;
                 minDist = curDist;
+                closestOrder = order;
 				if (dist) {
                     *dist = minDist;
                 }
             }
         }
-    }
+        return minDist;
+    });
 
     return closestPoint;
 }
@@ -1445,14 +1626,21 @@ double RS_EntityContainer::getDistanceToPoint(const RS_Vector& coord,
     double curDist;                     // currently measured distance
 	RS_Entity* closestEntity = nullptr;    // closest entity found
 	RS_Entity* subEntity = nullptr;
+	long closestOrder = LONG_MIN;          // list position of the closest entity
 
-	for(auto e: entities){
+	visitNearest(coord, [&](RS_Entity* e, long order) {
 
         if (e->isVisible()) {
             RS_DEBUG->print("entity: getDistanceToPoint");
             RS_DEBUG->print("entity: %d", e->rtti());
             // bug#426, need to ignore Images to find nearest intersections
-            if(level==RS2::ResolveAllButTextImage && e->rtti()==RS2::EntityImage) continue;
+            if(level==RS2::ResolveAllButTextImage && e->rtti()==RS2::EntityImage) return minDist;
+            // only the closest inserts create their entities
+            if (e->rtti()==RS2::EntityInsert
+                    && (level==RS2::ResolveAll || level==RS2::ResolveAllButTextImage)
+                    && e->getDistanceToPoint(coord, nullptr, RS2::ResolveNone, solidDist)>minDist) {
+                return minDist;
+            }
             curDist = e->getDistanceToPoint(coord, &subEntity, level, solidDist);
 
             RS_DEBUG->print("entity: getDistanceToPoint: OK");
@@ -1465,8 +1653,9 @@ double RS_EntityContainer::getDistanceToPoint(const RS_Vector& coord,
 			 * drawn directly over top of another, and it's reasonable to assume that humans will
 			 * tend to want to reference entities that they see or have recently drawn as opposed
 			 * to deeper more forgotten and invisible ones...
+			 * Entities are not visited in list order, so ties are resolved by list position.
 			 */
-			if (curDist<=minDist)
+			if (curDist<minDist || (curDist==minDist && order>closestOrder))
 			{
                 switch(level){
                 case RS2::ResolveAll:
@@ -1477,9 +1666,11 @@ double RS_EntityContainer::getDistanceToPoint(const RS_Vector& coord,
                     closestEntity = e;
                 }
                 minDist = curDist;
+                closestOrder = order;
             }
         }
-    }
+        return minDist;
+    });
 
 	if (entity) {
         *entity = closestEntity;
@@ -1533,122 +1724,137 @@ RS_Entity* RS_EntityContainer::getNearestEntity(const RS_Vector& coord,
  * to do: find closed contour by flood-fill
  */
 bool RS_EntityContainer::optimizeContours() {
-//    std::cout<<"RS_EntityContainer::optimizeContours: begin"<<std::endl;
-
-//    DEBUG_HEADER
-//    std::cout<<"loop with count()="<<count()<<std::endl;
     RS_DEBUG->print("RS_EntityContainer::optimizeContours");
 
-    RS_EntityContainer tmp;
-    tmp.setAutoUpdateBorders(false);
+    // sorted entities, cloned
+    std::vector<RS_Entity*> sorted;
     bool closed=true;
 
-    /** accept all full circles **/
-    QList<RS_Entity*> enList;
-	for(auto e1: entities){
+    /** accept all full circles, drop unsupported entities **/
+    std::vector<RS_Entity*> edges;
+    std::vector<RS_Entity*> dropped;
+    edges.reserve(entities.size());
+    for(auto e1: entities){
         if (!e1->isEdge() || e1->isContainer() ) {
-            enList<<e1;
+            dropped.push_back(e1);
             continue;
         }
 
         //detect circles and whole ellipses
         switch(e1->rtti()){
         case RS2::EntityEllipse:
-			if(static_cast<RS_Ellipse*>(e1)->isEllipticArc())
-                continue;
+            if(static_cast<RS_Ellipse*>(e1)->isEllipticArc())
+                break;
             // fall-through
         case RS2::EntityCircle:
             //directly detect circles, bug#3443277
-            tmp.addEntity(e1->clone());
-            enList<<e1;
-            // fall-through
-        default:
+            sorted.push_back(e1->clone());
+            dropped.push_back(e1);
             continue;
+        default:
+            break;
         }
+        edges.push_back(e1);
+    }
 
+    if (edges.empty() && sorted.empty()) {
+        replaceEntities(edges, sorted, dropped);
+        return false;
     }
-    //    std::cout<<"RS_EntityContainer::optimizeContours: 1"<<std::endl;
 
-    /** remove unsupported entities */
-    for(RS_Entity* it: enList)
-        removeEntity(it);
+    /** hash the endpoints, to connect entities without scanning the list **/
+    LC_EndpointMap endpoints(1e-8);
+    for (size_t i = 0; i < edges.size(); ++i) {
+        // closed splines have no endpoint to connect to
+        if (edges[i]->getNearestEndpoint(edges[i]->getStartpoint()).valid) {
+            endpoints.insert(edges[i], long(i));
+        }
+    }
+    std::vector<bool> used(edges.size(), false);
+    size_t remaining = edges.size();
+    size_t firstUnused = 0;
+    auto take = [&](RS_Entity* e, size_t i) {
+        used[i] = true;
+        --remaining;
+        endpoints.remove(e);
+        RS_Entity* eTmp = e->clone();
+        eTmp->setProcessed(false);
+        sorted.push_back(eTmp);
+        return eTmp;
+    };
+    auto takeFirst = [&]() {
+        while (used[firstUnused]) {
+            ++firstUnused;
+        }
+        return take(edges[firstUnused], firstUnused);
+    };
+    std::unordered_map<RS_Entity const*, size_t> edgeIndex;
+    for (size_t i = 0; i < edges.size(); ++i) {
+        edgeIndex[edges[i]] = i;
+    }
 
-    /** check and form a closed contour **/
-//    std::cout<<"RS_EntityContainer::optimizeContours: 2"<<std::endl;
     /** the first entity **/
-	RS_Entity* current(nullptr);
-    if(count()>0) {
-        current=entityAt(0)->clone();
-        tmp.addEntity(current);
-        removeEntity(entityAt(0));
-    }else {
-        if(tmp.count()==0) return false;
-    }
-//    std::cout<<"RS_EntityContainer::optimizeContours: 3"<<std::endl;
     RS_Vector vpStart;
     RS_Vector vpEnd;
-	if(current){
+    if (remaining > 0) {
+        RS_Entity* current = takeFirst();
         vpStart=current->getStartpoint();
         vpEnd=current->getEndpoint();
     }
-	RS_Entity* next(nullptr);
-//    std::cout<<"RS_EntityContainer::optimizeContours: 4"<<std::endl;
+
     /** connect entities **/
     const QString errMsg=QObject::tr("Hatch failed due to a gap=%1 between (%2, %3) and (%4, %5)");
 
-    while(count()>0) {
-        double dist(0.);
-        RS_Vector&& vpTmp=getNearestEndpoint(vpEnd,&dist,&next);
-        if(dist>1e-8) {
+    while(remaining>0) {
+        if (endpoints.isEmpty()) {
+            //workaround: no entity left with an endpoint
+            RS_DEBUG->print("RS_EntityContainer::optimizeContours: next is nullptr");
+            break;
+        }
+        RS_Entity* next = endpoints.nearest(vpEnd);
+        if (!next) {
             if(vpEnd.squaredTo(vpStart) < 1e-8) {
-                RS_Entity* e2=entityAt(0);
-                tmp.addEntity(e2->clone());
+                // the loop is closed, start a new one
+                RS_Entity* e2 = takeFirst();
                 vpStart=e2->getStartpoint();
                 vpEnd=e2->getEndpoint();
-                removeEntity(e2);
                 continue;
             }
-            else {
-                QG_DIALOGFACTORY->commandMessage(
-                            errMsg.arg(dist).arg(vpTmp.x).arg(vpTmp.y).arg(vpEnd.x).arg(vpEnd.y)
-                            );
-                RS_DEBUG->print(RS_Debug::D_ERROR, "RS_EntityContainer::optimizeContours: hatch failed due to a gap");
-                closed=false;
-                break;
+
+            // report the nearest endpoint, like a scan of the remaining entities
+            double dist = RS_MAXDOUBLE;
+            RS_Vector vpTmp(false);
+            for (size_t i = 0; i < edges.size(); ++i) {
+                if (used[i]) {
+                    continue;
+                }
+                double curDist;
+                RS_Vector const vp = edges[i]->getNearestEndpoint(vpEnd, &curDist);
+                if (vp.valid && curDist < dist) {
+                    dist = curDist;
+                    vpTmp = vp;
+                }
             }
+            QG_DIALOGFACTORY->commandMessage(
+                        errMsg.arg(dist).arg(vpTmp.x).arg(vpTmp.y).arg(vpEnd.x).arg(vpEnd.y)
+                        );
+            RS_DEBUG->print(RS_Debug::D_ERROR, "RS_EntityContainer::optimizeContours: hatch failed due to a gap");
+            closed=false;
+            break;
         }
-        if(!next) { 	    //workaround if next is nullptr
-//      	    std::cout<<"RS_EntityContainer::optimizeContours: next is nullptr" <<std::endl;
-            RS_DEBUG->print("RS_EntityContainer::optimizeContours: next is nullptr");
-//			closed=false;	//workaround if next is nullptr
-            break;			//workaround if next is nullptr
-        } 					//workaround if next is nullptr
-        if(closed) {
-            next->setProcessed(true);
-            RS_Entity* eTmp = next->clone();
-            if(vpEnd.squaredTo(eTmp->getStartpoint())>vpEnd.squaredTo(eTmp->getEndpoint()))
-                eTmp->revertDirection();
-            vpEnd=eTmp->getEndpoint();
-            tmp.addEntity(eTmp);
-        	removeEntity(next);
-        }
-    }
-//    DEBUG_HEADER
-//    if(vpEnd.valid && vpEnd.squaredTo(vpStart) > 1e-8) {
-//		QG_DIALOGFACTORY->commandMessage(errMsg.arg(vpEnd.distanceTo(vpStart))
-//											 .arg(vpStart.x).arg(vpStart.y).arg(vpEnd.x).arg(vpEnd.y));
-//        RS_DEBUG->print("RS_EntityContainer::optimizeContours: hatch failed due to a gap");
-//        closed=false;
-//    }
-//    std::cout<<"RS_EntityContainer::optimizeContours: 5"<<std::endl;
 
+        RS_Entity* eTmp = take(next, edgeIndex[next]);
+        if(vpEnd.squaredTo(eTmp->getStartpoint())>vpEnd.squaredTo(eTmp->getEndpoint()))
+            eTmp->revertDirection();
+        vpEnd=eTmp->getEndpoint();
+    }
 
-    // add new sorted entities:
-	for(auto en: tmp){
-		en->setProcessed(false);
-        addEntity(en->clone());
+    // keep the entities not connected, followed by the sorted entities
+    std::vector<RS_Entity*> kept;
+    for (size_t i = 0; i < edges.size(); ++i) {
+        (used[i] ? dropped : kept).push_back(edges[i]);
     }
-//    std::cout<<"RS_EntityContainer::optimizeContours: 6"<<std::endl;
+    replaceEntities(kept, sorted, dropped);
 
     if(closed) {
         RS_DEBUG->print("RS_EntityContainer::optimizeContours: OK");
@@ -1656,11 +1862,39 @@ bool RS_EntityContainer::optimizeContours() {
     else {
         RS_DEBUG->print("RS_EntityContainer::optimizeContours: bad");
     }
-//    std::cout<<"RS_EntityContainer::optimizeContours: end: count()="<<count()<<std::endl;
-//    std::cout<<"RS_EntityContainer::optimizeContours: closed="<<closed<<std::endl;
     return closed;
 }
 
+/**
+ * Replaces all entities by the kept entities followed by the added ones,
+ * in one go instead of removing and adding every entity.
+ * Dropped entities are deleted, if this container owns its entities.
+ */
+void RS_EntityContainer::replaceEntities(const std::vector<RS_Entity*>& kept,
+                                         const std::vector<RS_Entity*>& added,
+                                         const std::vector<RS_Entity*>& dropped) {
+    for (RS_Entity* e: dropped) {
+        unlistEntity(e);
+        if (autoDelete) {
+            delete e;
+        }
+    }
+    entities.clear();
+    entities.reserve(int(kept.size() + added.size()));
+    for (RS_Entity* e: kept) {
+        entities.append(e);
+    }
+    for (RS_Entity* e: added) {
+        entities.append(e);
+        listEntity(e);
+    }
+    spatialIndex.reset();
+    if (autoUpdateBorders) {
+        calculateBorders();
+    }
+    notifyParent();
+}
+
 
 bool RS_EntityContainer::hasEndpointsWithinWindow(const RS_Vector& v1, const RS_Vector& v2) {
 	for(auto e: entities){
@@ -1674,6 +1908,7 @@ bool RS_EntityContainer::hasEndpointsWithinWindow(const RS_Vector& v1, const RS_
 
 
 void RS_EntityContainer::move(const RS_Vector& offset) {
+	invalidateSpatialIndex();
 	for(auto e: entities){
 
         e->move(offset);
@@ -1690,6 +1925,7 @@ void RS_EntityContainer::move(const RS_Vector& offset) {
 
 void RS_EntityContainer::rotate(const RS_Vector& center, const double& angle) {
     RS_Vector angleVector(angle);
+    invalidateSpatialIndex();
 
 	for(auto e: entities){
         e->rotate(center, angleVector);
@@ -1701,6 +1937,7 @@ void RS_EntityContainer::rotate(const RS_Vector& center, const double& angle) {
 
 
 void RS_EntityContainer::rotate(const RS_Vector& center, const RS_Vector& angleVector) {
+    invalidateSpatialIndex();
 
 	for(auto e: entities){
         e->rotate(center, angleVector);
@@ -1712,6 +1949,7 @@ void RS_EntityContainer::rotate(const RS_Vector& center, const RS_Vector& angleV
 
 
 void RS_EntityContainer::scale(const RS_Vector& center, const RS_Vector& factor) {
+    invalidateSpatialIndex();
     if (fabs(factor.x)>RS_TOLERANCE && fabs(factor.y)>RS_TOLERANCE) {
 
 		for(auto e: entities){
@@ -1726,6 +1964,7 @@ void RS_EntityContainer::scale(const RS_Vector& center, const RS_Vector& factor)
 
 
 void RS_EntityContainer::mirror(const RS_Vector& axisPoint1, const RS_Vector& axisPoint2) {
+	invalidateSpatialIndex();
 	if (axisPoint1.distanceTo(axisPoint2)>RS_TOLERANCE) {
 
 		for(auto e: entities){
@@ -1739,6 +1978,7 @@ void RS_EntityContainer::stretch(const RS_Vector& firstCorner,
                                  const RS_Vector& secondCorner,
                                  const RS_Vector& offset) {
 
+    invalidateSpatialIndex();
     if (getMin().isInWindow(firstCorner, secondCorner) &&
             getMax().isInWindow(firstCorner, secondCorner)) {
 
@@ -1759,7 +1999,7 @@ void RS_EntityContainer::stretch(const RS_Vector& firstCorner,
 void RS_EntityContainer::moveRef(const RS_Vector& ref,
                                  const RS_Vector& offset) {
 
-
+	invalidateSpatialIndex();
 	for(auto e: entities){
         e->moveRef(ref, offset);
     }
@@ -1772,7 +2012,7 @@ void RS_EntityContainer::moveRef(const RS_Vector& ref,
 void RS_EntityContainer::moveSelectedRef(const RS_Vector& ref,
                                          const RS_Vector& offset) {
 
-
+	invalidateSpatialIndex();
 	for(auto e: entities){
         e->moveSelectedRef(ref, offset);
     }
@@ -1782,6 +2022,7 @@ void RS_EntityContainer::moveSelectedRef(const RS_Vector& ref,
 }
 
 void RS_EntityContainer::revertDirection() {
+	invalidateSpatialIndex();
 	for(int k = 0; k < entities.size() / 2; ++k) {
 		entities.swap(k, entities.size() - 1 - k);
 	}
@@ -1803,6 +2044,16 @@ void RS_EntityContainer::draw(RS_Painter* painter, RS_GraphicView* view,
         return;
     }
 
+	// only look up the children inside the viewport of large containers
+	if (!view->isPrinting() && entities.size() >= spatialIndexThreshold) {
+		RS_Vector const vpMin(view->toGraph(0, view->getHeight()));
+		RS_Vector const vpMax(view->toGraph(view->getWidth(), 0));
+		for (RS_Entity* e: getEntitiesOverlappingWindow(vpMin, vpMax)) {
+			view->drawEntity(painter, e);
+		}
+		return;
+	}
+
     foreach (auto e, entities)
     {
         view->drawEntity(painter, e);
@@ -1875,6 +2126,203 @@ bool RS_EntityContainer::ignoredSnap() const
 	return ignoredOnModification();
 }
 
+std::vector<RS_Entity*> RS_EntityContainer::getEntitiesOverlappingWindow(
+        const RS_Vector& v1, const RS_Vector& v2, RS2::ResolveLevel level) const
+{
+	std::vector<RS_Entity*> ret;
+	appendEntitiesOverlappingWindow(v1, v2, level, ret);
+	return ret;
+}
+
+void RS_EntityContainer::appendEntitiesOverlappingWindow(
+        const RS_Vector& v1, const RS_Vector& v2, RS2::ResolveLevel level,
+        std::vector<RS_Entity*>& list) const
+{
+	auto const append = [&](RS_Entity* e) {
+		if (isResolved(e, level)) {
+			if (e->rtti()==RS2::EntityInsert) {
+				static_cast<RS_Insert*>(e)->resolve();
+			}
+			static_cast<RS_EntityContainer*>(e)->appendEntitiesOverlappingWindow(
+						v1, v2, level, list);
+		} else {
+			list.push_back(e);
+		}
+	};
+
+	LC_SpatialIndex* index = getSpatialIndex();
+	if (!index) {
+		for (RS_Entity* e: entities) {
+			append(e);
+		}
+		return;
+	}
+	std::vector<std::pair<long, RS_Entity*>> found;
+	index->visitWindow(v1, v2, [&found](RS_Entity* e, long order) {
+		found.emplace_back(order, e);
+	});
+	// keep the order of the entity list, so ties are resolved as before
+	std::sort(found.begin(), found.end());
+	for (auto const& item: found) {
+		append(item.second);
+	}
+}
+
+void RS_EntityContainer::invalidateSpatialIndex()
+{
+	if (spatialIndex) {
+		spatialIndex->invalidate();
+	}
+	notifyParent();
+}
+
+LC_SpatialIndex* RS_EntityContainer::getSpatialIndex() const
+{
+	if (entities.size() < spatialIndexThreshold) {
+		spatialIndex.reset();
+		return nullptr;
+	}
+	if (!spatialIndex) {
+		spatialIndex.reset(new LC_SpatialIndex);
+	}
+	if (spatialIndex->isValid()) {
+		spatialIndex->refresh();
+		return spatialIndex.get();
+	}
+	// a rebuild only pays off once the children keep still for a few queries,
+	// e.g. not while optimizeContours() removes an entity after each query
+	if (!spatialIndex->countScan()) {
+		return nullptr;
+	}
+	spatialIndex->rebuild(entities.begin(), entities.end());
+	return spatialIndex.get();
+}
+
+void RS_EntityContainer::entityChanged(RS_Entity* entity)
+{
+	if (spatialIndex) {
+		spatialIndex->markChanged(entity);
+	}
+}
+
+void RS_EntityContainer::entityRemoved(RS_Entity const* entity)
+{
+	if (spatialIndex) {
+		spatialIndex->remove(entity);
+	}
+}
+
+void RS_EntityContainer::reserve(int count)
+{
+	entities.reserve(entities.size() + count);
+}
+
+void RS_EntityContainer::updateBorders()
+{
+	resetBorders();
+	for (RS_Entity* e: entities) {
+		RS_Layer* layer = e->getLayer();
+		if (e->isVisible() && !(layer && layer->isFrozen())) {
+			adjustBorders(e);
+		}
+	}
+}
+
+void RS_EntityContainer::trackSelection()
+{
+	if (selection) {
+		return;
+	}
+	selection.reset(new std::unordered_set<RS_Entity*>);
+	for (RS_Entity* e: entities) {
+		listEntity(e);
+	}
+}
+
+void RS_EntityContainer::listEntity(RS_Entity* entity)
+{
+	if (!selection) {
+		return;
+	}
+	RS_EntityContainer*& container = entity->listedIn.container;
+	if (container && container != this) {
+		container->unlistEntity(entity);
+	}
+	container = this;
+	selectionChanged(entity);
+}
+
+void RS_EntityContainer::unlistEntity(RS_Entity* entity)
+{
+	if (selection && entity->listedIn.container == this) {
+		entity->listedIn.container = nullptr;
+		selection->erase(entity);
+	}
+}
+
+void RS_EntityContainer::unlistEntities()
+{
+	if (!selection) {
+		return;
+	}
+	for (RS_Entity* e: entities) {
+		if (e->listedIn.container == this) {
+			e->listedIn.container = nullptr;
+		}
+	}
+	selection->clear();
+}
+
+void RS_EntityContainer::selectionChanged(RS_Entity* entity)
+{
+	if (entity->getFlag(RS2::FlagSelected)) {
+		selection->insert(entity);
+	} else {
+		selection->erase(entity);
+	}
+}
+
+std::vector<RS_Entity*> RS_EntityContainer::selectedEntities() const
+{
+	std::vector<RS_Entity*> ret;
+	if (!selection) {
+		for (RS_Entity* e: entities) {
+			if (e->isVisible() && e->isSelected()) {
+				ret.push_back(e);
+			}
+		}
+		return ret;
+	}
+
+	bool renumber = false;
+	for (RS_Entity* e: *selection) {
+		if (e->isVisible() && e->isSelected()) {
+			ret.push_back(e);
+			int const pos = e->listedIn.position;
+			renumber = renumber || pos < 0 || pos >= entities.size()
+					|| entities.at(pos) != e;
+		}
+	}
+	// keep the list order, it is the drawing order. Positions are
+	// only counted again after the list changed in front of them
+	if (renumber) {
+		for (int i = 0; i < entities.size(); ++i) {
+			entities.at(i)->listedIn.position = i;
+		}
+	}
+	std::sort(ret.begin(), ret.end(), [](RS_Entity const* a, RS_Entity const* b) {
+		return a->listedIn.position < b->listedIn.position;
+	});
+	return ret;
+}
+
+void RS_EntityContainer::notifyParent()
+{
+	if (parent) {
+		parent->entityChanged(this);
+	}
+}
+
 QList<RS_Entity *>::const_iterator RS_EntityContainer::begin() const
 {
 	return entities.begin();
@@ -28,9 +28,13 @@
 #ifndef RS_ENTITYCONTAINER_H
 #define RS_ENTITYCONTAINER_H
 
+#include <memory>
+#include <unordered_set>
 #include <vector>
 #include "rs_entity.h"
 
+class LC_SpatialIndex;
+
 /**
  * Class representing a tree of entities.
  * Typical entity containers are graphics, polylines, groups, texts, ...)
@@ -43,7 +47,9 @@ class RS_EntityContainer : public RS_Entity {
 public:
 
 	RS_EntityContainer(RS_EntityContainer* parent=nullptr, bool owner=true);
-    //RS_EntityContainer(const RS_EntityContainer& ec);
+	//! shallow copy, the spatial index is not copied
+	RS_EntityContainer(const RS_EntityContainer& other);
+	RS_EntityContainer& operator = (const RS_EntityContainer& other);
 	~RS_EntityContainer() override;
 
 	RS_Entity* clone() const override;
@@ -121,6 +127,12 @@ public:
 	*/
 	virtual unsigned countSelected(bool deep=true, std::initializer_list<RS2::EntityType> const& types = {});
     virtual double totalSelectedLength();
+	/**
+	 * @brief selectedEntities the visible, selected direct children
+	 * @return found without a scan over all children, if the selection is
+	 * tracked, in the order of the entity list, which is the drawing order
+	 */
+	std::vector<RS_Entity*> selectedEntities() const;
 
     /**
      * Enables / disables automatic update of borders on entity removals
@@ -177,6 +189,31 @@ public:
                                       RS2::ResolveLevel level=RS2::ResolveNone,
 									  double solidDist = RS_MAXDOUBLE) const override;
 
+	/**
+	 * @brief getEntitiesOverlappingWindow entities which may overlap the
+	 * window, in the order firstEntity(level) and nextEntity(level) return
+	 * them. Every entity with any point inside the window is included, other
+	 * entities may be included.
+	 */
+	std::vector<RS_Entity*> getEntitiesOverlappingWindow(const RS_Vector& v1,
+														 const RS_Vector& v2,
+														 RS2::ResolveLevel level=RS2::ResolveNone) const;
+	/**
+	 * @brief invalidateSpatialIndex tell the container the geometry of its
+	 * children changed without going through this container
+	 */
+	void invalidateSpatialIndex();
+	//! the geometry of a direct child changed
+	void entityChanged(RS_Entity* entity);
+	//! reserve room for count more children
+	void reserve(int count);
+	/**
+	 * @brief updateBorders recalculate the borders from the current borders
+	 * of the children. Unlike calculateBorders() the children are not
+	 * recalculated and the spatial index stays valid.
+	 */
+	void updateBorders();
+
     virtual bool optimizeContours();
 
 	bool hasEndpointsWithinWindow(const RS_Vector& v1, const RS_Vector& v2) override;
@@ -246,14 +283,53 @@ protected:
      */
     static bool autoUpdateBorders;
 
+	//! a direct child was taken out of the list without removeEntity()
+	void entityRemoved(RS_Entity const* entity);
+	//! replace all entities by kept followed by added, drop the others
+	void replaceEntities(const std::vector<RS_Entity*>& kept,
+						 const std::vector<RS_Entity*>& added,
+						 const std::vector<RS_Entity*>& dropped);
+	//! keep a set of the selected children, used for documents
+	void trackSelection();
+	//! \{
+	//! an entity was put into or taken out of the entity list
+	void listEntity(RS_Entity* entity);
+	void unlistEntity(RS_Entity* entity);
+	//! \}
+
 private:
+	//! entities report selection changes and their deletion
+	friend class RS_Entity;
+
 	/**
 	 * @brief ignoredSnap whether snapping is ignored
 	 * @return true when entity of this container won't be considered for snapping points
 	 */
 	bool ignoredSnap() const;
+	/**
+	 * @brief getSpatialIndex the index over the direct children
+	 * @return nullptr, if the children should be scanned linearly instead
+	 */
+	LC_SpatialIndex* getSpatialIndex() const;
+	//! visit children closest first, see LC_SpatialIndex::visitNearest()
+	template<class Visitor>
+	void visitNearest(const RS_Vector& coord, Visitor visitor) const;
+	void appendEntitiesOverlappingWindow(const RS_Vector& v1, const RS_Vector& v2,
+										 RS2::ResolveLevel level,
+										 std::vector<RS_Entity*>& list) const;
+	//! the geometry of this container changed
+	void notifyParent();
+	//! called by a listed child whose selection flag changed
+	void selectionChanged(RS_Entity* entity);
+	//! take all children out of the selection set
+	void unlistEntities();
+
     int entIdx;
     bool autoDelete;
+	//! built on demand for large containers
+	mutable std::unique_ptr<LC_SpatialIndex> spatialIndex;
+	//! children with the selected flag, if the selection is tracked
+	std::unique_ptr<std::unordered_set<RS_Entity*>> selection;
 };
 
 #endif
@@ -27,6 +27,7 @@
 
 
 #include <iostream>
+#include <cmath>
 #include <QTextStream>
 #include <QTextCodec>
 
@@ -452,6 +453,66 @@ RS_Block* RS_Font::findLetter(const QString& name) {
     return generateLffFont(name);
 
 }
+namespace {
+/**
+ * Adds the strokes of a letter entity to path, arcs are replaced by
+ * segments of at most 5 degrees.
+ */
+void addStrokes(QPainterPath& path, RS_Entity const* e, const RS_Vector& offset)
+{
+	switch (e->rtti()) {
+	case RS2::EntityLine: {
+		RS_Vector const start = e->getStartpoint() + offset;
+		RS_Vector const end = e->getEndpoint() + offset;
+		if (path.isEmpty() || path.currentPosition() != QPointF(start.x, start.y))
+			path.moveTo(start.x, start.y);
+		path.lineTo(end.x, end.y);
+		break;
+	}
+	case RS2::EntityArc: {
+		RS_Arc const* arc = static_cast<RS_Arc const*>(e);
+		RS_Vector const start = arc->getStartpoint() + offset;
+		RS_Vector const center = arc->getCenter() + offset;
+		double const sweep = arc->isReversed() ? -arc->getAngleLength()
+											   : arc->getAngleLength();
+		int const n = std::max(1, (int) std::ceil(std::abs(sweep) / RS_Math::deg2rad(5.)));
+		if (path.isEmpty() || path.currentPosition() != QPointF(start.x, start.y))
+			path.moveTo(start.x, start.y);
+		for (int i = 1; i <= n; ++i) {
+			RS_Vector const p = center
+					+ RS_Vector::polar(arc->getRadius(), arc->getAngle1() + sweep * i / n);
+			path.lineTo(p.x, p.y);
+		}
+		break;
+	}
+	default:
+		if (e->isContainer()) {
+			for (RS_Entity const* child: *static_cast<RS_EntityContainer const*>(e))
+				addStrokes(path, child, offset);
+		}
+		break;
+	}
+}
+}
+
+/**
+ * @return The glyph of the given letter or nullptr if the font
+ *   has no such letter.
+ */
+const RS_Font::Glyph* RS_Font::findGlyph(const QString& name) {
+	auto it = glyphs.find(name);
+	if (it != glyphs.end()) return &it->second;
+
+	RS_Block* letter = findLetter(name);
+	if (!letter) return nullptr;
+
+	Glyph& glyph = glyphs[name];
+	glyph.letter = letter;
+	for (RS_Entity const* e: *letter)
+		addStrokes(glyph.strokes, e, -letter->getBasePoint());
+	return &glyph;
+}
+
 /**
  * Dumps the fonts data to stdout.
  */
@@ -29,8 +29,10 @@
 #define RS_FONT_H
 
 #include <iosfwd>
+#include <map>
 #include <QStringList>
 #include <QMap>
+#include <QPainterPath>
 #include "rs_blocklist.h"
 
 /**
@@ -42,6 +44,17 @@
  */
 class RS_Font {
 public:
+    /**
+     * A letter as it is laid out and drawn by texts. The strokes are
+     * created once per letter and shared by all texts showing it.
+     */
+    struct Glyph {
+        //! block of the letter
+        RS_Block* letter;
+        //! strokes with arcs polygonized, relative to the base point
+        QPainterPath strokes;
+    };
+
     RS_Font(const QString& name, bool owner=true);
     //RS_Font(const char* name);
 
@@ -102,6 +115,7 @@ public:
 //    RS_Block* findLetter(const QString& name) {
 //		return letterList.find(name);
 //	}
+    const Glyph* findGlyph(const QString& name);
     unsigned countLetters() {
         return letterList.count();
     }
@@ -125,6 +139,9 @@ private:
         //! block list (letters)
         RS_BlockList letterList;
 
+    //! glyphs of the letters used so far
+    std::map<QString, Glyph> glyphs;
+
     //! Font file name
     QString fileName;
 	
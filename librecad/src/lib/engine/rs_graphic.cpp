@@ -59,6 +59,9 @@ RS_Graphic::RS_Graphic(RS_EntityContainer* parent)
 
     RS_SETTINGS->beginGroup("/Defaults");
     setUnit(RS_Units::stringToUnit(RS_SETTINGS->readEntry("/Unit", "None")));
+    // undo history: number of cycles and memory in MB, 0 for no limit
+    setUndoLimits(static_cast<size_t>(RS_SETTINGS->readNumEntry("/UndoCycles", 0)),
+                  static_cast<size_t>(RS_SETTINGS->readNumEntry("/UndoMemory", 1024)) << 20);
     RS_SETTINGS->endGroup();
     RS_SETTINGS->beginGroup("/Appearance");
     //$ISOMETRICGRID == $SNAPSTYLE
@@ -149,6 +152,14 @@ void RS_Graphic::removeLayer(RS_Layer* layer) {
 			}
 			endUndoCycle();
 		}
+		// entities kept for redo must not refer to the removed layer:
+		for (auto const& p: undoneEntities) {
+			RS_Entity* e = p.first;
+			if (e->getLayer() &&
+					e->getLayer()->getName()==layer->getName()) {
+				e->setLayer("0");
+			}
+		}
 
 		toRemove.clear();
         // remove all entities in blocks that are on that layer:
@@ -24,6 +24,7 @@
 **
 **********************************************************************/
 #include <iostream>
+#include <algorithm>
 #include <cmath>
 #include <memory>
 #include <QPainterPath>
@@ -31,6 +32,7 @@
 #include <QString>
 #include "rs_hatch.h"
 
+#include "lc_hatchfill.h"
 #include "rs_arc.h"
 #include "rs_circle.h"
 #include "rs_ellipse.h"
@@ -46,6 +48,21 @@
 #include "rs_math.h"
 #include "rs_debug.h"
 
+namespace {
+//! a hatch needing more pattern entities is refused as too big
+constexpr size_t maxHatchEntities = 1000000;
+
+//! patterns with smaller tiles on screen are drawn as a tinted solid fill
+constexpr double minPatternPixels = 4.;
+
+//! the visible window is enlarged by this factor on each side when its pattern is created
+constexpr double patternWindowMargin = 0.25;
+
+//! opacity of the tinted solid fill
+constexpr int patternTintAlpha = 96;
+}
+
+bool RS_Hatch::lazyPattern = true;
 
 RS_HatchData::RS_HatchData(bool _solid,
 						   double _scale,
@@ -76,6 +93,8 @@ RS_Hatch::RS_Hatch(RS_EntityContainer* parent,
     updateRunning = false;
     needOptimization = true;
     updateError = HATCH_UNDEFINED;
+    patternPending = false;
+    refusedWindowArea = RS_MAXDOUBLE;
 }
 
 
@@ -107,6 +126,7 @@ RS_Entity* RS_Hatch::clone() const{
     t->setOwner(isOwner());
     t->initId();
     t->detach();
+    t->windowPattern.reset();
     t->update();
 //    t->hatch = nullptr;
     RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::clone(): OK");
@@ -177,15 +197,14 @@ void RS_Hatch::update() {
     RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: contour has %d loops", count());
     updateRunning = true;
 
-    // save attributes for the current hatch
-    RS_Layer* hatch_layer = this->getLayer();
-    RS_Pen hatch_pen = this->getPen();
-
     // delete old hatch:
     if (hatch) {
         removeEntity(hatch);
 		hatch = nullptr;
     }
+    patternPending = false;
+    windowPattern.reset();
+    refusedWindowArea = RS_MAXDOUBLE;
 
     if (isUndone()) {
         RS_DEBUG->print(RS_Debug::D_NOTICE, "RS_Hatch::update: skip undone hatch");
@@ -202,43 +221,16 @@ void RS_Hatch::update() {
 
     // search for pattern
     RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: requesting pattern");
-    RS_Pattern* pat = RS_PATTERNLIST->requestPattern(data.pattern);
-	if (!pat) {
+    std::unique_ptr<RS_Pattern> pat = scaledPattern();
+    if (!pat) {
         updateRunning = false;
         RS_DEBUG->print(RS_Debug::D_ERROR, "RS_Hatch::update: requesting pattern: not found");
         updateError = HATCH_PATTERN_NOT_FOUND;
         return;
-    } else {
-        RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: requesting pattern: OK");
-        // make a working copy of hatch pattern
-        RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: cloning pattern");
-        pat = (RS_Pattern*)pat->clone();
-        if (pat) {
-            RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: cloning pattern: OK");
-        } else {
-            RS_DEBUG->print(RS_Debug::D_ERROR, "RS_Hatch::update: error while cloning hatch pattern");
-            return;
-        }
     }
-
-    // scale pattern
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: scaling pattern");
-    pat->scale(RS_Vector(0.0,0.0), RS_Vector(data.scale, data.scale));
-    pat->calculateBorders();
     forcedCalculateBorders();
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: scaling pattern: OK");
 
-    // find out how many pattern-instances we need in x/y:
-    int px1, py1, px2, py2;
-    double f;
-    RS_Hatch* copy = (RS_Hatch*)this->clone();
-    copy->rotate(RS_Vector(0.0,0.0), -data.angle);
-    copy->forcedCalculateBorders();
-
-    // create a pattern over the whole contour.
     RS_Vector pSize = pat->getSize();
-    RS_Vector rot_center=pat->getMin();
-//    RS_Vector cPos = getMin();
     RS_Vector cSize = getSize();
 
     RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: pattern size: %f/%f", pSize.x, pSize.y);
@@ -249,284 +241,153 @@ void RS_Hatch::update() {
             pSize.x<1.0e-6 || pSize.y<1.0e-6 ||
             cSize.x>RS_MAXDOUBLE-1 || cSize.y>RS_MAXDOUBLE-1 ||
             pSize.x>RS_MAXDOUBLE-1 || pSize.y>RS_MAXDOUBLE-1) {
-        delete pat;
-        delete copy;
         updateRunning = false;
         RS_DEBUG->print(RS_Debug::D_ERROR, "RS_Hatch::update: contour size or pattern size too small");
         updateError = HATCH_TOO_SMALL;
         return;
     }
-    // avoid huge memory consumption:
-    else if ( cSize.x* cSize.y/(pSize.x*pSize.y)>1e4) {
-        RS_DEBUG->print(RS_Debug::D_ERROR, "RS_Hatch::update: contour size too large or pattern size too small");
-        delete pat;
-        delete copy;
-        updateError = HATCH_AREA_TOO_BIG;
-        return;
-    }
-
-    // calculate pattern pieces quantity
-    f = copy->getMin().x/pSize.x;
-    px1 = (int)floor(f);
-    f = copy->getMin().y/pSize.y;
-    py1 = (int)floor(f);
-    f = copy->getMax().x/pSize.x;
-    px2 = (int)ceil(f);
-    f = copy->getMax().y/pSize.y;
-    py2 = (int)ceil(f);
-    RS_Vector dvx=RS_Vector(data.angle)*pSize.x;
-    RS_Vector dvy=RS_Vector(data.angle+M_PI*0.5)*pSize.y;
-    pat->rotate(rot_center, data.angle);
-    pat->move(-rot_center);
+    patternSize = pSize;
+    patternPending = true;
 
-    RS_EntityContainer tmp;   // container for untrimmed lines
-
-    // adding array of patterns to tmp:
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: creating pattern carpet");
-    for (int px=px1; px<px2; px++) {
-		for (int py=py1; py<py2; py++) {
-			for(auto e: *pat){
-                RS_Entity* te=e->clone();
-                te->move(dvx*px + dvy*py);
-                tmp.addEntity(te);
-            }
-        }
+    if (!lazyPattern) {
+        addPattern();
     }
 
-    // clean memory
-    delete pat;
-    pat = nullptr;
-    delete copy;
-    copy = nullptr;
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: creating pattern carpet: OK");
-
-    // cut pattern to contour shape
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: cutting pattern carpet");
-    RS_EntityContainer tmp2;   // container for small cut lines
-	RS_Line* line = nullptr;
-	RS_Arc* arc = nullptr;
-	RS_Circle* circle = nullptr;
-	RS_Ellipse* ellipse = nullptr;
-
-    for(auto e: tmp) {
-
-        if (!e) {
-            RS_DEBUG->print(RS_Debug::D_WARNING, "RS_Hatch::update: nullptr entity found");
-            continue;
-        }
+    forcedCalculateBorders();
 
-		line = nullptr;
-		arc = nullptr;
-		circle = nullptr;
-		ellipse = nullptr;
-
-        RS_Vector startPoint;
-        RS_Vector endPoint;
-        RS_Vector center = RS_Vector(false);
-        bool reversed=false;
-
-        switch(e->rtti()) {
-            case RS2::EntityLine:
-                line=static_cast<RS_Line*>(e);
-                startPoint = line->getStartpoint();
-                endPoint = line->getEndpoint();
-                break;
-            case RS2::EntityArc:
-                arc=static_cast<RS_Arc*>(e);
-                startPoint = arc->getStartpoint();
-                endPoint = arc->getEndpoint();
-                center = arc->getCenter();
-                reversed = arc->isReversed();
-                break;
-            case RS2::EntityCircle:
-                circle=static_cast<RS_Circle*>(e);
-                startPoint = circle->getCenter()
-                        + RS_Vector(circle->getRadius(), 0.0);
-                endPoint = startPoint;
-                center = circle->getCenter();
-                break;
-            case RS2::EntityEllipse:
-                ellipse = static_cast<RS_Ellipse*>(e);
-                startPoint = ellipse->getStartpoint();
-                endPoint = ellipse->getEndpoint();
-                center = ellipse->getCenter();
-                reversed = ellipse->isReversed();
-                break;
-            default:
-                continue;
-        }
+    // deactivate contour:
+    activateContour(false);
 
-        // getting all intersections of this pattern line with the contour:
-		QList<RS_Vector> is;
+    updateRunning = false;
 
-		for(auto loop: entities){
+    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: OK");
+}
 
-            if (loop->isContainer()) {
-				for(auto p: * static_cast<RS_EntityContainer*>(loop)){
 
-                    RS_VectorSolutions sol =
-                        RS_Information::getIntersection(e, p, true);
 
-                    for (const RS_Vector& vp: sol) {
-						if (vp.valid) {
-							is.append(vp);
-                            RS_DEBUG->print(RS_Debug::D_DEBUGGING, "  pattern line intersection: %f/%f", vp.x, vp.y);
-						}
-					}
-				}
-			}
-		}
+/**
+ * @return a copy of the hatch pattern, scaled to the hatch,
+ * nullptr if the pattern is not found.
+ */
+std::unique_ptr<RS_Pattern> RS_Hatch::scaledPattern() const {
+    RS_Pattern* pat = RS_PATTERNLIST->requestPattern(data.pattern);
+    if (!pat) {
+        return nullptr;
+    }
+    std::unique_ptr<RS_Pattern> copy(static_cast<RS_Pattern*>(pat->clone()));
+    copy->scale(RS_Vector(0.0,0.0), RS_Vector(data.scale, data.scale));
+    copy->calculateBorders();
+    return copy;
+}
 
-        QList<RS_Vector> is2;       //to be filled with sorted intersections
-		is2.append(startPoint);
 
-        // sort the intersection points into is2 (only if there are intersections):
-        if(is.size() == 1) {        //only one intersection
-            is2.append(is.first());
-        }
-        else if(is.size() > 1) {
-            RS_Vector sp = startPoint;
-            double sa = center.angleTo(sp);
-			if(ellipse ) sa=ellipse->getEllipseAngle(sp);
-            bool done;
-            double minDist;
-            double dist = 0.0;
-			RS_Vector av;
-			RS_Vector v;
-			RS_Vector last{};
-            do {    // very long while(!done) loop
-                done = true;
-                minDist = RS_MAXDOUBLE;
-				av.valid = false;
-                for (int i = 0; i < is.size(); ++i) {
-                    v = is.at(i);
-                    double a;
-                    switch(e->rtti()){
-                    case RS2::EntityLine:
-						dist = sp.distanceTo(v);
-                        break;
-                    case RS2::EntityArc:
-                    case RS2::EntityCircle:
-						a = center.angleTo(v);
-                        dist = reversed?
-                                    fmod(sa - a + 2.*M_PI,2.*M_PI):
-                                    fmod(a - sa + 2.*M_PI,2.*M_PI);
-                        break;
-                    case RS2::EntityEllipse:
-						a = ellipse->getEllipseAngle(v);
-                        dist = reversed?
-                                    fmod(sa - a + 2.*M_PI,2.*M_PI):
-                                    fmod(a - sa + 2.*M_PI,2.*M_PI);
-                        break;
-                    default:
-                        break;
-
-                    }
-
-                    if (dist<minDist) {
-                        minDist = dist;
-                        done = false;
-                        av = v;
-                    }
-                }
 
-                // copy to sorted list, removing double points
-				if (!done && av) {
-					if (last.valid==false || last.distanceTo(av)>RS_TOLERANCE) {
-						is2.append(av);
-						last = av;
-                    }
-                    is.removeOne(av);
+/**
+ * Creates the pattern entities clipped to the contour.
+ *
+ * @param v1, v2 corners of the window to cover, invalid to
+ *        cover the whole hatch.
+ * @return the pattern entities, nullptr if the pattern is not found
+ *         or needs too many entities.
+ */
+std::unique_ptr<RS_EntityContainer> RS_Hatch::createPattern(const RS_Vector& v1,
+                                                            const RS_Vector& v2) {
+    std::unique_ptr<RS_Pattern> pat = scaledPattern();
+    if (!pat) {
+        updateError = HATCH_PATTERN_NOT_FOUND;
+        return nullptr;
+    }
 
-					av.valid = false;
-                }
-            } while(!done);
-        }
+    // the pattern tile at the origin, repeated by multiples of dvx and dvy
+    RS_Vector pSize = pat->getSize();
+    RS_Vector cSize = getSize();
+    RS_Vector rot_center=pat->getMin();
+    RS_Vector dvx=RS_Vector(data.angle)*pSize.x;
+    RS_Vector dvy=RS_Vector(data.angle+M_PI*0.5)*pSize.y;
+    pat->rotate(rot_center, data.angle);
+    pat->move(-rot_center);
 
-		is2.append(endPoint);
+    // add the hatch pattern entities, clipped to the contour
+    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::createPattern: cutting pattern");
+    RS_Layer* hatch_layer = getLayer();
+    RS_Pen hatch_pen = getPen();
+    std::unique_ptr<RS_EntityContainer> pattern(new RS_EntityContainer(this));
+    pattern->setPen(hatch_pen);
+    pattern->setLayer(hatch_layer);
+    pattern->setFlag(RS2::FlagTemp);
+
+    double const tolerance = 1e-3*std::min(std::min(pSize.x, pSize.y),
+                                           std::min(cSize.x, cSize.y));
+    LC_HatchFill fill(*this, tolerance);
+    if (v1.valid && v2.valid) {
+        fill.setWindow(v1, v2);
+    }
 
-        // add small cut lines / arcs to tmp2:
-        for (int i = 1; i < is2.size(); ++i) {
-            auto v1 = is2.at(i-1);
-            auto v2 = is2.at(i);
+    // avoid huge memory consumption:
+    if (!fill.fill(*pat, dvx, dvy, pattern.get(), maxHatchEntities)) {
+        RS_DEBUG->print(RS_Debug::D_ERROR, "RS_Hatch::createPattern: contour size too large or pattern size too small");
+        return nullptr;
+    }
+    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::createPattern: cutting pattern: OK");
 
+    for(auto e: *pattern){
+        e->setPen(hatch_pen);
+        e->setLayer(hatch_layer);
+    }
+    return pattern;
+}
 
-            if (line) {
 
-                tmp2.addEntity(new RS_Line{&tmp2, v1, v2});
-            } else if (arc || circle) {
-                if(fabs(center.angleTo(v2)-center.angleTo(v1)) > RS_TOLERANCE_ANGLE)
-                {//don't create an arc with a too small angle
-                    tmp2.addEntity(new RS_Arc(&tmp2,
-                                              RS_ArcData(center,
-                                                         center.distanceTo(v1),
-                                                         center.angleTo(v1),
-                                                         center.angleTo(v2),
-                                                         reversed)));
-                }
-            }
-        }
-    } // end for very very long for(auto e: tmp) loop
-
-    // updating hatch / adding entities that are inside
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: cutting pattern carpet: OK");
-
-    //RS_EntityContainer* rubbish = new RS_EntityContainer(getGraphic());
-
-    // add the hatch pattern entities
-    hatch = new RS_EntityContainer(this);
-    hatch->setPen(hatch_pen);
-    hatch->setLayer(hatch_layer);
-    hatch->setFlag(RS2::FlagTemp);
-
-    //calculateBorders();
-	for(auto e: tmp2){
-
-        RS_Vector middlePoint;
-        RS_Vector middlePoint2;
-        if (e->rtti()==RS2::EntityLine) {
-			RS_Line* line = static_cast<RS_Line*>(e);
-            middlePoint = line->getMiddlePoint();
-            middlePoint2 = line->getNearestDist(line->getLength()/2.1,
-                                                line->getStartpoint());
-        } else if (e->rtti()==RS2::EntityArc) {
-			RS_Arc* arc = static_cast<RS_Arc*>(e);
-            middlePoint = arc->getMiddlePoint();
-            middlePoint2 = arc->getNearestDist(arc->getLength()/2.1,
-                                               arc->getStartpoint());
-        } else {
-			middlePoint = RS_Vector{false};
-			middlePoint2 = RS_Vector{false};
+
+/**
+ * Adds the pattern entities of the whole hatch to its children.
+ */
+void RS_Hatch::addPattern() {
+    std::unique_ptr<RS_EntityContainer> pattern =
+            createPattern(RS_Vector(false), RS_Vector(false));
+    if (!pattern) {
+        if (updateError == HATCH_OK) {
+            updateError = HATCH_AREA_TOO_BIG;
         }
+        return;
+    }
+    hatch = pattern.release();
+    addEntity(hatch);
+    patternPending = false;
+    windowPattern.reset();
+}
 
-        if (middlePoint.valid) {
-            bool onContour=false;
 
-            if (RS_Information::isPointInsideContour(
-                        middlePoint,
-                        this, &onContour) ||
-                    RS_Information::isPointInsideContour(middlePoint2, this)) {
 
-                RS_Entity* te = e->clone();
-                te->setPen(hatch_pen);
-                te->setLayer(hatch_layer);
-                te->reparent(hatch);
-                hatch->addEntity(te);
-            }
-        }
+void RS_Hatch::updatePattern() {
+    if (data.solid || !patternPending || updateRunning
+            || updateError != HATCH_OK) {
+        return;
     }
+    updateRunning = true;
+    addPattern();
+    updateRunning = false;
+}
 
-    addEntity(hatch);
-    //getGraphic()->addEntity(rubbish);
 
-    forcedCalculateBorders();
 
-    // deactivate contour:
-    activateContour(false);
+/**
+ * @return area of the part of the hatch borders within the given window.
+ */
+double RS_Hatch::windowArea(const RS_Vector& v1, const RS_Vector& v2) const {
+    double const w = std::min(v2.x, getMax().x) - std::max(v1.x, getMin().x);
+    double const h = std::min(v2.y, getMax().y) - std::max(v1.y, getMin().y);
+    return std::max(w, 0.)*std::max(h, 0.);
+}
 
-    updateRunning = false;
 
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: OK");
+
+void RS_Hatch::setLazyPattern(bool lazy) {
+    lazyPattern = lazy;
+}
+
+bool RS_Hatch::isLazyPattern() {
+    return lazyPattern;
 }
 
 
@@ -555,18 +416,88 @@ void RS_Hatch::activateContour(bool on) {
 
 //#include<QDebug>
 /**
- * Overrides drawing of subentities. This is only ever called for solid fills.
+ * Overrides drawing of subentities. Pattern hatches draw their pattern
+ * entities. Without them, the pattern of the visible window is created
+ * for drawing only, so the children never change during a repaint. A
+ * tinted solid fill is drawn if the pattern is too fine to be seen.
  */
 void RS_Hatch::draw(RS_Painter* painter, RS_GraphicView* view, double& /*patternOffset*/) {
 
-    if (!data.solid) {
-        foreach (auto se, entities){
+    if (data.solid) {
+        drawSolidFill(painter, view, painter->getPen().getColor());
+        return;
+    }
 
-            view->drawEntity(painter,se);
+    bool tint = false;
+    if (view->isPrinting() || view->isPrintPreview()) {
+        updatePattern();
+    } else if (updateError==HATCH_AREA_TOO_BIG ||
+               (patternSize.valid && view->toGuiDX(
+                    std::min(patternSize.x, patternSize.y)) < minPatternPixels)) {
+        tint = true;
+    } else if (patternPending && updateError==HATCH_OK && !updateRunning) {
+        // the whole view and the part rendered now, e.g. a row of tiles
+        // which reaches past the view
+        LC_Rect const rendered(view->toGraph(0, 0),
+                               view->toGraph(view->getWidth(), view->getHeight()));
+        LC_Rect const visible = view->getVisibleArea().merge(rendered);
+        RS_Vector vMin = visible.minP();
+        RS_Vector vMax = visible.maxP();
+        bool const covered = windowPattern && (!patternMin.valid ||
+                (patternMin.x<=vMin.x && patternMin.y<=vMin.y &&
+                 patternMax.x>=vMax.x && patternMax.y>=vMax.y));
+        if (!covered) {
+            RS_Vector const margin = (vMax - vMin)*patternWindowMargin;
+            vMin -= margin;
+            vMax += margin;
+            double const area = windowArea(vMin, vMax);
+            // a window with no less of the hatch than a refused one is too big as well
+            if (area >= refusedWindowArea) {
+                tint = true;
+            } else {
+                if (vMin.x<=getMin().x && vMin.y<=getMin().y &&
+                        vMax.x>=getMax().x && vMax.y>=getMax().y) {
+                    patternMin = patternMax = RS_Vector(false);
+                } else {
+                    patternMin = vMin;
+                    patternMax = vMax;
+                }
+                updateRunning = true;
+                windowPattern = createPattern(patternMin, patternMax);
+                updateRunning = false;
+                refusedWindowArea = windowPattern ? RS_MAXDOUBLE : area;
+                tint = !windowPattern;
+            }
         }
+    }
+
+    if (tint) {
+        RS_Color color = painter->getPen().getColor();
+        color.setAlpha(patternTintAlpha);
+        drawSolidFill(painter, view, color);
         return;
     }
 
+    foreach (auto se, entities){
+
+        view->drawEntity(painter,se);
+    }
+    if (patternPending && windowPattern) {
+        if (windowPattern->isSelected() != isSelected()) {
+            windowPattern->setSelected(isSelected());
+        }
+        view->drawEntity(painter, windowPattern.get());
+    }
+}
+
+
+
+/**
+ * Fills the area of the contour with a solid color.
+ */
+void RS_Hatch::drawSolidFill(RS_Painter* painter, RS_GraphicView* view,
+                             const RS_Color& color) {
+
     //area of solid fill. Use polygon approximation, except trivial cases
     QPainterPath path;
     QList<QPolygon> paClosed;
@@ -710,7 +641,7 @@ void RS_Hatch::draw(RS_Painter* painter, RS_GraphicView* view, double& /*pattern
     //bug#474, restore brush after solid fill
     const QBrush brush(painter->brush());
     const RS_Pen pen=painter->getPen();
-    painter->setBrush(pen.getColor());
+    painter->setBrush(color);
     painter->disablePen();
     painter->drawPath(path);
     painter->setBrush(brush);
@@ -740,7 +671,8 @@ double RS_Hatch::getDistanceToPoint(
     RS2::ResolveLevel level,
     double solidDist) const {
 
-    if (data.solid==true) {
+    // without pattern entities, pick it like a solid fill
+    if (data.solid==true || !hatch) {
         if (entity) {
             *entity = const_cast<RS_Hatch*>(this);
         }
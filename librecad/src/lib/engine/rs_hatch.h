@@ -28,9 +28,13 @@
 #ifndef RS_HATCH_H
 #define RS_HATCH_H
 
+#include <memory>
 #include "rs_entity.h"
 #include "rs_entitycontainer.h"
 
+class RS_Color;
+class RS_Pattern;
+
 /**
  * Holds the data that defines a hatch entity.
  */
@@ -135,6 +139,21 @@ public:
 
 		void calculateBorders() override;
 		void update() override;
+        /**
+         * Creates the pattern entities of the whole hatch, if their
+         * creation was deferred. Called before the exact pattern geometry
+         * is needed, e.g. when printing or exporting the pattern entities.
+         */
+        void updatePattern();
+        /**
+         * With lazy patterns, update() only keeps the contour. Drawing
+         * creates the pattern of the visible part, kept apart from the
+         * child entities. Hatches whose pattern is too fine to be seen, or
+         * needs too many entities for the window, are drawn as a tinted
+         * solid fill.
+         */
+        static void setLazyPattern(bool lazy);
+        static bool isLazyPattern();
         int getUpdateError() {
                 return updateError;
         }
@@ -165,11 +184,31 @@ public:
         friend std::ostream& operator << (std::ostream& os, const RS_Hatch& p);
 
 protected:
+        std::unique_ptr<RS_Pattern> scaledPattern() const;
+        std::unique_ptr<RS_EntityContainer> createPattern(const RS_Vector& v1,
+                                                          const RS_Vector& v2);
+        void addPattern();
+        double windowArea(const RS_Vector& v1, const RS_Vector& v2) const;
+        void drawSolidFill(RS_Painter* painter, RS_GraphicView* view,
+                           const RS_Color& color);
+
         RS_HatchData data;
         RS_EntityContainer* hatch;
         bool updateRunning;
         bool needOptimization;
         int  updateError;
+        //! size of the scaled pattern tile
+        RS_Vector patternSize;
+        //! window covered by windowPattern, invalid for the whole hatch
+        RS_Vector patternMin;
+        RS_Vector patternMax;
+        //! the pattern of the whole hatch is not among the children yet
+        bool patternPending;
+        //! pattern entities of a window, drawn but not children of the hatch
+        std::shared_ptr<RS_EntityContainer> windowPattern;
+        //! area of the last window whose pattern needed too many entities
+        double refusedWindowArea;
+        static bool lazyPattern;
 };
 
 #endif
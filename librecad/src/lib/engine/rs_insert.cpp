@@ -26,17 +26,31 @@
 
 #include<iostream>
 #include<cmath>
+#include<memory>
 #include "rs_insert.h"
 
+#include "lc_spatialindex.h"
 #include "rs_arc.h"
 #include "rs_circle.h"
 #include "rs_ellipse.h"
 #include "rs_block.h"
 #include "rs_graphic.h"
+#include "rs_graphicview.h"
 #include "rs_layer.h"
 #include "rs_math.h"
 #include "rs_debug.h"
 
+namespace {
+//! distance of coord to the box vMin, vMax, 0 inside of the box
+double distanceToBox(const RS_Vector& coord, const RS_Vector& vMin,
+					 const RS_Vector& vMax)
+{
+	double const dx = std::max(0., std::max(vMin.x - coord.x, coord.x - vMax.x));
+	double const dy = std::max(0., std::max(vMin.y - coord.y, coord.y - vMax.y));
+	return std::hypot(dx, dy);
+}
+}
+
 RS_InsertData::RS_InsertData(const QString& _name,
 							 RS_Vector _insertionPoint,
 							 RS_Vector _scaleFactor,
@@ -87,8 +101,27 @@ RS_Entity* RS_Insert::clone() const{
 
 
 /**
- * Updates the entity buffer of this insert entity. This method
- * needs to be called whenever the block this insert is based on changes.
+ * @return A copy of this insert without the entities resolved from
+ *   its block.
+ */
+RS_Insert* RS_Insert::cloneUnresolved() const{
+	RS_Insert* i = new RS_Insert(*this);
+	// the entities are shared with this insert, forget them
+	i->entities.clear();
+	i->resolved = false;
+	i->setOwner(isOwner());
+	i->initId();
+	return i;
+}
+
+
+/**
+ * Updates this insert entity. This method needs to be called whenever
+ * the block this insert is based on changes.
+ *
+ * The entities of the block are not copied, the borders are the mapped
+ * borders of the block geometry. Entities created by resolve() are
+ * dropped.
  */
 void RS_Insert::update() {
 
@@ -102,150 +135,347 @@ void RS_Insert::update() {
         }
 
     clear();
+    resolved = false;
+    calculateBorders();
+
+        RS_DEBUG->print("RS_Insert::update: OK");
+}
+
+
+
+/**
+ * Creates the entities of the block in this insert for every row and col,
+ * e.g. to iterate, explode or trim them. Nested inserts are copied
+ * unresolved. The entities are kept until the next update().
+ */
+void RS_Insert::resolve() {
+    if (resolved) {
+        return;
+    }
+    resolved = true;
 
     RS_Block* blk = getBlockForInsert();
-	if (!blk) {
-		//return nullptr;
-				RS_DEBUG->print("RS_Insert::update: Block is nullptr");
+    if (!getGeometry()) {
         return;
     }
 
-    if (isUndone()) {
-                RS_DEBUG->print("RS_Insert::update: Insert is in undo list");
+        RS_DEBUG->print("RS_Insert::resolve: cols: %d, rows: %d",
+                data.cols, data.rows);
+        RS_DEBUG->print("RS_Insert::resolve: block has %d entities",
+                blk->count());
+
+    RS_Pen const pen = getPen();
+    RS_Layer* const layer = getLayer();
+    for (RS_Entity* e: *blk) {
+        for (int c=0; c<data.cols; ++c) {
+            for (int r=0; r<data.rows; ++r) {
+                RS_Entity* ne = createInstance(e,
+                                               getInstanceOffset(c, r) - blk->getBasePoint(),
+                                               pen, layer);
+
+                // insert must be updated even in preview mode
+                if (data.updateMode != RS2::PreviewUpdate
+                        || ne->rtti() == RS2::EntityInsert) {
+                    ne->update();
+                }
+
+                // the borders of this insert already cover the entity
+                entities.append(ne);
+            }
+        }
+    }
+}
+
+
+
+/**
+ * Appends the block geometry for every row and col to container, moved
+ * by offset. Used to resolve this insert into the geometry of the block
+ * which contains it. ByBlock attributes stay ByBlock if this insert has
+ * them, they are taken from the insert of the containing block.
+ */
+void RS_Insert::appendFlattened(RS_EntityContainer& container,
+                                const RS_Vector& offset) const {
+    const RS_BlockGeometry* geometry = getGeometry();
+    if (!geometry) {
         return;
     }
 
+    RS_Pen pen = getPen(false);
+    RS_Layer* layer = getLayer(false);
+    if (layer && layer->getName()!="0") {
+        // ByLayer refers to the layer of this insert
+        RS_Pen const layerPen = layer->getPen();
+        if (pen.getColor().isByLayer()) {
+            pen.setColor(layerPen.getColor());
+        }
+        if (pen.getWidth()==RS2::WidthByLayer) {
+            pen.setWidth(layerPen.getWidth());
+        }
+        if (pen.getLineType()==RS2::LineByLayer) {
+            pen.setLineType(layerPen.getLineType());
+        }
+    }
+
+    for (int c=0; c<data.cols; ++c) {
+        for (int r=0; r<data.rows; ++r) {
+            for (RS_Entity* e: geometry->entities) {
+                RS_Entity* ne = createInstance(e, getInstanceOffset(c, r), pen, layer);
+                ne->move(offset);
+                ne->reparent(&container);
+                container.appendEntity(ne);
+            }
+        }
+    }
+}
+
+
+
+/**
+ * @return the geometry of the block or nullptr if nothing is inserted
+ */
+const RS_BlockGeometry* RS_Insert::getGeometry() const {
+    RS_Block* blk = getBlockForInsert();
+	if (!blk) {
+				RS_DEBUG->print("RS_Insert::getGeometry: Block is nullptr");
+        return nullptr;
+    }
+
+    if (isUndone()) {
+                RS_DEBUG->print("RS_Insert::getGeometry: Insert is in undo list");
+        return nullptr;
+    }
+
         if (fabs(data.scaleFactor.x)<1.0e-6 || fabs(data.scaleFactor.y)<1.0e-6) {
-                RS_DEBUG->print("RS_Insert::update: scale factor is 0");
-                return;
+                RS_DEBUG->print("RS_Insert::getGeometry: scale factor is 0");
+                return nullptr;
         }
 
-    RS_Pen tmpPen;
+    return blk->getGeometry();
+}
 
-        /*QListIterator<RS_Entity> it = createIterator();
-    RS_Entity* e;
-	while ( (e = it.current())  ) {
-        ++it;*/
 
-        RS_DEBUG->print("RS_Insert::update: cols: %d, rows: %d",
-                data.cols, data.rows);
-        RS_DEBUG->print("RS_Insert::update: block has %d entities",
-                blk->count());
-//int i_en_counts=0;
-		for(auto e: *blk){
-        for (int c=0; c<data.cols; ++c) {
-//            RS_DEBUG->print("RS_Insert::update: col %d", c);
-            for (int r=0; r<data.rows; ++r) {
-//                i_en_counts++;
-//                RS_DEBUG->print("RS_Insert::update: row %d", r);
 
-                if (e->rtti()==RS2::EntityInsert &&
-                    data.updateMode!=RS2::PreviewUpdate) {
+RS_Vector RS_Insert::toDrawing(const RS_Vector& v) const {
+    RS_Vector ret = v.scale(data.scaleFactor);
+    ret.rotate(data.angle);
+    return ret + data.insertionPoint;
+}
 
-//                                        RS_DEBUG->print("RS_Insert::update: updating sub-insert");
-					static_cast<RS_Insert*>(e)->update();
-                }
 
-//                                RS_DEBUG->print("RS_Insert::update: cloning entity");
-
-                RS_Entity* ne;
-                if ( (data.scaleFactor.x - data.scaleFactor.y)>1.0e-6) {
-                    if (e->rtti()== RS2::EntityArc) {
-						RS_Arc* a= static_cast<RS_Arc*>(e);
-						ne = new RS_Ellipse{this,
-						{a->getCenter(), {a->getRadius(), 0.},
-								1, a->getAngle1(), a->getAngle2(),
-								a->isReversed()}
-					};
-                        ne->setLayer(e->getLayer());
-                        ne->setPen(e->getPen(false));
-                    } else if (e->rtti()== RS2::EntityCircle) {
-						RS_Circle* a= static_cast<RS_Circle*>(e);
-						ne = new RS_Ellipse{this,
-						{ a->getCenter(), {a->getRadius(), 0.}, 1, 0., 2.*M_PI, false}
-					};
-                        ne->setLayer(e->getLayer());
-                        ne->setPen(e->getPen(false));
-                    } else
-                        ne = e->clone();
-                } else
-                    ne = e->clone();
-                ne->initId();
-                ne->setUpdateEnabled(false);
-                // if entity layer are 0 set to insert layer to allow "1 layer control" bug ID #3602152
-                RS_Layer *l= ne->getLayer();//special fontchar block don't have
-				if (l  && ne->getLayer()->getName() == "0")
-                    ne->setLayer(this->getLayer());
-                ne->setParent(this);
-                ne->setVisible(getFlag(RS2::FlagVisible));
-
-//                                RS_DEBUG->print("RS_Insert::update: transforming entity");
-
-                // Move:
-//                                RS_DEBUG->print("RS_Insert::update: move 1");
-                if (fabs(data.scaleFactor.x)>1.0e-6 &&
-                        fabs(data.scaleFactor.y)>1.0e-6) {
-                    ne->move(data.insertionPoint +
-                             RS_Vector(data.spacing.x/data.scaleFactor.x*c,
-                                       data.spacing.y/data.scaleFactor.y*r));
-                }
-                else {
-                    ne->move(data.insertionPoint);
-                }
-                // Move because of block base point:
-//                                RS_DEBUG->print("RS_Insert::update: move 2");
-                ne->move(blk->getBasePoint()*-1);
-                // Scale:
-//                                RS_DEBUG->print("RS_Insert::update: scale");
-                ne->scale(data.insertionPoint, data.scaleFactor);
-                // Rotate:
-//                                RS_DEBUG->print("RS_Insert::update: rotate");
-                ne->rotate(data.insertionPoint, data.angle);
-                // Select:
-                ne->setSelected(isSelected());
-
-                // individual entities can be on indiv. layers
-                tmpPen = ne->getPen(false);
-
-                // color from block (free floating):
-                if (tmpPen.getColor()==RS_Color(RS2::FlagByBlock)) {
-                    tmpPen.setColor(getPen().getColor());
-                }
 
-                // line width from block (free floating):
-                if (tmpPen.getWidth()==RS2::WidthByBlock) {
-                    tmpPen.setWidth(getPen().getWidth());
-                }
+RS_Vector RS_Insert::toBlock(const RS_Vector& v) const {
+    RS_Vector ret = v - data.insertionPoint;
+    ret.rotate(-data.angle);
+    return {ret.x/data.scaleFactor.x, ret.y/data.scaleFactor.y};
+}
 
-                // line type from block (free floating):
-                if (tmpPen.getLineType()==RS2::LineByBlock) {
-                    tmpPen.setLineType(getPen().getLineType());
-                }
 
-                // now that we've evaluated all flags, let's strip them:
-                // TODO: strip all flags (width, line type)
-                //tmpPen.setColor(tmpPen.getColor().stripFlags());
 
-                ne->setPen(tmpPen);
+RS_Vector RS_Insert::getInstanceOffset(int col, int row) const {
+    return {data.spacing.x/data.scaleFactor.x*col,
+            data.spacing.y/data.scaleFactor.y*row};
+}
 
-                ne->setUpdateEnabled(true);
 
-                // insert must be updated even in preview mode
-                if (data.updateMode != RS2::PreviewUpdate
-                        || ne->rtti() == RS2::EntityInsert) {
-                    //RS_DEBUG->print("RS_Insert::update: updating new entity");
-                    ne->update();
-                }
 
-//                                RS_DEBUG->print("RS_Insert::update: adding new entity");
-                appendEntity(ne);
-//                std::cout<<"done # of entity: "<<i_en_counts<<std::endl;
+void RS_Insert::mapBox(RS_Vector& vMin, RS_Vector& vMax) const {
+    RS_Vector const corners[] = {{vMin.x, vMax.y}, vMax, {vMax.x, vMin.y}};
+    vMin = vMax = toDrawing(vMin);
+    for (const RS_Vector& corner: corners) {
+        RS_Vector const v = toDrawing(corner);
+        vMin = RS_Vector::minimum(vMin, v);
+        vMax = RS_Vector::maximum(vMax, v);
+    }
+}
+
+
+
+void RS_Insert::mapArrayBox(RS_Vector& vMin, RS_Vector& vMax) const {
+    // the rows and cols are offsets in block coordinates
+    RS_Vector const last = getInstanceOffset(data.cols-1, data.rows-1);
+    vMin += RS_Vector::minimum(last, RS_Vector(0., 0.));
+    vMax += RS_Vector::maximum(last, RS_Vector(0., 0.));
+    mapBox(vMin, vMax);
+}
+
+
+
+double RS_Insert::getUniformScale() const {
+    double const sx = fabs(data.scaleFactor.x);
+    double const sy = fabs(data.scaleFactor.y);
+    return fabs(sx - sy) <= RS_TOLERANCE*sx ? sx : 0.;
+}
+
+
+
+RS_Entity* RS_Insert::createInstance(const RS_Entity* e, const RS_Vector& offset,
+                                     const RS_Pen& pen, RS_Layer* layer) const {
+    RS_Insert* self = const_cast<RS_Insert*>(this);
+    RS_Entity* ne = nullptr;
+    if (e->rtti()==RS2::EntityInsert) {
+        // sub-inserts map their own block
+        ne = static_cast<const RS_Insert*>(e)->cloneUnresolved();
+    } else if ( (data.scaleFactor.x - data.scaleFactor.y)>1.0e-6) {
+        if (e->rtti()== RS2::EntityArc) {
+            const RS_Arc* a= static_cast<const RS_Arc*>(e);
+            ne = new RS_Ellipse{self,
+            {a->getCenter(), {a->getRadius(), 0.},
+                    1, a->getAngle1(), a->getAngle2(),
+                    a->isReversed()}
+        };
+            ne->setLayer(e->getLayer(false));
+            ne->setPen(e->getPen(false));
+        } else if (e->rtti()== RS2::EntityCircle) {
+            const RS_Circle* a= static_cast<const RS_Circle*>(e);
+            ne = new RS_Ellipse{self,
+            { a->getCenter(), {a->getRadius(), 0.}, 1, 0., 2.*M_PI, false}
+        };
+            ne->setLayer(e->getLayer(false));
+            ne->setPen(e->getPen(false));
+        }
+    }
+    if (!ne) {
+        ne = e->clone();
+    }
+    ne->setUpdateEnabled(false);
+    // if entity layer are 0 set to insert layer to allow "1 layer control" bug ID #3602152
+    RS_Layer* l = ne->getLayer(false);
+    if (!l || l->getName() == "0") {
+        ne->setLayer(layer);
+    }
+    ne->setParent(self);
+    ne->setVisible(getFlag(RS2::FlagVisible));
+
+    // texts lay out their letters again when they are scaled, so the
+    // identity is skipped
+    ne->move(data.insertionPoint + offset);
+    if (data.scaleFactor != RS_Vector(1.0, 1.0)) {
+        ne->scale(data.insertionPoint, data.scaleFactor);
+    }
+    if (fabs(data.angle) > RS_TOLERANCE_ANGLE) {
+        ne->rotate(data.insertionPoint, data.angle);
+    }
+    ne->setSelected(isSelected());
+
+    // individual entities can be on indiv. layers
+    RS_Pen tmpPen = ne->getPen(false);
+
+    // color from block (free floating):
+    if (tmpPen.getColor()==RS_Color(RS2::FlagByBlock)) {
+        tmpPen.setColor(pen.getColor());
+    }
+
+    // line width from block (free floating):
+    if (tmpPen.getWidth()==RS2::WidthByBlock) {
+        tmpPen.setWidth(pen.getWidth());
+    }
+
+    // line type from block (free floating):
+    if (tmpPen.getLineType()==RS2::LineByBlock) {
+        tmpPen.setLineType(pen.getLineType());
+    }
+
+    ne->setPen(tmpPen);
+    ne->setUpdateEnabled(true);
+    return ne;
+}
+
+
+
+/**
+ * Calls visitor(geometry, offset) for the block geometry and the offset
+ * of every row and col. Rows and cols farther from coord than the last
+ * distance returned by the visitor are skipped.
+ */
+template<class Visitor>
+void RS_Insert::visitInstances(const RS_Vector& coord, Visitor visitor) const {
+    const RS_BlockGeometry* geometry = getGeometry();
+    if (!geometry) {
+        return;
+    }
+
+    double minDist = RS_MAXDOUBLE;
+    for (int c=0; c<data.cols; ++c) {
+        for (int r=0; r<data.rows; ++r) {
+            RS_Vector const offset = getInstanceOffset(c, r);
+            if (geometry->bounded) {
+                RS_Vector vMin = geometry->extentMin;
+                RS_Vector vMax = geometry->extentMax;
+                if (vMin.x > vMax.x) {
+                    return;
+                }
+                vMin += offset;
+                vMax += offset;
+                mapBox(vMin, vMax);
+                if (distanceToBox(coord, vMin, vMax) > minDist) {
+                    continue;
+                }
             }
+            minDist = std::min(minDist, visitor(*geometry, offset));
         }
     }
-    calculateBorders();
+}
 
-        RS_DEBUG->print("RS_Insert::update: OK");
+
+
+/**
+ * @return the closest point query(entity, coord, scale, dist) finds in the
+ * rows and cols. If the insert only scales distances, the block geometry
+ * is queried in block coordinates and scale is the factor of distances in
+ * the drawing. Otherwise every entity is mapped into the drawing to be
+ * queried and scale is 1.
+ */
+template<class Query>
+RS_Vector RS_Insert::getNearest(const RS_Vector& coord, double* dist,
+                                Query query) const {
+    RS_Vector closest(false);
+    double minDist = RS_MAXDOUBLE;
+    double const scale = getUniformScale();
+    RS_Pen const pen = getPen();
+    RS_Layer* const layer = getLayer();
+
+    visitInstances(coord, [&](const RS_BlockGeometry& geometry,
+                   const RS_Vector& offset) {
+        double curDist = RS_MAXDOUBLE;
+        if (scale > 0.) {
+            RS_Vector const point = query(geometry.entities,
+                                          toBlock(coord) - offset, scale, curDist);
+            curDist *= scale;
+            if (point.valid && curDist < minDist) {
+                closest = toDrawing(point + offset);
+                minDist = curDist;
+            }
+            return minDist;
+        }
+
+        for (RS_Entity* e: geometry.entities) {
+            LC_SpatialIndex::Box box;
+            if (LC_SpatialIndex::entityBox(e, box)) {
+                RS_Vector vMin = RS_Vector(box.minX, box.minY) + offset;
+                RS_Vector vMax = RS_Vector(box.maxX, box.maxY) + offset;
+                mapBox(vMin, vMax);
+                if (distanceToBox(coord, vMin, vMax) > minDist) {
+                    continue;
+                }
+            }
+            std::unique_ptr<RS_Entity> ne{createInstance(e, offset, pen, layer)};
+            if (!ne->isVisible()) {
+                continue;
+            }
+            RS_Vector const point = query(*ne, coord, 1., curDist);
+            if (point.valid && curDist < minDist) {
+                closest = point;
+                minDist = curDist;
+            }
+        }
+        return minDist;
+    });
+
+    if (dist) {
+        *dist = minDist;
+    }
+    return closest;
 }
 
 
@@ -326,6 +556,294 @@ RS_Vector RS_Insert::getNearestRef(const RS_Vector& coord,
 
 
 
+/**
+ * The borders of a rotated insert can be larger than its entities, the
+ * entities are mapped into the drawing and tested then.
+ */
+bool RS_Insert::isInWindow(RS_Vector v1, RS_Vector v2) const {
+    if (RS_EntityContainer::isInWindow(v1, v2)) {
+        return true;
+    }
+    double const quadrants = data.angle/M_PI_2;
+    if (fabs(quadrants - std::round(quadrants)) < RS_TOLERANCE_ANGLE) {
+        return false;
+    }
+    const RS_BlockGeometry* geometry = getGeometry();
+    if (!geometry || getMin().x > getMax().x) {
+        return false;
+    }
+
+    RS_Pen const pen = getPen();
+    RS_Layer* const layer = getLayer();
+    for (int c=0; c<data.cols; ++c) {
+        for (int r=0; r<data.rows; ++r) {
+            for (RS_Entity* e: geometry->entities) {
+                std::unique_ptr<RS_Entity> ne{createInstance(e, getInstanceOffset(c, r),
+                                                             pen, layer)};
+                if (ne->isVisible() && !ne->isInWindow(v1, v2)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+
+
+/**
+ * @brief getExtent the box around all points queries on this insert
+ * can return, e.g. centers of arcs outside of the borders. The box is
+ * invalid if nothing is inserted.
+ * @return false, if the insert reaches out of any box
+ */
+bool RS_Insert::getExtent(RS_Vector& vMin, RS_Vector& vMax) const {
+    vMin = vMax = RS_Vector(false);
+    const RS_BlockGeometry* geometry = getGeometry();
+    if (!geometry || data.cols<1 || data.rows<1) {
+        return true;
+    }
+    if (!geometry->bounded) {
+        return false;
+    }
+    if (geometry->extentMin.x > geometry->extentMax.x) {
+        return true;
+    }
+    vMin = geometry->extentMin;
+    vMax = geometry->extentMax;
+    mapArrayBox(vMin, vMax);
+    return true;
+}
+
+
+
+/**
+ * The entities of the block are created on the first iteration.
+ */
+RS_Entity* RS_Insert::firstEntity(RS2::ResolveLevel level) {
+    resolve();
+    return RS_EntityContainer::firstEntity(level);
+}
+
+
+
+RS_Entity* RS_Insert::lastEntity(RS2::ResolveLevel level) {
+    resolve();
+    return RS_EntityContainer::lastEntity(level);
+}
+
+
+
+RS_Entity* RS_Insert::entityAt(int index) {
+    resolve();
+    return RS_EntityContainer::entityAt(index);
+}
+
+
+
+/**
+ * The borders are the borders of the block geometry in all rows and
+ * cols, mapped into the drawing.
+ */
+void RS_Insert::calculateBorders() {
+    resetBorders();
+    const RS_BlockGeometry* geometry = getGeometry();
+    if (!geometry || data.cols<1 || data.rows<1) {
+        return;
+    }
+    RS_Vector vMin = geometry->entities.getMin();
+    RS_Vector vMax = geometry->entities.getMax();
+    if (vMin.x > vMax.x || vMin.y > vMax.y) {
+        return;
+    }
+    mapArrayBox(vMin, vMax);
+    minV = vMin;
+    maxV = vMax;
+}
+
+
+
+double RS_Insert::getLength() const {
+    const RS_BlockGeometry* geometry = getGeometry();
+    if (!geometry) {
+        return 0.;
+    }
+
+    double const scale = getUniformScale();
+    if (scale > 0.) {
+        double const l = geometry->entities.getLength();
+        return l < 0. ? l : l*scale*data.cols*data.rows;
+    }
+
+    double ret = 0.;
+    RS_Pen const pen = getPen();
+    RS_Layer* const layer = getLayer();
+    for (int c=0; c<data.cols; ++c) {
+        for (int r=0; r<data.rows; ++r) {
+            for (RS_Entity* e: geometry->entities) {
+                std::unique_ptr<RS_Entity> ne{createInstance(e, getInstanceOffset(c, r),
+                                                             pen, layer)};
+                if (!ne->isVisible()) {
+                    continue;
+                }
+                double const l = ne->getLength();
+                if (l < 0.) {
+                    return -1.;
+                }
+                ret += l;
+            }
+        }
+    }
+    return ret;
+}
+
+
+
+RS_Vector RS_Insert::getNearestEndpoint(const RS_Vector& coord,
+                                        double* dist) const {
+    return getNearest(coord, dist, [](const RS_Entity& e, const RS_Vector& v,
+                      double /*scale*/, double& d) {
+        return e.getNearestEndpoint(v, &d);
+    });
+}
+
+
+
+RS_Vector RS_Insert::getNearestPointOnEntity(const RS_Vector& coord,
+                                             bool onEntity, double* dist,
+                                             RS_Entity** entity) const {
+    if (entity) {
+        *entity = const_cast<RS_Insert*>(this);
+    }
+    return getNearest(coord, dist, [onEntity](const RS_Entity& e, const RS_Vector& v,
+                      double /*scale*/, double& d) {
+        return e.getNearestPointOnEntity(v, onEntity, &d);
+    });
+}
+
+
+
+RS_Vector RS_Insert::getNearestCenter(const RS_Vector& coord,
+                                      double* dist) const {
+    return getNearest(coord, dist, [](const RS_Entity& e, const RS_Vector& v,
+                      double /*scale*/, double& d) {
+        return e.getNearestCenter(v, &d);
+    });
+}
+
+
+
+RS_Vector RS_Insert::getNearestMiddle(const RS_Vector& coord,
+                                      double* dist,
+                                      int middlePoints) const {
+    return getNearest(coord, dist, [middlePoints](const RS_Entity& e, const RS_Vector& v,
+                      double /*scale*/, double& d) {
+        return e.getNearestMiddle(v, &d, middlePoints);
+    });
+}
+
+
+
+RS_Vector RS_Insert::getNearestDist(double distance,
+                                    const RS_Vector& coord,
+                                    double* dist) const {
+    return getNearest(coord, dist, [distance](const RS_Entity& e, const RS_Vector& v,
+                      double scale, double& d) {
+        return e.getNearestDist(distance/scale, v, &d);
+    });
+}
+
+
+
+/**
+ * The entities of the block are only created for the levels which return
+ * the closest entity of the insert, the insert is returned otherwise.
+ */
+double RS_Insert::getDistanceToPoint(const RS_Vector& coord,
+                                     RS_Entity** entity,
+                                     RS2::ResolveLevel level,
+                                     double solidDist) const {
+    if (level==RS2::ResolveAll || level==RS2::ResolveAllButTextImage) {
+        const_cast<RS_Insert*>(this)->resolve();
+        return RS_EntityContainer::getDistanceToPoint(coord, entity, level, solidDist);
+    }
+
+    if (entity) {
+        *entity = const_cast<RS_Insert*>(this);
+    }
+    double dist = RS_MAXDOUBLE;
+    getNearest(coord, &dist, [solidDist](const RS_Entity& e, const RS_Vector& v,
+               double scale, double& d) {
+        d = e.getDistanceToPoint(v, nullptr, RS2::ResolveNone, solidDist/scale);
+        // only the distance is used
+        return v;
+    });
+    return dist;
+}
+
+
+
+/**
+ * Draws the block geometry in every row and col, only the entities in
+ * the viewport are mapped into the drawing.
+ */
+void RS_Insert::draw(RS_Painter* painter, RS_GraphicView* view,
+                     double& /*patternOffset*/) {
+    if (!(painter && view)) {
+        return;
+    }
+    const RS_BlockGeometry* geometry = getGeometry();
+    if (!geometry) {
+        return;
+    }
+
+    // the viewport in the drawing and in block coordinates
+    RS_Vector const corners[] = {
+        view->toGraph(0, 0), view->toGraph(view->getWidth(), 0),
+        view->toGraph(view->getWidth(), view->getHeight()),
+        view->toGraph(0, view->getHeight())
+    };
+    RS_Vector viewMin = corners[0];
+    RS_Vector viewMax = corners[0];
+    RS_Vector blockMin = toBlock(corners[0]);
+    RS_Vector blockMax = blockMin;
+    for (const RS_Vector& corner: corners) {
+        viewMin = RS_Vector::minimum(viewMin, corner);
+        viewMax = RS_Vector::maximum(viewMax, corner);
+        RS_Vector const v = toBlock(corner);
+        blockMin = RS_Vector::minimum(blockMin, v);
+        blockMax = RS_Vector::maximum(blockMax, v);
+    }
+
+    RS_Pen const pen = getPen();
+    RS_Layer* const layer = getLayer();
+    for (int c=0; c<data.cols; ++c) {
+        for (int r=0; r<data.rows; ++r) {
+            RS_Vector const offset = getInstanceOffset(c, r);
+            std::vector<RS_Entity*> visible;
+            if (view->isPrinting()) {
+                visible.assign(geometry->entities.begin(), geometry->entities.end());
+            } else {
+                RS_Vector vMin = geometry->entities.getMin() + offset;
+                RS_Vector vMax = geometry->entities.getMax() + offset;
+                mapBox(vMin, vMax);
+                if (vMax.x < viewMin.x || vMax.y < viewMin.y
+                        || vMin.x > viewMax.x || vMin.y > viewMax.y) {
+                    continue;
+                }
+                visible = geometry->entities.getEntitiesOverlappingWindow(blockMin - offset,
+                                                                          blockMax - offset);
+            }
+            for (RS_Entity* e: visible) {
+                std::unique_ptr<RS_Entity> ne{createInstance(e, offset, pen, layer)};
+                view->drawEntity(painter, ne.get());
+            }
+        }
+    }
+}
+
+
+
 void RS_Insert::move(const RS_Vector& offset) {
         RS_DEBUG->print("RS_Insert::move: offset: %f/%f",
                 offset.x, offset.y);
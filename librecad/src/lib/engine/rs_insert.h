@@ -31,6 +31,7 @@
 #include "rs_entitycontainer.h"
 
 class RS_BlockList;
+struct RS_BlockGeometry;
 
 /**
  * Holds the data that defines an insert.
@@ -87,6 +88,13 @@ std::ostream& operator << (std::ostream& os, const RS_InsertData& d);
  * refer to a block. However, to the outside world they act exactly
  * like EntityContainer.
  *
+ * The geometry of the block is shared by all of its inserts, see
+ * RS_Block::getGeometry(). Drawing, snapping and the borders map the
+ * block geometry through the transformation of the insert for every row
+ * and col. The entities of the insert are only created when they are
+ * iterated or picked, e.g. to explode or trim, and dropped on the next
+ * update().
+ *
  * @author Andrew Mustun
  */
 class RS_Insert : public RS_EntityContainer {
@@ -96,6 +104,7 @@ public:
 	virtual ~RS_Insert() = default;
 
 	virtual RS_Entity* clone() const;
+	RS_Insert* cloneUnresolved() const;
 
     /** @return RS2::EntityInsert */
     virtual RS2::EntityType rtti() const {
@@ -118,6 +127,9 @@ public:
 	RS_Block* getBlockForInsert() const;
 
     virtual void update();
+	void resolve();
+	void appendFlattened(RS_EntityContainer& container,
+						 const RS_Vector& offset) const;
 
     QString getName() const {
         return data.name;
@@ -172,6 +184,15 @@ public:
         }
 
 	virtual bool isVisible() const;
+	bool isInWindow(RS_Vector v1, RS_Vector v2) const override;
+	bool getExtent(RS_Vector& vMin, RS_Vector& vMax) const;
+
+	RS_Entity* firstEntity(RS2::ResolveLevel level=RS2::ResolveNone) override;
+	RS_Entity* lastEntity(RS2::ResolveLevel level=RS2::ResolveNone) override;
+	RS_Entity* entityAt(int index) override;
+
+	void calculateBorders() override;
+	double getLength() const override;
 
 	virtual RS_VectorSolutions getRefPoints() const;
     virtual RS_Vector getMiddlePoint(void) const{
@@ -179,6 +200,24 @@ public:
     }
     virtual RS_Vector getNearestRef(const RS_Vector& coord,
 									 double* dist = nullptr) const;
+	RS_Vector getNearestEndpoint(const RS_Vector& coord,
+								 double* dist = nullptr) const override;
+	RS_Vector getNearestPointOnEntity(const RS_Vector& coord,
+									  bool onEntity = true,
+									  double* dist = nullptr,
+									  RS_Entity** entity = nullptr) const override;
+	RS_Vector getNearestCenter(const RS_Vector& coord,
+							   double* dist = nullptr) const override;
+	RS_Vector getNearestMiddle(const RS_Vector& coord,
+							   double* dist = nullptr,
+							   int middlePoints = 1) const override;
+	RS_Vector getNearestDist(double distance,
+							 const RS_Vector& coord,
+							 double* dist = nullptr) const override;
+	double getDistanceToPoint(const RS_Vector& coord,
+							  RS_Entity** entity,
+							  RS2::ResolveLevel level=RS2::ResolveNone,
+							  double solidDist = RS_MAXDOUBLE) const override;
 
     virtual void move(const RS_Vector& offset);
     virtual void rotate(const RS_Vector& center, const double& angle);
@@ -186,11 +225,44 @@ public:
     virtual void scale(const RS_Vector& center, const RS_Vector& factor);
     virtual void mirror(const RS_Vector& axisPoint1, const RS_Vector& axisPoint2);
 
+	void draw(RS_Painter* painter, RS_GraphicView* view, double& patternOffset) override;
+
     friend std::ostream& operator << (std::ostream& os, const RS_Insert& i);
 
 protected:
     RS_InsertData data;
 	mutable RS_Block* block;
+
+private:
+	const RS_BlockGeometry* getGeometry() const;
+	//! \{
+	//! maps points between block and drawing, the block point includes the
+	//! offset of the row and col
+	RS_Vector toDrawing(const RS_Vector& v) const;
+	RS_Vector toBlock(const RS_Vector& v) const;
+	//! \}
+	//! offset of a row and col in block coordinates
+	RS_Vector getInstanceOffset(int col, int row) const;
+	//! the box in the drawing around the mapped block box vMin, vMax
+	void mapBox(RS_Vector& vMin, RS_Vector& vMax) const;
+	//! the box in the drawing around the block box vMin, vMax in all rows and cols
+	void mapArrayBox(RS_Vector& vMin, RS_Vector& vMax) const;
+	//! the factor of distances in the drawing, 0 if the scale isn't uniform
+	double getUniformScale() const;
+	/**
+	 * @return a copy of the block entity e moved by offset and mapped into
+	 * the drawing, the layer 0 and ByBlock attributes are taken from layer
+	 * and pen
+	 */
+	RS_Entity* createInstance(const RS_Entity* e, const RS_Vector& offset,
+							  const RS_Pen& pen, RS_Layer* layer) const;
+	template<class Visitor>
+	void visitInstances(const RS_Vector& coord, Visitor visitor) const;
+	template<class Query>
+	RS_Vector getNearest(const RS_Vector& coord, double* dist, Query query) const;
+
+	//! the entities of the block were created by resolve()
+	bool resolved {false};
 };
 
 
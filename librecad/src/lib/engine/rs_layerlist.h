@@ -29,6 +29,7 @@
 #ifndef RS_LAYERLIST_H
 #define RS_LAYERLIST_H
 
+#include <QHash>
 #include <QList>
 #include "rs_layer.h"
 
@@ -129,6 +130,8 @@ public:
 private:
     //! layers in the graphic
     QList<RS_Layer*> layers;
+    //! layers by name, layer names must be changed through edit()
+    QHash<QString, RS_Layer*> layersByName;
     //! List of registered LayerListListeners
     QList<RS_LayerListListener*> layerListListeners;
     QG_LayerWidget* layerWidget;
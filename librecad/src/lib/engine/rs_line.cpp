@@ -613,89 +613,35 @@ void RS_Line::draw(RS_Painter* painter, RS_GraphicView* view, double& patternOff
         return;
     }
 
-    auto viewportRect = view->getViewRect();
-    RS_VectorSolutions endPoints(0);
-    endPoints.push_back(getStartpoint());
-    endPoints.push_back(getEndpoint());
-
-    RS_EntityContainer ec(nullptr);
-    ec.addRectangle(viewportRect.minP(), viewportRect.maxP());
-
-//    if (viewportRect.inArea(getStartpoint(), RS_TOLERANCE))
-//         endPoints.push_back(getStartpoint());
-//    if (viewportRect.inArea(getEndpoint(), RS_TOLERANCE))
-//         endPoints.push_back(getEndpoint());
-
-//    if (endPoints.size() < 2){
-//        RS_VectorSolutions vpIts;
-//        for(auto p: ec) {
-//            auto const sol=RS_Information::getIntersection(this, p, true);
-//            for (auto const& vp: sol) {
-//                if (vpIts.getClosestDistance(vp) <= RS_TOLERANCE * 10.)
-//                    continue;
-//                vpIts.push_back(vp);
-//            }
-//        }
-//        for (auto const& vp: vpIts) {
-//            if (endPoints.getClosestDistance(vp) <= RS_TOLERANCE * 10.)
-//                continue;
-//            endPoints.push_back(vp);
-//        }
-//    }
-
-//    if (endPoints.size()<2) return;
-
-    if ((endPoints[0] - getStartpoint()).squared() >
-            (endPoints[1] - getStartpoint()).squared() )
-    {
-        std::swap(endPoints[0],endPoints[1]);
-    }
-
-	RS_Vector pStart{view->toGui(endPoints.at(0))};
-	RS_Vector pEnd{view->toGui(endPoints.at(1))};
-    //    std::cout<<"draw line: "<<pStart<<" to "<<pEnd<<std::endl;
+	RS_Vector const guiStart{view->toGui(getStartpoint())};
+	RS_Vector const guiEnd{view->toGui(getEndpoint())};
+	//extend line on a construction layer to fill the whole view
+	bool const construction = isConstruction(true)
+			&& (guiEnd - guiStart).squared() > RS_TOLERANCE;
+
+	// clip to the viewport, the margin keeps wide pens near its border
+	double const margin = 1. + painter->getPen().getScreenWidth();
+	LC_Rect const viewport{RS_Vector(-margin, -margin),
+				RS_Vector(view->getWidth() + margin, view->getHeight() + margin)};
+	RS_Vector pStart{guiStart};
+	RS_Vector pEnd{guiEnd};
+	if (!viewport.clipLine(pStart, pEnd, construction)) {
+		patternOffset -= guiStart.distanceTo(guiEnd);
+		return;
+	}
 	RS_Vector direction = pEnd-pStart;
 
-	if (isConstruction(true) && direction.squared() > RS_TOLERANCE){
-        //extend line on a construction layer to fill the whole view
-		RS_VectorSolutions vpIts;
-		for(auto p: ec) {
-            auto const sol=RS_Information::getIntersection(this, p, true);
-			for (auto const& vp: sol) {
-				if (vpIts.getClosestDistance(vp) <= RS_TOLERANCE * 10.)
-					continue;
-				vpIts.push_back(vp);
-			}
-		}
-
-		//draw construction lines up to viewport border
-		switch (vpIts.size()) {
-		case 2:
-			// no need to sort intersections
-			break;
-		case 3:
-		case 4: {
-			// will use the inner two points
-			size_t i{0};
-			for (size_t j = 0; j < vpIts.size(); ++j)
-				if (viewportRect.inArea(vpIts.at(j), RS_TOLERANCE * 10.))
-					std::swap(vpIts[j], vpIts[i++]);
-
-		}
-			break;
-		default:
-			//should not happen
-			return;
-		}
-		pStart=view->toGui(vpIts.get(0));
-		pEnd=view->toGui(vpIts.get(1));
-		direction=pEnd-pStart;
-    }
-
     bool drawAsSelected = isSelected() && !(view->isPrinting() || view->isPrintPreview());
 
     double  length=direction.magnitude();
-    patternOffset -= length;
+	// dashes stay where they were on the unclipped line
+	double skipped = 0.;
+	if (construction) {
+		patternOffset -= length;
+	} else {
+		patternOffset -= guiStart.distanceTo(guiEnd);
+		skipped = guiStart.distanceTo(pStart);
+	}
     if (( !drawAsSelected && (
               getPen().getLineType()==RS2::SolidLine ||
               view->getDrawingMode()==RS2::ModePreview)) ) {
@@ -736,37 +682,29 @@ void RS_Line::draw(RS_Painter* painter, RS_GraphicView* view, double& patternOff
 
 	if (pat->num <= 0) {
 		RS_DEBUG->print(RS_Debug::D_WARNING,"invalid line pattern for line, draw solid line instead");
-		painter->drawLine(view->toGui(getStartpoint()),
-						  view->toGui(getEndpoint()));
+		painter->drawLine(pStart, pEnd);
 		return;
 	}
 
 	// pattern segment length:
 	double patternSegmentLength = pat->totalLength;
 
-	// create pattern:
-	std::vector<RS_Vector> dp(pat->num);
-	std::vector<double> ds(pat->num);
 	double dpmm=static_cast<RS_PainterQt*>(painter)->getDpmm();
-	for (size_t i=0; i < pat->num; ++i) {
-		//        ds[j]=pat->pattern[i] * styleFactor;
-		//fixme, styleFactor support needed
-
-		ds[i]=dpmm*pat->pattern[i];
-		if (fabs(ds[i]) < 1. ) ds[i] = copysign(1., ds[i]);
-		dp[i] = direction*fabs(ds[i]);
-	}
-	double total= remainder(patternOffset-0.5*patternSegmentLength,patternSegmentLength) -0.5*patternSegmentLength;
+	double total= remainder(patternOffset-skipped-0.5*patternSegmentLength,patternSegmentLength) -0.5*patternSegmentLength;
     //    double total= patternOffset-patternSegmentLength;
 
 	RS_Vector curP{pStart+direction*total};
-	for (int j=0; total<length; j=(j+1)%pat->num) {
+	for (size_t j=0; total<length; j=(j+1)%pat->num) {
+		//        ds=pat->pattern[j] * styleFactor;
+		//fixme, styleFactor support needed
+		double ds=dpmm*pat->pattern[j];
+		if (fabs(ds) < 1. ) ds = copysign(1., ds);
 
         // line segment (otherwise space segment)
-		double const t2=total+fabs(ds[j]);
-		RS_Vector const& p3=curP+dp[j];
-        if (ds[j]>0.0 && t2 > 0.0) {
-            // drop the whole pattern segment line, for ds[i]<0:
+		double const t2=total+fabs(ds);
+		RS_Vector const p3=curP+direction*fabs(ds);
+        if (ds>0.0 && t2 > 0.0) {
+            // drop the whole pattern segment line, for ds<0:
             // trim end points of pattern segment line to line
 			RS_Vector const& p1 =(total > -0.5)?curP:pStart;
 			RS_Vector const& p2 =(t2 < length+0.5)?p3:pEnd;
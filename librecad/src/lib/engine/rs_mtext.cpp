@@ -29,6 +29,8 @@
 #include "rs_font.h"
 #include "rs_mtext.h"
 
+#include "lc_glyphrun.h"
+#include "rs_block.h"
 #include "rs_fontlist.h"
 #include "rs_insert.h"
 #include "rs_math.h"
@@ -249,6 +251,8 @@ void RS_MText::update()
     // Every single text line gets stored in this entity container
     // so we can move the whole line around easily:
     RS_EntityContainer* oneLine {new RS_EntityContainer(this)};
+    // Letters of the line, unless inserts were requested by createLetters():
+    LC_GlyphRun* lineGlyphs {nullptr};
 
     // First every text line is created with
     //   alignment: top left
@@ -265,6 +269,7 @@ void RS_MText::update()
             // line feed:
             updateAddLine( oneLine, lineCounter++);
             oneLine = new RS_EntityContainer(this);
+            lineGlyphs = nullptr;
             letterPos = RS_Vector( 0.0, -9.0);
             break;
 
@@ -281,6 +286,7 @@ void RS_MText::update()
             case 'P':
                 updateAddLine( oneLine, lineCounter++);
                 oneLine = new RS_EntityContainer(this);
+                lineGlyphs = nullptr;
                 letterPos = RS_Vector( 0.0, -9.0);
                 handled = true;
                 break;
@@ -363,6 +369,9 @@ void RS_MText::update()
                                                                   RS2::Update)) };
                     upper->setLayer( nullptr);
                     upper->setPen( RS_Pen( RS2::FlagInvalid));
+                    if (letterInserts) {
+                        upper->createLetters();
+                    }
                     upper->calculateBorders();
                     oneLine->addEntity(upper);
                     upperWidth = upper->getSize().x;
@@ -385,6 +394,9 @@ void RS_MText::update()
                                                                   RS2::Update)) };
                     lower->setLayer( nullptr);
                     lower->setPen( RS_Pen( RS2::FlagInvalid));
+                    if (letterInserts) {
+                        lower->createLetters();
+                    }
                     lower->calculateBorders();
                     oneLine->addEntity(lower);
                     lowerWidth = lower->getSize().x;
@@ -417,37 +429,52 @@ void RS_MText::update()
         default: {
             // One Letter:
             QString letterText {QString(data.text.at(i))};
-            if (nullptr == font->findLetter( letterText)) {
+            const RS_Font::Glyph* glyph {font->findGlyph( letterText)};
+            if (nullptr == glyph) {
                 RS_DEBUG->print("RS_MText::update: missing font for letter( %s ), replaced it with QChar(0xfffd)",
                                 qPrintable( letterText));
                 letterText = QChar( 0xfffd);
+                glyph = font->findGlyph( letterText);
             }
 
             RS_DEBUG->print("RS_MText::update: insert a letter at pos: %f/%f", letterPos.x, letterPos.y);
 
-            RS_InsertData d( letterText,
-                             letterPos,
-                             RS_Vector( 1.0, 1.0),
-                             0.0,
-                             1,
-                             1,
-                             RS_Vector( 0.0, 0.0),
-                             font->getLetterList(),
-                             RS2::NoUpdate);
-
-            RS_Insert* letter {new RS_Insert(this, d)};
             RS_Vector letterWidth;
-            letter->setPen( RS_Pen( RS2::FlagInvalid));
-            letter->setLayer( nullptr);
-            letter->update();
-            letter->forcedCalculateBorders();
-
-            letterWidth = RS_Vector( letter->getMax().x - letterPos.x, 0.0);
+            if (nullptr != glyph) {
+                letterWidth = RS_Vector( glyph->letter->getMax().x - glyph->letter->getBasePoint().x, 0.0);
+            }
             if (0 > letterWidth.x) {
                 letterWidth.x = -letterSpace.x;
             }
 
-            oneLine->addEntity( letter);
+            if (letterInserts) {
+                RS_InsertData d( letterText,
+                                 letterPos,
+                                 RS_Vector( 1.0, 1.0),
+                                 0.0,
+                                 1,
+                                 1,
+                                 RS_Vector( 0.0, 0.0),
+                                 font->getLetterList(),
+                                 RS2::NoUpdate);
+
+                // the entities of the letter are created once the line is
+                // in place, the layout only needs the borders of the glyph
+                RS_Insert* letter {new RS_Insert(this, d)};
+                letter->setPen( RS_Pen( RS2::FlagInvalid));
+                letter->setLayer( nullptr);
+                letter->setUpdateEnabled( false);
+                oneLine->addEntity( letter);
+            }
+            else if (nullptr != glyph) {
+                if (nullptr == lineGlyphs) {
+                    lineGlyphs = new LC_GlyphRun( oneLine);
+                    lineGlyphs->setPen( RS_Pen( RS2::FlagInvalid));
+                    lineGlyphs->setLayer( nullptr);
+                    oneLine->addEntity( lineGlyphs);
+                }
+                lineGlyphs->append( glyph, letterPos, RS_Vector( 1.0, 1.0), 0.0);
+            }
 
             // next letter position:
             letterPos += letterWidth;
@@ -464,6 +491,19 @@ void RS_MText::update()
         RS_EntityContainer::move( ot);
     }
 
+    // all letters are in place, create the entities of letter inserts:
+    for (RS_Entity* line: entities) {
+        if (RS2::EntityContainer != line->rtti()) {
+            continue;
+        }
+        for (RS_Entity* e: *static_cast<RS_EntityContainer*>(line)) {
+            if (RS2::EntityInsert == e->rtti()) {
+                e->setUpdateEnabled( true);
+                e->update();
+            }
+        }
+    }
+
     usedTextHeight -= data.height * data.lineSpacingFactor * 5.0 / 3.0 - data.height;
     forcedCalculateBorders();
 
@@ -484,20 +524,35 @@ void RS_MText::update()
 double RS_MText::updateAddLine(RS_EntityContainer* textLine, int lineCounter) {
     double ls =5.0/3.0;
 
-    RS_DEBUG->print("RS_MText::updateAddLine: width: %f", textLine->getSize().x);
-
-        //textLine->forcedCalculateBorders();
-    //RS_DEBUG->print("RS_MText::updateAddLine: width 2: %f", textLine->getSize().x);
+    // Letter inserts have no entities yet, their borders are taken
+    // from the glyphs:
+    RS_Vector lineMin {RS_MAXDOUBLE, RS_MAXDOUBLE};
+    RS_Vector lineMax {RS_MINDOUBLE, RS_MINDOUBLE};
+    for (RS_Entity* e: *textLine) {
+        RS_Vector eMin {e->getMin()};
+        RS_Vector eMax {e->getMax()};
+        if (RS2::EntityInsert == e->rtti()) {
+            RS_Insert* letter {static_cast<RS_Insert*>(e)};
+            RS_Block* block {letter->getBlockForInsert()};
+            if (nullptr == block) {
+                continue;
+            }
+            RS_Vector offset {letter->getInsertionPoint() - block->getBasePoint()};
+            eMin = block->getMin() + offset;
+            eMax = block->getMax() + offset;
+        }
+        lineMin = RS_Vector::minimum( lineMin, eMin);
+        lineMax = RS_Vector::maximum( lineMax, eMax);
+    }
+    if (lineMin.x > lineMax.x || lineMin.y > lineMax.y) {
+        lineMin = lineMax = RS_Vector( 0.0, 0.0);
+    }
 
     // Move to correct line position:
-    textLine->move(RS_Vector(0.0, -9.0 * lineCounter
-                             * data.lineSpacingFactor * ls));
+    double lineOffset {-9.0 * lineCounter * data.lineSpacingFactor * ls};
+    textLine->move(RS_Vector(0.0, lineOffset));
 
-    if( ! RS_EntityContainer::autoUpdateBorders) {
-        //only update borders when needed
-        textLine->forcedCalculateBorders();
-    }
-    RS_Vector textSize = textLine->getSize();
+    RS_Vector textSize = lineMax - lineMin;
 
         RS_DEBUG->print("RS_MText::updateAddLine: width 2: %f", textSize.x);
 
@@ -523,10 +578,12 @@ double RS_MText::updateAddLine(RS_EntityContainer* textLine, int lineCounter) {
     switch (data.valign) {
     case RS_MTextData::VAMiddle:
         textLine->move(RS_Vector(0.0, vSize/2.0));
+        lineOffset += vSize/2.0;
         break;
 
     case RS_MTextData::VABottom:
         textLine->move(RS_Vector(0.0, vSize));
+        lineOffset += vSize;
         break;
 
     default:
@@ -537,17 +594,16 @@ double RS_MText::updateAddLine(RS_EntityContainer* textLine, int lineCounter) {
     textLine->scale(RS_Vector(0.0,0.0),
                     RS_Vector(data.height/9.0, data.height/9.0));
 
-    textLine->forcedCalculateBorders();
-
     // Update actual text size (before rotating, after scaling!):
-    if (textLine->getSize().x>usedTextWidth) {
-        usedTextWidth = textLine->getSize().x;
+    if (std::abs(textSize.x*data.height/9.0)>usedTextWidth) {
+        usedTextWidth = std::abs(textSize.x*data.height/9.0);
     }
 
     usedTextHeight += data.height*data.lineSpacingFactor*ls;
 
     // Gets the distance over text base-line (before rotating, after scaling!):
-    double textTail = textLine->getMin().y;
+    double textTail {textLine->isEmpty() ? 0.0
+                                          : (lineMin.y + lineOffset)*data.height/9.0};
 
     // Rotate:
     textLine->rotate(RS_Vector(0.0,0.0), data.angle);
@@ -563,6 +619,18 @@ double RS_MText::updateAddLine(RS_EntityContainer* textLine, int lineCounter) {
 }
 
 
+/**
+ * Replaces the glyphs of this text by an insert for every letter. The
+ * inserts are only needed where the letters become entities of their
+ * own, e.g. when the text is exploded.
+ */
+void RS_MText::createLetters()
+{
+    letterInserts = true;
+    update();
+}
+
+
 RS_Vector RS_MText::getNearestEndpoint(const RS_Vector& coord, double* dist)const {
     if (dist) {
         *dist = data.insertionPoint.distanceTo(coord);
@@ -24,9 +24,12 @@
 **
 **********************************************************************/
 
+#include<algorithm>
+#include<array>
 #include<iostream>
 #include<cmath>
 #include<numeric>
+#include<QPainterPath>
 
 #include "rs_spline.h"
 
@@ -158,6 +161,9 @@ void RS_Spline::update() {
     RS_DEBUG->print("RS_Spline::update");
 
     clear();
+    curvePoints.clear();
+    curveKnots.clear();
+    drawWindow = LC_Rect();
 
     if (isUndone()) {
         return;
@@ -175,30 +181,27 @@ void RS_Spline::update() {
 
     resetBorders();
 
-	std::vector<RS_Vector> tControlPoints = data.controlPoints;
+	curvePoints = data.controlPoints;
 
     if (data.closed) {
 		for (size_t i=0; i<data.degree; ++i) {
-			tControlPoints.push_back(data.controlPoints.at(i));
+			curvePoints.push_back(data.controlPoints.at(i));
         }
     }
 
-	const size_t npts = tControlPoints.size();
+	const size_t npts = curvePoints.size();
     // order:
 	const size_t  k = data.degree+1;
+	curveKnots = data.closed ? knotu(npts, k) : knot(npts, k);
+
     // resolution:
 	const size_t  p1 = getGraphicVariableInt("$SPLINESEGS", 8) * npts;
-
-	std::vector<double> h(npts+1, 1.);
-	std::vector<RS_Vector> p(p1, {0., 0.});
-    if (data.closed) {
-		rbsplinu(npts,k,p1,tControlPoints,h,p);
-    } else {
-		rbspline(npts,k,p1,tControlPoints,h,p);
-    }
+	double const t0 = curveKnots[k-1];
+	double const step = (curveKnots[npts] - t0) / (p1-1);
 
 	RS_Vector prev{};
-	for (auto const& vp: p) {
+	for (size_t i = 0; i < p1; ++i) {
+		RS_Vector const vp = evaluate(i + 1 < p1 ? t0 + step*i : curveKnots[npts]);
 		if (prev.valid) {
 			RS_Line* line = new RS_Line{this, prev, vp};
 			line->setLayer(nullptr);
@@ -306,6 +309,10 @@ void RS_Spline::move(const RS_Vector& offset) {
 	for (RS_Vector& vp: data.controlPoints) {
 		vp.move(offset);
     }
+	for (RS_Vector& vp: curvePoints) {
+		vp.move(offset);
+	}
+	drawWindow = LC_Rect();
 //    update();
 }
 
@@ -322,6 +329,10 @@ void RS_Spline::rotate(const RS_Vector& center, const RS_Vector& angleVector) {
 	for (RS_Vector& vp: data.controlPoints) {
 		vp.rotate(center, angleVector);
 	}
+	for (RS_Vector& vp: curvePoints) {
+		vp.rotate(center, angleVector);
+	}
+	drawWindow = LC_Rect();
 //    update();
 }
 
@@ -368,6 +379,51 @@ void RS_Spline::draw(RS_Painter* painter, RS_GraphicView* view, double& /*patter
         return;
     }
 
+	// solid lines are drawn from vertices at the resolution of the view,
+	// patterns continue along the child lines
+	bool const drawAsSelected = isSelected() && !(view->isPrinting() || view->isPrintPreview());
+	if (!curveKnots.empty() && !drawAsSelected
+			&& (getPen().getLineType() == RS2::SolidLine
+				|| view->getDrawingMode() == RS2::ModePreview)) {
+		// half a pixel, rounded down to a power of 2 so the vertices are
+		// reused while zooming within a factor of 2
+		int const level = static_cast<int>(std::floor(std::log2(0.5 / view->getFactor().x)));
+		// the part of the view rendered now, e.g. a row of tiles, which
+		// may reach past the view
+		LC_Rect const rendered(view->toGraph(0, 0),
+							   view->toGraph(view->getWidth(), view->getHeight()));
+		// only the part around the view is flattened, the vertices are
+		// kept until the view or the rendered part leaves it
+		LC_Rect const visible = view->getVisibleArea().merge(rendered);
+		if (level != drawLevel || !visible.inArea(drawWindow)) {
+			RS_Vector const margin = (visible.maxP() - visible.minP()) * 0.5;
+			drawWindow = LC_Rect(visible.minP() - margin, visible.maxP() + margin);
+			tessellate(std::ldexp(1., level), drawWindow, drawPoints);
+			drawLevel = level;
+		}
+
+		// segments outside of the rendered part are left out of the path
+		QPainterPath path;
+		bool penDown = false;
+		for (size_t i = 1; i < drawPoints.size(); ++i) {
+			RS_Vector const& p1 = drawPoints[i - 1];
+			RS_Vector const& p2 = drawPoints[i];
+			if (!p1.valid || !p2.valid
+					|| !rendered.intersects(LC_Rect(p1, p2))) {
+				penDown = false;
+				continue;
+			}
+			if (!penDown) {
+				RS_Vector const vp = view->toGui(p1);
+				path.moveTo(QPointF(vp.x, vp.y));
+				penDown = true;
+			}
+			RS_Vector const vp = view->toGui(p2);
+			path.lineTo(QPointF(vp.x, vp.y));
+		}
+		painter->drawPath(path);
+		return;
+	}
 
     RS_Entity* e=firstEntity(RS2::ResolveNone);
 	if (e) {
@@ -503,88 +559,6 @@ std::vector<double> RS_Spline::knot(size_t num, size_t order) const{
 
 
 
-/**
- * Generates rational B-spline basis functions for an open knot vector.
- */
-namespace{
-std::vector<double> rbasis(int c, double t, int npts,
-                                      const std::vector<double>& x,
-                                      const std::vector<double>& h) {
-
-	int const nplusc = npts + c;
-
-	std::vector<double> temp(nplusc,0.);
-
-    // calculate the first order nonrational basis functions n[i]
-	for (int i = 0; i< nplusc-1; i++)
-		if ((t >= x[i]) && (t < x[i+1])) temp[i] = 1;
-
-    /* calculate the higher order nonrational basis functions */
-
-	for (int k = 2; k <= c; k++) {
-		for (int i = 0; i < nplusc-k; i++) {
-			// if the lower order basis function is zero skip the calculation
-            if (temp[i] != 0)
-				temp[i] = ((t-x[i])*temp[i])/(x[i+k-1]-x[i]);
-            // if the lower order basis function is zero skip the calculation
-            if (temp[i+1] != 0)
-				temp[i] += ((x[i+k]-t)*temp[i+1])/(x[i+k]-x[i+1]);
-        }
-    }
-
-    // pick up last point
-	if (t >= x[nplusc-1]) temp[npts-1] = 1;
-
-    // calculate sum for denominator of rational basis functions
-	double sum = 0.;
-	for (int i = 0; i < npts; i++) {
-		sum += temp[i]*h[i];
-    }
-
-	std::vector<double> r(npts, 0);
-    // form rational basis functions and put in r vector
-	if (sum != 0) {
-		for (int i = 0; i < npts; i++)
-			r[i] = (temp[i]*h[i])/sum;
-	}
-	return r;
-}
-}
-
-
-/**
- * Generates a rational B-spline curve using a uniform open knot vector.
- */
-void RS_Spline::rbspline(size_t npts, size_t k, size_t p1,
-                         const std::vector<RS_Vector>& b,
-                         const std::vector<double>& h,
-                         std::vector<RS_Vector>& p) const{
-	size_t const nplusc = npts + k;
-
-	// generate the open knot vector
-	auto const x = knot(npts, k);
-
-    // calculate the points on the rational B-spline curve
-    double t {x[0]};
-    double const step {(x[nplusc-1] - t) / (p1-1)};
-
-	for (auto& vp: p) {
-		if (x[nplusc-1] - t < 5e-6) t = x[nplusc-1];
-
-        // generate the basis function for this value of t
-		auto const nbasis = rbasis(k, t, npts, x, h);
-
-        // generate a point on the curve
-		for (size_t i = 0; i < npts; i++)
-			vp += b[i] * nbasis[i];
-
-		t += step;
-    }
-
-}
-
-
-
 std::vector<double> RS_Spline::knotu(size_t num, size_t order) const{
 	if (data.knotslist.size() == num + order) {
 		//use custom knot vector
@@ -597,31 +571,102 @@ std::vector<double> RS_Spline::knotu(size_t num, size_t order) const{
 
 
 
-void RS_Spline::rbsplinu(size_t npts, size_t k, size_t p1,
-                         const std::vector<RS_Vector>& b,
-                         const std::vector<double>& h,
-                         std::vector<RS_Vector>& p) const{
-	size_t const nplusc = npts + k;
-
-	/* generate the periodic knot vector */
-	std::vector<double> const x = knotu(npts, k);
-
-    /*    calculate the points on the rational B-spline curve */
-	double t = k-1;
-	double const step = double(npts - k + 1)/(p1 - 1);
-
-	for (auto& vp: p) {
-		if (x[nplusc-1] - t < 5e-6) t = x[nplusc-1];
+/**
+ * de Boor's algorithm on the cached knots, the curve is defined for
+ * t in [knots[order-1], knots[npts]].
+ */
+RS_Vector RS_Spline::evaluate(double t) const{
+	size_t const p = data.degree;
+	size_t const npts = curvePoints.size();
+
+	// knot span, the end of the curve belongs to the last span
+	size_t i = std::upper_bound(curveKnots.begin(), curveKnots.end(), t) - curveKnots.begin();
+	i = std::min(std::max(i, p + 1), npts) - 1;
+
+	std::array<RS_Vector, 4> d;
+	for (size_t j = 0; j <= p; ++j)
+		d[j] = curvePoints[i - p + j];
+
+	for (size_t r = 1; r <= p; ++r) {
+		for (size_t j = p; j >= r; --j) {
+			double const left = curveKnots[i - p + j];
+			double const right = curveKnots[i + 1 + j - r];
+			double const alpha = right > left ? (t - left) / (right - left) : 0.;
+			d[j] = d[j - 1] * (1. - alpha) + d[j] * alpha;
+		}
+	}
+	return d[p];
+}
 
-		/* generate the basis function for this value of t */
-		auto const nbasis = rbasis(k, t, npts, x, h);
-		/* generate a point on the curve, for x, y, z */
-		for (size_t i = 0; i < npts; i++)
-			vp += b[i] * nbasis[i];
+namespace {
+double squaredDistanceToChord(const RS_Vector& vp, const RS_Vector& p1, const RS_Vector& p2)
+{
+	RS_Vector const chord = p2 - p1;
+	double const length2 = chord.squared();
+	if (length2 < RS_TOLERANCE2)
+		return (vp - p1).squared();
+	double const u = std::min(std::max(RS_Vector::dotP(vp - p1, chord) / length2, 0.), 1.);
+	return (vp - p1 - chord * u).squared();
+}
+}
 
-		t += step;
-    }
+/**
+ * Appends vertices of the span from t1 to t2 to points, p1 is already there.
+ * Spans are split until their middle lies within the tolerance of the chord,
+ * at least once, so S-shaped pieces are not taken for straight ones.
+ */
+void RS_Spline::flatten(double t1, const RS_Vector& p1, double t2, const RS_Vector& p2,
+                        double tolerance2, int depth, std::vector<RS_Vector>& points) const{
+	double const tm = 0.5 * (t1 + t2);
+	RS_Vector const pm = evaluate(tm);
+	if (depth >= 16 || (depth > 0 && squaredDistanceToChord(pm, p1, p2) <= tolerance2)) {
+		points.push_back(p2);
+		return;
+	}
+	flatten(t1, p1, tm, pm, tolerance2, depth + 1, points);
+	flatten(tm, pm, t2, p2, tolerance2, depth + 1, points);
+}
+
+void RS_Spline::tessellate(double tolerance, const LC_Rect& window,
+                           std::vector<RS_Vector>& points) const{
+	points.clear();
+	if (curveKnots.empty())
+		return;
+
+	size_t const p = data.degree;
+	size_t const npts = curvePoints.size();
+	bool inWindow = false;
+	for (size_t i = p; i < npts; ++i) {
+		double const t1 = curveKnots[i];
+		double const t2 = curveKnots[i + 1];
+		if (t2 <= t1)
+			continue;
+
+		// the span lies in the hull of its control points
+		RS_Vector vMin = curvePoints[i - p];
+		RS_Vector vMax = vMin;
+		for (size_t j = i - p + 1; j <= i; ++j) {
+			vMin = RS_Vector::minimum(vMin, curvePoints[j]);
+			vMax = RS_Vector::maximum(vMax, curvePoints[j]);
+		}
+		if (!window.intersects(LC_Rect(vMin, vMax))) {
+			inWindow = false;
+			continue;
+		}
+		if (!inWindow) {
+			if (!points.empty())
+				points.push_back(RS_Vector(false));
+			points.push_back(evaluate(t1));
+			inWindow = true;
+		}
 
+		RS_Vector const p1 = points.back();
+		RS_Vector const p2 = evaluate(t2);
+		if (data.degree == 1)
+			points.push_back(p2);
+		else
+			flatten(t1, p1, t2, p2, tolerance * tolerance, 0, points);
+	}
 }
 
 
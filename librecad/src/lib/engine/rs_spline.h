@@ -30,6 +30,7 @@
 
 #include <vector>
 #include "rs_entitycontainer.h"
+#include "lc_rect.h"
 
 /**
  * Holds the data that defines a line.
@@ -152,16 +153,27 @@ public:
 
 private:
 		std::vector<double> knot(size_t num, size_t order) const;
-		void rbspline(size_t npts, size_t k, size_t p1,
-		              const std::vector<RS_Vector>& b,
-		              const std::vector<double>& h,
-		              std::vector<RS_Vector>& p) const;
-
 		std::vector<double> knotu(size_t num, size_t order) const;
-		void rbsplinu(size_t npts, size_t k, size_t p1,
-		              const std::vector<RS_Vector>& b,
-		              const std::vector<double>& h,
-		              std::vector<RS_Vector>& p) const;
+
+		/** point at parameter t, by de Boor's algorithm */
+		RS_Vector evaluate(double t) const;
+		/** vertices of the curve which deviate less than tolerance from it,
+		  * only of the spans whose control points reach into window. Runs of
+		  * vertices are separated by invalid vectors. */
+		void tessellate(double tolerance, const LC_Rect& window,
+		                std::vector<RS_Vector>& points) const;
+		void flatten(double t1, const RS_Vector& p1, double t2, const RS_Vector& p2,
+		             double tolerance2, int depth, std::vector<RS_Vector>& points) const;
+
+		/** control points, repeated at the end for closed splines, and
+		  * knots of the curve, cached by update() */
+		std::vector<RS_Vector> curvePoints;
+		std::vector<double> curveKnots;
+		/** vertices drawn at the tolerance 2^drawLevel inside drawWindow,
+		  * an empty drawWindow marks them outdated */
+		mutable std::vector<RS_Vector> drawPoints;
+		mutable int drawLevel = 0;
+		mutable LC_Rect drawWindow;
 
 protected:
 		RS_SplineData data;
@@ -26,9 +26,13 @@
 
 #include<iostream>
 #include<cmath>
+#include<utility>
+#include<vector>
 #include "rs_font.h"
 #include "rs_text.h"
 
+#include "lc_glyphrun.h"
+#include "rs_block.h"
 #include "rs_fontlist.h"
 #include "rs_insert.h"
 #include "rs_math.h"
@@ -275,11 +279,15 @@ void RS_Text::update() {
     RS_Vector letterSpace = RS_Vector(font->getLetterSpacing(), 0.0);
     RS_Vector space = RS_Vector(font->getWordSpacing(), 0.0);
 
-    // First every text line is created with
+    // First every text line is laid out with
     //   alignment: top left
     //   angle: 0
     //   height: 9.0
-    // Rotation, scaling and centering is done later
+    // from the borders of the glyphs. The letters are placed once
+    // their final position is known.
+    std::vector<std::pair<const RS_Font::Glyph*, RS_Vector>> letters;
+    RS_Vector textMin(RS_MAXDOUBLE, RS_MAXDOUBLE);
+    RS_Vector textMax(RS_MINDOUBLE, RS_MINDOUBLE);
 
     // For every letter:
     for (int i=0; i<(int)data.text.length(); ++i) {
@@ -289,45 +297,39 @@ void RS_Text::update() {
         } else {
             // One Letter:
             QString letterText = QString(data.text.at(i));
-            if (font->findLetter(letterText) == NULL) {
+            const RS_Font::Glyph* glyph = font->findGlyph(letterText);
+            if (glyph == NULL) {
                 RS_DEBUG->print("RS_Text::update: missing font for letter( %s ), replaced it with QChar(0xfffd)",qPrintable(letterText));
                 letterText = QChar(0xfffd);
+                glyph = font->findGlyph(letterText);
+                if (glyph == NULL) {
+                    continue;
+                }
             }
             RS_DEBUG->print("RS_Text::update: insert a "
                             "letter at pos: %f/%f", letterPos.x, letterPos.y);
 
-            RS_InsertData d(letterText,
-                            letterPos,
-                            RS_Vector(1.0, 1.0),
-                            0.0,
-                            1,1, RS_Vector(0.0,0.0),
-                            font->getLetterList(), RS2::NoUpdate);
-
-            RS_Insert* letter = new RS_Insert(this, d);
-            RS_Vector letterWidth;
-            letter->setPen(RS_Pen(RS2::FlagInvalid));
-            letter->setLayer(NULL);
-            letter->update();
-            letter->forcedCalculateBorders();
-
-            letterWidth = RS_Vector(letter->getMax().x-letterPos.x, 0.0);
+            RS_Vector const offset = letterPos - glyph->letter->getBasePoint();
+            RS_Vector const letterMin = glyph->letter->getMin() + offset;
+            RS_Vector const letterMax = glyph->letter->getMax() + offset;
+            textMin = RS_Vector::minimum(textMin, letterMin);
+            textMax = RS_Vector::maximum(textMax, letterMax);
+            letters.emplace_back(glyph, letterPos);
+
+            RS_Vector letterWidth = RS_Vector(letterMax.x-letterPos.x, 0.0);
             if (letterWidth.x < 0)
                 letterWidth.x = -letterSpace.x;
 
-//            oneLine->addEntity(letter);
-            addEntity(letter);
-
             // next letter position:
             letterPos += letterWidth;
             letterPos += letterSpace;
         }
     }
 
-    if( ! RS_EntityContainer::autoUpdateBorders) {
-        //only update borders when needed
-        forcedCalculateBorders();
+    if (letters.empty()) {
+        textMin = textMax = RS_Vector(0.0, 0.0);
     }
-    RS_Vector textSize = getSize();
+    RS_Vector textSize = textMax - textMin;
 
     RS_DEBUG->print("RS_Text::updateAddLine: width 2: %f", textSize.x);
 
@@ -360,7 +362,7 @@ void RS_Text::update() {
     // Horizontal Align:
     switch (data.halign) {
     case RS_TextData::HAMiddle:{
-        offset.move(RS_Vector(-textSize.x/2.0, -(vSize + textSize.y/2.0 + getMin().y) ));
+        offset.move(RS_Vector(-textSize.x/2.0, -(vSize + textSize.y/2.0 + textMin.y) ));
         break;}
     case RS_TextData::HACenter:
         RS_DEBUG->print("RS_Text::updateAddLine: move by: %f", -textSize.x/2.0);
@@ -377,30 +379,24 @@ void RS_Text::update() {
     if (data.halign!=RS_TextData::HAAligned && data.halign!=RS_TextData::HAFit){
         data.secondPoint = RS_Vector(offset.x, offset.y - vSize);
     }
-    RS_EntityContainer::move(offset);
 
 
     // Scale:
+    RS_Vector factor;
     if (data.halign==RS_TextData::HAAligned){
         double dist = data.insertionPoint.distanceTo(data.secondPoint)/textSize.x;
         data.height = vSize*dist;
-        RS_EntityContainer::scale(RS_Vector(0.0,0.0),
-                        RS_Vector(dist, dist));
+        factor = RS_Vector(dist, dist);
     } else if (data.halign==RS_TextData::HAFit){
         double dist = data.insertionPoint.distanceTo(data.secondPoint)/textSize.x;
-        RS_EntityContainer::scale(RS_Vector(0.0,0.0),
-                        RS_Vector(dist, data.height/9.0));
+        factor = RS_Vector(dist, data.height/9.0);
     } else {
-        RS_EntityContainer::scale(RS_Vector(0.0,0.0),
-                        RS_Vector(data.height*data.widthRel/9.0, data.height/9.0));
-        data.secondPoint.scale(RS_Vector(0.0,0.0),
-                               RS_Vector(data.height*data.widthRel/9.0, data.height/9.0));
+        factor = RS_Vector(data.height*data.widthRel/9.0, data.height/9.0);
+        data.secondPoint.scale(RS_Vector(0.0,0.0), factor);
     }
 
-    forcedCalculateBorders();
-
     // Update actual text size (before rotating, after scaling!):
-    usedTextWidth = getSize().x;
+    usedTextWidth = std::abs(textSize.x*factor.x);
     usedTextHeight = data.height;
 
     // Rotate:
@@ -411,10 +407,43 @@ void RS_Text::update() {
         data.secondPoint.rotate(RS_Vector(0.0,0.0), data.angle);
         data.secondPoint.move(data.insertionPoint);
     }
-    RS_EntityContainer::rotate(RS_Vector(0.0,0.0), data.angle);
 
-    // Move to insertion point:
-    RS_EntityContainer::move(data.insertionPoint);
+    // Place the letters at their final position, scale and angle. They
+    // are references to the glyphs of the font, unless inserts of the
+    // letters were requested by createLetters():
+    RS_Vector const angleVector(data.angle);
+    LC_GlyphRun* glyphs = letterInserts ? NULL : new LC_GlyphRun(this);
+    for (auto const& l: letters) {
+        RS_Vector pos = l.second + offset;
+        pos.scale(RS_Vector(0.0,0.0), factor);
+        pos.rotate(angleVector);
+        pos.move(data.insertionPoint);
+
+        if (glyphs) {
+            glyphs->append(l.first, pos, factor, RS_Math::correctAngle(data.angle));
+            continue;
+        }
+
+        RS_InsertData d(l.first->letter->getName(),
+                        pos,
+                        factor,
+                        RS_Math::correctAngle(data.angle),
+                        1,1, RS_Vector(0.0,0.0),
+                        font->getLetterList(), RS2::NoUpdate);
+
+        RS_Insert* letter = new RS_Insert(this, d);
+        letter->setPen(RS_Pen(RS2::FlagInvalid));
+        letter->setLayer(NULL);
+        letter->update();
+        addEntity(letter);
+    }
+    if (glyphs && glyphs->isEmpty()) {
+        delete glyphs;
+    } else if (glyphs) {
+        glyphs->setPen(RS_Pen(RS2::FlagInvalid));
+        glyphs->setLayer(NULL);
+        addEntity(glyphs);
+    }
 
     forcedCalculateBorders();
 
@@ -422,6 +451,17 @@ void RS_Text::update() {
 }
 
 
+/**
+ * Replaces the glyphs of this text by an insert for every letter. The
+ * inserts are only needed where the letters become entities of their
+ * own, e.g. when the text is exploded.
+ */
+void RS_Text::createLetters() {
+    letterInserts = true;
+    update();
+}
+
+
 RS_Vector RS_Text::getNearestEndpoint(const RS_Vector& coord, double* dist)const {
 	if (dist) {
         *dist = data.insertionPoint.distanceTo(coord);
@@ -154,6 +154,7 @@ public:
     }
 
     void update() override;
+    void createLetters();
 
     int getNumberOfLines();
 
@@ -258,6 +259,11 @@ protected:
      * @see update
      */
     double usedTextHeight;
+    /**
+     * Whether the letters are inserts instead of glyphs of the font.
+     * @see createLetters
+     */
+    bool letterInserts = false;
 };
 
 #endif
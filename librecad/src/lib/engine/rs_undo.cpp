@@ -26,6 +26,7 @@
 **********************************************************************/
 
 #include<iostream>
+#include <unordered_set>
 #include "qc_applicationwindow.h"
 #include "rs_undocycle.h"
 #include "rs_undo.h"
@@ -95,42 +96,9 @@ void RS_Undo::startUndoCycle()
         return;
     }
 
-    size_t  removePointer {static_cast<size_t>(undoPointer + 1)};
     // if there are undo cycles behind undoPointer
     // remove obsolete entities and undoCycles
-    if (undoList.size() > removePointer) {
-        // collect remaining undoables
-        std::list<RS_Undoable*> keep;
-        for (auto it = undoList.begin(); it != undoList.begin() + removePointer; ++it) {
-            for (auto u: (*it)->getUndoables()){
-                keep.push_back( u);
-            }
-        }
-        keep.unique();
-
-        // collect obsolete undoables
-        std::list<RS_Undoable*> obsolete;
-        for (auto it = undoList.begin() + removePointer; it != undoList.end(); ++it) {
-            for (auto u: (*it)->getUndoables()){
-                obsolete.push_back( u);
-            }
-        }
-        // unique() only works correct on sorted list!
-        obsolete.sort();
-        obsolete.unique();
-
-        // delete obsolete undoables which are not in keep list
-        for (auto it = obsolete.begin(); it != obsolete.end(); ++it) {
-            if (keep.end() == std::find( keep.begin(), keep.end(), *it)) {
-                removeUndoable( *it);
-            }
-        }
-
-        // clean up obsolete undoCycles
-        while (undoList.size() > removePointer) {
-            undoList.pop_back();
-        }
-    }
+    removeCycles(static_cast<size_t>(undoPointer + 1), undoList.size());
 
     // alloc new undoCycle
     currentCycle = std::make_shared<RS_UndoCycle>();
@@ -173,7 +141,13 @@ void RS_Undo::endUndoCycle()
 
     if (hasUndoable()) {
         // only keep the undoCycle, when it contains undoables
+        for (auto u: currentCycle->getUndoables()) {
+            currentCycle->memory += undoableMemory(u);
+        }
+        undoMemory += currentCycle->memory;
         addUndoCycle(currentCycle);
+        undoablesChanged(currentCycle->getUndoables());
+        trimUndoList();
     }
 
     setGUIButtons();
@@ -194,6 +168,7 @@ bool RS_Undo::undo() {
 
 	setGUIButtons();
 	uc->changeUndoState();
+	undoablesChanged(uc->getUndoables());
 	return true;
 }
 
@@ -210,12 +185,93 @@ bool RS_Undo::redo() {
 
 		setGUIButtons();
 		uc->changeUndoState();
+		undoablesChanged(uc->getUndoables());
 		return true;
 	}
     return false;
 }
 
 
+void RS_Undo::setUndoLimits(size_t maxCycles, size_t maxBytes)
+{
+    maxUndoCycles = maxCycles;
+    maxUndoMemory = maxBytes;
+}
+
+
+/**
+ * Drops the oldest undo cycles while the list exceeds the cycle or memory
+ * limit. The last cycle which can be undone is always kept, cycles which
+ * can be redone are never dropped. Undoables which are not referred to by
+ * a remaining cycle are removed.
+ */
+void RS_Undo::trimUndoList()
+{
+    size_t const undoable = static_cast<size_t>(undoPointer + 1);
+    size_t memory = undoMemory;
+    size_t drop = 0;
+    while (drop + 1 < undoable
+           && ((maxUndoCycles > 0 && undoable - drop > maxUndoCycles)
+               || (maxUndoMemory > 0 && memory > maxUndoMemory))) {
+        memory -= undoList[drop]->memory;
+        ++drop;
+    }
+    if (drop == 0) {
+        return;
+    }
+
+    removeCycles(0, drop);
+    undoPointer -= static_cast<int>(drop);
+}
+
+
+/**
+ * Removes the cycles [first, last) from the undo list. Undoables which
+ * are not referred to by any other cycle are collected in a hashed set
+ * and removed at once.
+ */
+void RS_Undo::removeCycles(size_t first, size_t last)
+{
+    if (first >= last) {
+        return;
+    }
+
+    std::unordered_set<RS_Undoable*> keep;
+    for (size_t i = 0; i < undoList.size(); ++i) {
+        if (i < first || i >= last) {
+            keep.insert(undoList[i]->getUndoables().begin(),
+                        undoList[i]->getUndoables().end());
+        }
+    }
+
+    std::unordered_set<RS_Undoable*> seen;
+    std::vector<RS_Undoable*> obsolete;
+    for (size_t i = first; i < last; ++i) {
+        for (auto u: undoList[i]->getUndoables()) {
+            if (!keep.count(u) && seen.insert(u).second) {
+                obsolete.push_back(u);
+            }
+        }
+        undoMemory -= undoList[i]->memory;
+    }
+    removeUndoables(obsolete);
+
+    undoList.erase(undoList.begin() + first, undoList.begin() + last);
+}
+
+
+/**
+ * Removes undoables which are no longer in the undo buffer. The default
+ * implementation calls removeUndoable() for each of them.
+ */
+void RS_Undo::removeUndoables(std::vector<RS_Undoable*> const& undoables)
+{
+    for (auto u: undoables) {
+        removeUndoable(u);
+    }
+}
+
+
 /**
  * @return The undo item that is next if we're about to undo
  * or nullptr.
@@ -408,6 +464,16 @@ bool RS_Undo::test() {
     assert(undo.countUndoCycles()==246);
     assert(undo.countRedoCycles()==0);
 
+    std::cout << "  Limiting to 100 cycles..";
+    undo.setUndoLimits(100, 0);
+    undo.startUndoCycle();
+    undo.addUndoable(new RS_Undoable());
+    undo.endUndoCycle();
+    std::cout << "OK\n";
+
+    assert(undo.countUndoCycles()==100);
+    assert(undo.countRedoCycles()==0);
+
     return true;
 
 }
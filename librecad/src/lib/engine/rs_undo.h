@@ -29,7 +29,9 @@
 #ifndef RS_UNDO_H
 #define RS_UNDO_H
 
+#include <cstddef>
 #include <memory>
+#include <set>
 #include <vector>
 
 class RS_UndoCycle;
@@ -66,6 +68,20 @@ public:
      * for Undoables that are no longer in the undo buffer.
      */
     virtual void removeUndoable(RS_Undoable* u) = 0;
+    /**
+     * Removes several Undoables at once, see removeUndoable().
+     */
+    virtual void removeUndoables(std::vector<RS_Undoable*> const& undoables);
+
+    /**
+     * Limits the undo history. Once a finished cycle exceeds a limit, the
+     * oldest cycles are dropped and the undoables only they refer to are
+     * removed. 0 means no limit.
+     *
+     * @param maxCycles Maximum number of cycles kept.
+     * @param maxBytes Maximum estimated memory held by the kept cycles.
+     */
+    void setUndoLimits(size_t maxCycles, size_t maxBytes);
 
     /**
 	  *\brief enable/disable redo/undo buttons in main application window
@@ -77,9 +93,27 @@ public:
 
     static bool test();
 
+protected:
+    /**
+     * Called after a cycle was added, undone or redone with the undoables
+     * whose undo state may have changed.
+     */
+    virtual void undoablesChanged(std::set<RS_Undoable*> const& /*undoables*/) {}
+    /**
+     * @return Estimated memory held by an undoable, used for the memory
+     * limit of the undo history.
+     */
+    virtual size_t undoableMemory(RS_Undoable* /*u*/) const {
+        return 0;
+    }
+
 private:
 
 	void addUndoCycle(std::shared_ptr<RS_UndoCycle> const& i);
+	//! drop the oldest cycles until the undo list is within its limits
+	void trimUndoList();
+	//! drop the cycles [first, last) and the undoables only they refer to
+	void removeCycles(size_t first, size_t last);
     //! List of undo list items. every item is something that can be undone.
 	std::vector<std::shared_ptr<RS_UndoCycle>> undoList;
 
@@ -97,6 +131,10 @@ private:
     std::shared_ptr<RS_UndoCycle> currentCycle {nullptr};
 
     int refCount {0}; ///< reference counter for nested start/end calls
+
+    size_t maxUndoCycles {0}; ///< maximum number of cycles, 0 for no limit
+    size_t maxUndoMemory {0}; ///< maximum memory of all cycles, 0 for no limit
+    size_t undoMemory {0}; ///< estimated memory of all cycles in the list
 };
 
 
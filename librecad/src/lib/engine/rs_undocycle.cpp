@@ -26,8 +26,20 @@
 **********************************************************************/
 
 
+#include <algorithm>
 #include <ostream>
+#include <vector>
 #include"rs_undocycle.h"
+#include "lc_transformundoable.h"
+
+RS_UndoCycle::~RS_UndoCycle()
+{
+    for (RS_Undoable* u: undoables) {
+        if (u->undoRtti()==RS2::UndoableTransform) {
+            delete u;
+        }
+    }
+}
 
 /**
  * Adds an Undoable to this Undo Cycle. Every Cycle can contain one or
@@ -60,8 +72,30 @@ size_t RS_UndoCycle::size()
 
 void RS_UndoCycle::changeUndoState()
 {
-	for (RS_Undoable* u: undoables)
-		u->changeUndoState();
+	std::vector<LC_TransformUndoable*> transforms;
+	for (RS_Undoable* u: undoables) {
+		if (u->undoRtti()==RS2::UndoableTransform) {
+			transforms.push_back(static_cast<LC_TransformUndoable*>(u));
+		} else {
+			u->changeUndoState();
+		}
+	}
+	if (transforms.empty()) {
+		return;
+	}
+
+	// transformations of the same entities don't commute: redo them in the
+	// order they were applied and undo them in reverse order
+	std::sort(transforms.begin(), transforms.end(),
+			  [](LC_TransformUndoable const* a, LC_TransformUndoable const* b) {
+		return a->getSequence() < b->getSequence();
+	});
+	if (!transforms.front()->isUndone()) {
+		std::reverse(transforms.begin(), transforms.end());
+	}
+	for (LC_TransformUndoable* t: transforms) {
+		t->changeUndoState();
+	}
 }
 
 std::set<RS_Undoable*> const& RS_UndoCycle::getUndoables() const
@@ -54,6 +54,10 @@ public:
      * @param type Type of undo item.
      */
 	RS_UndoCycle(/*RS2::UndoType type*/)=default;
+	/**
+	 * Deletes the transformation undoables, which belong to their cycle.
+	 */
+	~RS_UndoCycle();
 
     /**
      * Adds an Undoable to this Undo Cycle. Every Cycle can contain one or
@@ -86,6 +90,8 @@ private:
     //RS2::UndoType type;
     //! List of entity id's that were affected by this action
     std::set<RS_Undoable*> undoables;
+    //! estimated memory held by the undoables, see RS_Undo::undoableMemory()
+    size_t memory = 0;
 };
 
 #endif
@@ -2225,6 +2225,7 @@ void RS_FilterDXF::writeHatch(DL_WriterA& dw, RS_Hatch* h,
 
     // split hatch into atomic entities:
     if (dxf.getVersion()==VER_R12) {
+        h->updatePattern();
         writeAtomicEntities(dw, h, attrib, RS2::ResolveAll);
         return;
     }
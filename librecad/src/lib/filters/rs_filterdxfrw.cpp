@@ -150,6 +150,8 @@ bool RS_FilterDXFRW::fileImport(RS_Graphic& g, const QString& file, RS2::FormatT
     graphic = &g;
     currentContainer = graphic;
 	dummyContainer = new RS_EntityContainer(nullptr, true);
+    layerCache.clear();
+    penCache.clear();
 
     this->file = file;
     // add some variables that need to be there for DXF drawings:
@@ -1534,6 +1536,10 @@ void RS_FilterDXFRW::writeBlocks() {
         block.flags = 1;//flag for unnamed block
         dxfW->writeBlock(&block);
         RS_EntityContainer *ct = (RS_EntityContainer *)it.key();
+        if (ct->rtti()==RS2::EntityHatch) {
+            // the block holds the pattern of the whole hatch
+            static_cast<RS_Hatch*>(ct)->updatePattern();
+        }
         for (RS_Entity* e=ct->firstEntity(RS2::ResolveNone);
              e; e=ct->nextEntity(RS2::ResolveNone)) {
             if ( !(e->getFlag(RS2::FlagUndone)) ) {
@@ -3001,34 +3007,47 @@ void RS_FilterDXFRW::setEntityAttributes(RS_Entity* entity,
                                        const DRW_Entity* attrib) {
     RS_DEBUG->print("RS_FilterDXF::setEntityAttributes");
 
-    RS_Pen pen;
-    pen.setColor(Qt::black);
-    pen.setLineType(RS2::SolidLine);
-    QString layName = toNativeString(QString::fromUtf8(attrib->layer.c_str()));
-
-    // Layer: add layer in case it doesn't exist:
-	if (!graphic->findLayer(layName)) {
-        DRW_Layer lay;
-        lay.name = attrib->layer;
-        addLayer(lay);
+    // Most entities share a few combinations of attributes, layer and
+    // pen are resolved once for each of them.
+    auto layerIt = layerCache.find(attrib->layer);
+    if (layerIt == layerCache.end()) {
+        QString layName = toNativeString(QString::fromUtf8(attrib->layer.c_str()));
+
+        // Layer: add layer in case it doesn't exist:
+        if (!graphic->findLayer(layName)) {
+            DRW_Layer lay;
+            lay.name = attrib->layer;
+            addLayer(lay);
+        }
+        layerIt = layerCache.emplace(attrib->layer, graphic->findLayer(layName)).first;
     }
-    entity->setLayer(layName);
+    entity->setLayer(entity->getGraphic() ? layerIt->second : nullptr);
 
-    // Color:
-    if (attrib->color24 >= 0)
-        pen.setColor(RS_Color(attrib->color24 >> 16,
-                              attrib->color24 >> 8 & 0xFF,
-                              attrib->color24 & 0xFF));
-    else
-    pen.setColor(numberToColor(attrib->color));
+    auto const penKey = std::make_tuple(attrib->color24, attrib->color,
+                                        attrib->lineType, static_cast<int>(attrib->lWeight));
+    auto penIt = penCache.find(penKey);
+    if (penIt == penCache.end()) {
+        RS_Pen pen;
+        pen.setColor(Qt::black);
+        pen.setLineType(RS2::SolidLine);
 
-    // Linetype:
-    pen.setLineType(nameToLineType( QString::fromUtf8(attrib->lineType.c_str()) ));
+        // Color:
+        if (attrib->color24 >= 0)
+            pen.setColor(RS_Color(attrib->color24 >> 16,
+                                  attrib->color24 >> 8 & 0xFF,
+                                  attrib->color24 & 0xFF));
+        else
+        pen.setColor(numberToColor(attrib->color));
 
-    // Width:
-    pen.setWidth(numberToWidth(attrib->lWeight));
+        // Linetype:
+        pen.setLineType(nameToLineType( QString::fromUtf8(attrib->lineType.c_str()) ));
 
-    entity->setPen(pen);
+        // Width:
+        pen.setWidth(numberToWidth(attrib->lWeight));
+
+        penIt = penCache.emplace(penKey, pen).first;
+    }
+    entity->setPen(penIt->second);
     RS_DEBUG->print("RS_FilterDXF::setEntityAttributes: OK");
 }
 
@@ -3713,18 +3732,32 @@ QString RS_FilterDXFRW::toNativeString(const QString& data) {
     }
     res.append(data.mid(j));
 
-    // Line feed:
-    res = res.replace(QRegExp("\\\\P"), "\n");
-    // Space:
-    res = res.replace(QRegExp("\\\\~"), " ");
+    // the patterns are compiled once, most strings contain none of them
+    static const QRegExp lineFeed("\\\\P");
+    static const QRegExp space("\\\\~");
+    static const QRegExp tab("\\^I");
+    static const QRegExp diameter("%%[cC]");
+    static const QRegExp degree("%%[dD]");
+    static const QRegExp plusMinus("%%[pP]");
+
+    if (res.contains('\\')) {
+        // Line feed:
+        res = res.replace(lineFeed, "\n");
+        // Space:
+        res = res.replace(space, " ");
+    }
     // Tab:
-    res = res.replace(QRegExp("\\^I"), "    ");//RLZ: change 4 spaces for \t when mtext have support for tab
-    // diameter:
-    res = res.replace(QRegExp("%%[cC]"), QChar(0x2300));//RLZ: Empty_set is 0x2205, diameter is 0x2300 need to add in all fonts
-    // degree:
-    res = res.replace(QRegExp("%%[dD]"), QChar(0x00B0));
-    // plus/minus
-    res = res.replace(QRegExp("%%[pP]"), QChar(0x00B1));
+    if (res.contains('^')) {
+        res = res.replace(tab, "    ");//RLZ: change 4 spaces for \t when mtext have support for tab
+    }
+    if (res.contains("%%")) {
+        // diameter:
+        res = res.replace(diameter, QChar(0x2300));//RLZ: Empty_set is 0x2205, diameter is 0x2300 need to add in all fonts
+        // degree:
+        res = res.replace(degree, QChar(0x00B0));
+        // plus/minus
+        res = res.replace(plusMinus, QChar(0x00B1));
+    }
 
     return res;
 }
@@ -27,6 +27,10 @@
 #ifndef RS_FILTERDXFRW_H
 #define RS_FILTERDXFRW_H
 
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
 #include "rs_filterinterface.h"
 
 #include "rs_color.h"
@@ -235,6 +239,10 @@ private:
     QHash<int, RS_EntityContainer*> blockHash;
     /** Pointer to entity container to store possible orphan entities like paper space */
     RS_EntityContainer* dummyContainer;
+    /** Layers of imported entities by the layer name in the file */
+    std::unordered_map<std::string, RS_Layer*> layerCache;
+    /** Pens of imported entities by color, true color, line type and width in the file */
+    std::map<std::tuple<int, int, std::string, int>, RS_Pen> penCache;
 };
 
 #endif
@@ -2229,6 +2229,7 @@ void RS_FilterJWW::writeHatch(DL_WriterA& dw, RS_Hatch* h,
 
         // split hatch into atomic entities:
         if (jww.getVersion()==VER_R12) {
+                h->updatePattern();
                 writeAtomicEntities(dw, h, attrib, RS2::ResolveAll);
                 return;
         }
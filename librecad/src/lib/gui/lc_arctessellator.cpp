@@ -0,0 +1,103 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2018 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <QPolygon>
+#include "lc_arctessellator.h"
+#include "rs_math.h"
+#include "rs_vector.h"
+
+namespace {
+//! chords per arc for radii far beyond the screen
+constexpr int maxSegments = 1 << 14;
+
+/**
+ * Fills pa with n + 1 vertices map(cos(a), sin(a)) for a going from a1 to
+ * a1 + sweep in n steps. The last vertex is placed at the end angle exactly,
+ * so rounding errors of the rotation do not show at the ends of the arc.
+ */
+template<class Map>
+void rotate(QPolygon& pa, double a1, double sweep, int n, Map map)
+{
+    pa.resize(n + 1);
+    QPoint* vertices = pa.data();
+
+    double const step = sweep / n;
+    double const cosStep = std::cos(step);
+    double const sinStep = std::sin(step);
+    double c = std::cos(a1);
+    double s = std::sin(a1);
+    for (int i = 0; i < n; ++i) {
+        vertices[i] = map(c, s);
+        double const next = c * cosStep - s * sinStep;
+        s = s * cosStep + c * sinStep;
+        c = next;
+    }
+    vertices[n] = map(std::cos(a1 + sweep), std::sin(a1 + sweep));
+}
+}
+
+LC_ArcTessellator::LC_ArcTessellator(double tolerance):
+    tolerance(tolerance)
+{
+}
+
+int LC_ArcTessellator::segments(double radius, double sweep) const
+{
+    // a chord over the angle step lies radius*(1 - cos(step/2)) inside the arc
+    double step = M_PI / 4.;
+    if (radius > tolerance) {
+        step = std::min(step, 2. * std::acos(1. - tolerance / radius));
+    }
+    double const n = std::ceil(std::abs(sweep) / step);
+    return static_cast<int>(std::min(std::max(n, 1.), double(maxSegments)));
+}
+
+void LC_ArcTessellator::arc(QPolygon& pa, const RS_Vector& cp, double radius,
+                            double a1, double sweep) const
+{
+    rotate(pa, a1, sweep, segments(radius, sweep), [&](double c, double s) {
+        return QPoint(RS_Math::round(cp.x + c * radius),
+                      RS_Math::round(cp.y - s * radius));
+    });
+}
+
+void LC_ArcTessellator::ellipse(QPolygon& pa, const RS_Vector& cp,
+                                double radius1, double radius2, double angle,
+                                double a1, double sweep) const
+{
+    double const cosAngle = std::cos(angle);
+    double const sinAngle = std::sin(angle);
+    // the points of an ellipse move at most as fast along their parameter as
+    // those of the circle over its major axis, so its steps are small enough
+    int const n = segments(std::max(std::abs(radius1), std::abs(radius2)), sweep);
+    rotate(pa, a1, sweep, n, [&](double c, double s) {
+        double const x = radius1 * c;
+        double const y = radius2 * s;
+        return QPoint(RS_Math::round(cp.x + x * cosAngle - y * sinAngle),
+                      RS_Math::round(cp.y - x * sinAngle - y * cosAngle));
+    });
+}
@@ -0,0 +1,75 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2018 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+#ifndef LC_ARCTESSELLATOR_H
+#define LC_ARCTESSELLATOR_H
+
+class QPolygon;
+class RS_Vector;
+
+/** \brief Polygons of circular and elliptic arcs in screen coordinates
+ *
+ * The number of vertices follows from the radius and the largest distance
+ * allowed between a chord and the arc, so the polygon is sized once. The
+ * vertices come from rotating the previous one by a fixed angle, which takes
+ * a single sine and cosine per arc instead of one per vertex.
+ *
+ * The polygon passed in is resized, not cleared, so a polygon kept by the
+ * caller keeps its capacity from one arc to the next.
+ */
+class LC_ArcTessellator
+{
+public:
+    /**
+     * @param tolerance largest distance between a chord and the arc in pixels
+     */
+    explicit LC_ArcTessellator(double tolerance);
+
+    //! number of chords for an arc of the given radius and sweep angle
+    int segments(double radius, double sweep) const;
+
+    /**
+     * @brief arc vertices of a circular arc
+     * @param cp center in screen coordinates, the y axis points down
+     * @param a1 start angle, counterclockwise on screen
+     * @param sweep signed sweep angle, negative for clockwise arcs
+     */
+    void arc(QPolygon& pa, const RS_Vector& cp, double radius,
+             double a1, double sweep) const;
+
+    /**
+     * @brief ellipse vertices of an elliptic arc
+     * @param angle rotation of the major axis
+     * @param a1,sweep start and signed sweep of the ellipse parameter
+     */
+    void ellipse(QPolygon& pa, const RS_Vector& cp,
+                 double radius1, double radius2, double angle,
+                 double a1, double sweep) const;
+
+private:
+    double tolerance;
+};
+
+#endif // LC_ARCTESSELLATOR_H
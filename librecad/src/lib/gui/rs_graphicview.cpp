@@ -50,6 +50,7 @@
 #include "rs_math.h"
 #include "rs_debug.h"
 #include "rs_color.h"
+#include "lc_spatialindex.h"
 
 #ifdef EMU_C99
 #include "emu_c99.h"
@@ -770,7 +771,8 @@ void RS_GraphicView::zoomPan(int dx, int dy) {
 	//adjustZoomControls();
 	//    updateGrid();
 
-	redraw();
+	// the drawing itself is unchanged, views move their cached drawing
+	redraw((RS2::RedrawMethod) (RS2::RedrawGrid | RS2::RedrawOverlay));
 }
 
 
@@ -797,7 +799,7 @@ void RS_GraphicView::zoomScroll(RS2::Direction direction) {
 	adjustZoomControls();
 	//    updateGrid();
 
-	redraw();
+	redraw((RS2::RedrawMethod) (RS2::RedrawGrid | RS2::RedrawOverlay));
 }
 
 
@@ -913,30 +915,6 @@ void RS_GraphicView::drawLayer1(RS_Painter *painter) {
 }
 
 
-/*	*
- *	Function name:
- *	Description: 		Do the drawing, step 2/3.
- *	Author(s):			..., Claude Sylvain
- *	Created:				?
- *	Last modified:		23 July 2011
- *
- *	Parameters:			RS_Painter *painter:
- *								...
- *
- *	Returns:				void
- *	*/
-
-void RS_GraphicView::drawLayer2(RS_Painter *painter)
-{
-	drawEntity(painter, container);	//	Draw all entities.
-
-	//	If not in print preview, draw the absolute zero reference.
-	//	----------------------------------------------------------
-	if (!isPrintPreview())
-		drawAbsoluteZero(painter);
-}
-
-
 void RS_GraphicView::drawLayer3(RS_Painter *painter) {
 	// drawing zero points:
 	if (!isPrintPreview()) {
@@ -1056,32 +1034,33 @@ void RS_GraphicView::setPenForEntity(RS_Painter *painter,RS_Entity *e)
 }
 
 
+void RS_GraphicView::redrawWindow(const RS_Vector& /*v1*/, const RS_Vector& /*v2*/) {
+	redraw(RS2::RedrawDrawing);
+}
+
+
 /**
- * Draws an entity. Might be recursively called e.g. for polylines.
- * If the class wide painter is nullptr a new painter will be created
- * and destroyed afterwards.
+ * Entities are not drawn directly, the part of the view covered by
+ * the entity is redrawn instead.
  *
- * @param patternOffset Offset of line pattern (used for connected
- *        lines e.g. in splines).
- * @param db Double buffering on (recommended) / off
- */
-void RS_GraphicView::drawEntity(RS_Entity* /*e*/, double& /*patternOffset*/) {
-	RS_DEBUG->print("RS_GraphicView::drawEntity(RS_Entity*,patternOffset) not supported anymore");
-	// RVT_PORT this needs to be optimized
-	// One way to do is to send a RS2::RedrawSelected, then the draw routine will only draw all selected entities
-	// Dis-advantage is that we still need to iterate over all entities, but
-	// this might be very fast
-	// For now we just redraw the drawing until we are going to optimize drawing
-	redraw(RS2::RedrawDrawing);
+ * @param patternOffset unused
+ */
+void RS_GraphicView::drawEntity(RS_Entity* e, double& /*patternOffset*/) {
+	drawEntity(e);
 }
-void RS_GraphicView::drawEntity(RS_Entity* /*e*/ /*patternOffset*/) {
-	RS_DEBUG->print("RS_GraphicView::drawEntity(RS_Entity*,patternOffset) not supported anymore");
-	// RVT_PORT this needs to be optimized
-	// One way to do is to send a RS2::RedrawSelected, then the draw routine will only draw all selected entities
-	// Dis-advantage is that we still need to iterate over all entities, but
-	// this might be very fast
-	// For now we just redraw the drawing until we are going to optimize drawing
-	redraw(RS2::RedrawDrawing);
+void RS_GraphicView::drawEntity(RS_Entity* e) {
+	// children of blocks show up wherever the block is inserted
+	RS_Entity const* top = e;
+	while (top && top != container) {
+		top = top->getParent();
+	}
+
+	LC_SpatialIndex::Box box;
+	if (top && LC_SpatialIndex::entityBox(e, box)) {
+		redrawWindow({box.minX, box.minY}, {box.maxX, box.maxY});
+	} else {
+		redraw(RS2::RedrawDrawing);
+	}
 }
 void RS_GraphicView::drawEntity(RS_Painter *painter, RS_Entity* e) {
 	double offset(0.);
@@ -1197,17 +1176,11 @@ void RS_GraphicView::drawEntityPlain(RS_Painter *painter, RS_Entity* e) {
 	e->draw(painter, this, patternOffset);
 }
 /**
- * Deletes an entity with the background color.
- * Might be recursively called e.g. for polylines.
+ * Removes an entity from the view.
  */
 void RS_GraphicView::deleteEntity(RS_Entity* e) {
-
-	// RVT_PORT When we delete a single entity, we can do this but we need to remove this then also from containerEntities
-	RS_DEBUG->print("RS_GraphicView::deleteEntity will for now redraw the whole screen instead of just deleting the entity");
-	setDeleteMode(true);
+	// the region is redrawn once the entity is gone
 	drawEntity(e);
-	setDeleteMode(false);
-	redraw(RS2::RedrawDrawing);
 }
 
 
@@ -1683,6 +1656,12 @@ RS_Vector RS_GraphicView::toGraph(int x, int y) const{
 }
 
 
+
+LC_Rect RS_GraphicView::getVisibleArea() const{
+	return LC_Rect(toGraph(0, 0), toGraph(getWidth(), getHeight()));
+}
+
+
 /**
  * Translates a screen coordinate in X to a real coordinate X.
  */
@@ -108,9 +108,22 @@ public:
 	/** This virtual method must be overwritten to return
 	  the height of the widget the graphic is shown in */
 	virtual int getHeight() const= 0;
+	/**
+	 * @return The part of the drawing shown in the view, and the part
+	 * being rendered if it reaches past the view. While the view renders
+	 * a part of itself, e.g. a row of tiles, getWidth() and getHeight()
+	 * only cover that part.
+	 */
+	virtual LC_Rect getVisibleArea() const;
 	/** This virtual method must be overwritten to redraw
 	  the widget. */
 	virtual void redraw(RS2::RedrawMethod method=RS2::RedrawAll) = 0;
+	/**
+	 * Redraws the part of the drawing inside the given window (graph
+	 * coordinates), e.g. after an entity inside it changed. Views which
+	 * don't cache the drawing redraw all of it.
+	 */
+	virtual void redrawWindow(const RS_Vector& v1, const RS_Vector& v2);
 	/** This virtual method must be overwritten and is then
 	  called whenever the view changed */
     virtual void adjustOffsetControls() = 0;
@@ -263,7 +276,6 @@ public:
 
 	virtual void drawWindow_DEPRECATED(RS_Vector v1, RS_Vector v2);
 	virtual void drawLayer1(RS_Painter *painter);
-	virtual void drawLayer2(RS_Painter *painter);
 	virtual void drawLayer3(RS_Painter *painter);
 	virtual void deleteEntity(RS_Entity* e);
 	virtual void drawEntity(RS_Painter *painter, RS_Entity* e, double& patternOffset);
@@ -183,71 +183,11 @@ void RS_PainterQt::drawArc(const RS_Vector& cp, double radius,
     if(radius<=0.5) {
         drawGridPoint(cp);
     } else {
-        int   cix;            // Next point on circle
-        int   ciy;            //
-        double aStep;         // Angle Step (rad)
-        double a;             // Current Angle (rad)
-        double linStep;       // linear step (pixels)
-
-        if (drawingMode==RS2::ModePreview) {
-            linStep = 20.0;
-        } else {
-            linStep = 6.0;
-        }
-
-        if (fabs(linStep/radius)<=1.0) {
-            aStep=asin(linStep/radius);
-        } else {
-            aStep=1.0;
-        }
-
-        if (aStep<0.05) {
-            aStep = 0.05;
-        }
-
-        if(!reversed) {
-            // Arc Counterclockwise:
-            if(a1>a2-1.0e-10) {
-                a2+=2*M_PI;
-            }
-            //moveTo(toScreenX(p1.x), toScreenY(p1.y));
-            QPolygon pa;
-            int i=0;
-            pa.resize(i+1);
-            pa.setPoint(i++, toScreenX(p1.x), toScreenY(p1.y));
-            for(a=a1+aStep; a<=a2; a+=aStep) {
-                cix = toScreenX(cp.x+cos(a)*radius);
-                ciy = toScreenY(cp.y-sin(a)*radius);
-                //lineTo(cix, ciy);
-                pa.resize(i+1);
-                pa.setPoint(i++, cix, ciy);
-            }
-            //lineTo(toScreenX(p2.x), toScreenY(p2.y));
-            pa.resize(i+1);
-            pa.setPoint(i++, toScreenX(p2.x), toScreenY(p2.y));
-            drawPolyline(pa);
-        } else {
-            // Arc Clockwise:
-            if(a1<a2+1.0e-10) {
-                a2-=2*M_PI;
-            }
-            QPolygon pa;
-            int i=0;
-            pa.resize(i+1);
-            pa.setPoint(i++, toScreenX(p1.x), toScreenY(p1.y));
-            //moveTo(toScreenX(p1.x), toScreenY(p1.y));
-            for(a=a1-aStep; a>=a2; a-=aStep) {
-                cix = toScreenX(cp.x+cos(a)*radius);
-                ciy = toScreenY(cp.y-sin(a)*radius);
-                //lineTo(cix, ciy);
-                pa.resize(i+1);
-                pa.setPoint(i++, cix, ciy);
-            }
-            //lineTo(toScreenX(p2.x), toScreenY(p2.y));
-            pa.resize(i+1);
-            pa.setPoint(i++, toScreenX(p2.x), toScreenY(p2.y));
-            drawPolyline(pa);
-        }
+        createArc(arcPolygon, cp, radius, a1, a2, reversed);
+        // the arc starts and ends exactly at the given points
+        arcPolygon.first() = QPoint(toScreenX(p1.x), toScreenY(p1.y));
+        arcPolygon.last() = QPoint(toScreenX(p2.x), toScreenY(p2.y));
+        drawPolyline(arcPolygon);
     }
 }
 
@@ -272,9 +212,8 @@ void RS_PainterQt::drawArc(const RS_Vector& cp, double radius,
 #ifdef __APPL1E__
                 drawArcMac(cp, radius, a1, a2, reversed);
 #else
-        QPolygon pa;
-        createArc(pa, cp, radius, a1, a2, reversed);
-        drawPolyline(pa);
+        createArc(arcPolygon, cp, radius, a1, a2, reversed);
+        drawPolyline(arcPolygon);
 #endif
     }
 }
@@ -392,9 +331,8 @@ void RS_PainterQt::drawEllipse(const RS_Vector& cp,
                                double angle,
                                double a1, double a2,
                                bool reversed) {
-    QPolygon pa;
-    createEllipse(pa, cp, radius1, radius2, angle, a1, a2, reversed);
-    drawPolyline(pa);
+    createEllipse(arcPolygon, cp, radius1, radius2, angle, a1, a2, reversed);
+    drawPolyline(arcPolygon);
 }
 
 
@@ -527,8 +465,16 @@ void RS_PainterQt::setPen(const RS_Pen& pen) {
     default:
         break;
     }
-    QPen p(lpen.getColor(), RS_Math::round(lpen.getScreenWidth()),
-		   rsToQtLineType(lpen.getLineType()));
+    int const width = RS_Math::round(lpen.getScreenWidth());
+    Qt::PenStyle const style = rsToQtLineType(lpen.getLineType());
+    // consecutive entities mostly share a pen, a new QPen costs an allocation
+    QPen const& current = QPainter::pen();
+    if (current.color() == lpen.getColor() && current.width() == width
+            && current.style() == style && current.joinStyle() == Qt::RoundJoin
+            && current.capStyle() == Qt::RoundCap) {
+        return;
+    }
+    QPen p(lpen.getColor(), width, style);
     p.setJoinStyle(Qt::RoundJoin);
     p.setCapStyle(Qt::RoundCap);
     QPainter::setPen(p);
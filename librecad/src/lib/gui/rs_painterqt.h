@@ -30,6 +30,7 @@
 
 #include <QPainter>
 #include <QPainterPath>
+#include <QPolygon>
 
 #include "rs_painter.h"
 #include "rs_pen.h"
@@ -112,6 +113,8 @@ protected:
     RS_Pen lpen;
     long rememberX; // Used for the moment because QPainter doesn't support moveTo anymore, thus we need to remember ourselves the moveTo positions
     long rememberY;
+    //! vertices of the last arc or ellipse drawn, reused to keep its capacity
+    QPolygon arcPolygon;
 };
 
 #endif
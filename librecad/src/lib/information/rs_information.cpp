@@ -36,12 +36,82 @@
 #include "rs_ellipse.h"
 #include "rs_line.h"
 #include "rs_polyline.h"
+#include "lc_glyphrun.h"
 #include "lc_quadratic.h"
 #include "lc_splinepoints.h"
 #include "rs_math.h"
 #include "lc_rect.h"
 #include "rs_debug.h"
 
+namespace {
+//! closed form intersection of two entities of known types
+using IntersectionKernel = RS_VectorSolutions (*)(RS_Entity const*, RS_Entity const*);
+
+struct KernelEntry {
+	RS2::EntityType type1;
+	RS2::EntityType type2;
+	IntersectionKernel kernel;
+};
+
+RS_VectorSolutions lineLine(RS_Entity const* e1, RS_Entity const* e2)
+{
+	return RS_Information::getIntersectionLineLine(static_cast<RS_Line const*>(e1),
+												   static_cast<RS_Line const*>(e2));
+}
+
+RS_VectorSolutions lineCircle(RS_Entity const* e1, RS_Entity const* e2)
+{
+	return RS_Information::getIntersectionLineCircle(static_cast<RS_Line const*>(e1), e2);
+}
+
+RS_VectorSolutions lineEllipse(RS_Entity const* e1, RS_Entity const* e2)
+{
+	return RS_Information::getIntersectionEllipseLine(static_cast<RS_Line const*>(e1),
+													  static_cast<RS_Ellipse const*>(e2));
+}
+
+// issue #484, the quadratic solver is not robust enough for arc-arc
+RS_VectorSolutions circleCircle(RS_Entity const* e1, RS_Entity const* e2)
+{
+	return RS_Information::getIntersectionArcArc(e1, e2);
+}
+
+/**
+ * Type pairs solved in closed form, without building the quadratic forms
+ * of both entities. Other pairs go through LC_Quadratic::getIntersection().
+ */
+KernelEntry const intersectionKernels[] = {
+	{RS2::EntityLine, RS2::EntityLine, lineLine},
+	{RS2::EntityLine, RS2::EntityCircle, lineCircle},
+	{RS2::EntityLine, RS2::EntityArc, lineCircle},
+	{RS2::EntityLine, RS2::EntityEllipse, lineEllipse},
+	{RS2::EntityCircle, RS2::EntityCircle, circleCircle},
+	{RS2::EntityCircle, RS2::EntityArc, circleCircle},
+	{RS2::EntityArc, RS2::EntityArc, circleCircle}
+};
+
+/**
+ * @brief findKernel look up the kernel for a pair of entity types
+ * @param swapped set to true, if the kernel expects the entities in the
+ * opposite order
+ */
+IntersectionKernel findKernel(RS2::EntityType type1, RS2::EntityType type2,
+							  bool& swapped)
+{
+	for (KernelEntry const& entry: intersectionKernels) {
+		if (entry.type1 == type1 && entry.type2 == type2) {
+			swapped = false;
+			return entry.kernel;
+		}
+		if (entry.type1 == type2 && entry.type2 == type1) {
+			swapped = true;
+			return entry.kernel;
+		}
+	}
+	return nullptr;
+}
+}
+
 /**
  * Default constructor.
  *
@@ -248,6 +318,19 @@ RS_VectorSolutions RS_Information::getIntersection(RS_Entity const* e1,
 		}
 	}
 
+    // letters of texts intersect with the strokes of their glyphs
+    if (e1->rtti()==RS2::EntityGlyphRun || e2->rtti()==RS2::EntityGlyphRun) {
+        bool const first = e1->rtti()==RS2::EntityGlyphRun;
+        auto const glyphs = static_cast<LC_GlyphRun const*>(first ? e1 : e2);
+        RS_Entity const* other = first ? e2 : e1;
+        for (RS_Line const& stroke: glyphs->getStrokes()) {
+            for (RS_Vector const& vp: getIntersection(&stroke, other, onEntities)) {
+                ret.push_back(vp);
+            }
+        }
+        return ret;
+    }
+
     //avoid intersections between line segments the same spline
     /* ToDo: 24 Aug 2011, Dongxu Li, if rtti() is not defined for the parent, the following check for splines may still cause segfault */
 	if ( e1->getParent() && e1->getParent() == e2->getParent()) {
@@ -265,18 +348,12 @@ RS_VectorSolutions RS_Information::getIntersection(RS_Entity const* e1,
 	}
 	else
 	{
-		// issue #484 , quadratic intersection solver is not robust enough for quadratic-quadratic
-		// TODO, implement a robust algorithm for quadratic based solvers, and detecting entity type
-		// circles/arcs can be removed
-		auto isArc = [](RS_Entity const* e) {
-			auto type = e->rtti();
-			return type == RS2::EntityCircle || type == RS2::EntityArc;
-		};
-
-		if(isArc(e1) && isArc(e2)){
-			//use specialized arc-arc intersection solver
-			ret=getIntersectionArcArc(e1, e2);
-		}else{
+		bool swapped = false;
+		IntersectionKernel const kernel = findKernel(e1->rtti(), e2->rtti(), swapped);
+		if (kernel) {
+			ret = swapped ? kernel(e2, e1) : kernel(e1, e2);
+		} else {
+			// TODO, implement a robust algorithm for quadratic based solvers
 			const auto qf1=e1->getQuadratic();
 			const auto qf2=e2->getQuadratic();
 			ret=LC_Quadratic::getIntersection(qf1,qf2);
@@ -336,8 +413,8 @@ RS_VectorSolutions RS_Information::getIntersection(RS_Entity const* e1,
 /**
  * @return Intersection between two lines.
  */
-RS_VectorSolutions RS_Information::getIntersectionLineLine(RS_Line* e1,
-        RS_Line* e2) {
+RS_VectorSolutions RS_Information::getIntersectionLineLine(RS_Line const* e1,
+        RS_Line const* e2) {
 
     RS_VectorSolutions ret;
 
@@ -485,6 +562,47 @@ RS_VectorSolutions RS_Information::getIntersectionLineArc(RS_Line* line,
 
 
 
+/**
+ * @return One or two intersection points between a line and a circle or
+ * the circle of an arc.
+ */
+RS_VectorSolutions RS_Information::getIntersectionLineCircle(RS_Line const* line,
+		RS_Entity const* circle) {
+
+	RS_VectorSolutions ret;
+
+	if (!(line && circle)) return ret;
+
+	RS_Vector const p = line->getStartpoint();
+	RS_Vector const d = line->getEndpoint() - p;
+	double const d2 = d.squared();
+	if (d2 < RS_TOLERANCE2) {
+		return ret;
+	}
+	RS_Vector const c = circle->getCenter();
+	double const r = circle->getRadius();
+
+	// foot of the perpendicular from the center, solutions are foot +- h d/|d|
+	RS_Vector const foot = p + d * (RS_Vector::dotP(c - p, d) / d2);
+	double const h2 = r*r - (foot - c).squared();
+
+	// r - distance is about h2/(2r)
+	if (h2 < -2.*r*RS_TOLERANCE) {
+		return ret;
+	}
+	double const h = h2 > 0. ? sqrt(h2) : 0.;
+	// solutions closer than in getIntersectionArcArc() are one touching point
+	if (h < 0.5e-4) {
+		ret = RS_VectorSolutions({foot});
+		ret.setTangent(true);
+		return ret;
+	}
+	RS_Vector const offset = d * (h / sqrt(d2));
+	return RS_VectorSolutions({foot + offset, foot - offset});
+}
+
+
+
 /**
  * @return One or two intersection points between given entities.
  */
@@ -681,8 +799,8 @@ RS_VectorSolutions RS_Information::getIntersectionArcEllipse(RS_Arc * a1,
 /**
  * @return One or two intersection points between given entities.
  */
-RS_VectorSolutions RS_Information::getIntersectionEllipseLine(RS_Line* line,
-        RS_Ellipse* ellipse) {
+RS_VectorSolutions RS_Information::getIntersectionEllipseLine(RS_Line const* line,
+        RS_Ellipse const* ellipse) {
 
     RS_VectorSolutions ret;
 
@@ -707,6 +825,10 @@ RS_VectorSolutions RS_Information::getIntersectionEllipseLine(RS_Line* line,
     RS_Vector a2 = line->getEndpoint().rotate(center, angleVector);
 //    RS_Vector origin = a1;
     RS_Vector dir = a2-a1;
+    if (dir.squared() < RS_TOLERANCE2) {
+        //zero length line
+        return ret;
+    }
     RS_Vector diff = a1 - center;
     RS_Vector mDir = RS_Vector(dir.x/(rx*rx), dir.y/(ry*ry));
     RS_Vector mDiff = RS_Vector(diff.x/(rx*rx), diff.y/(ry*ry));
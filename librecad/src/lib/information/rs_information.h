@@ -70,12 +70,19 @@ public:
 			RS_Entity const* e2,
             bool onEntities = false);
 
-    static RS_VectorSolutions getIntersectionLineLine(RS_Line* e1,
-            RS_Line* e2);
+    static RS_VectorSolutions getIntersectionLineLine(RS_Line const* e1,
+            RS_Line const* e2);
 
     static RS_VectorSolutions getIntersectionLineArc(RS_Line* line,
             RS_Arc* arc);
 
+	/**
+	 * @brief getIntersectionLineCircle intersections of the infinite line
+	 * with the full circle of a circle or an arc
+	 */
+	static RS_VectorSolutions getIntersectionLineCircle(RS_Line const* line,
+			RS_Entity const* circle);
+
 	static RS_VectorSolutions getIntersectionArcArc(RS_Entity const* e1,
 			RS_Entity const* e2);
 
@@ -87,8 +94,8 @@ public:
     static RS_VectorSolutions getIntersectionCircleEllipse(RS_Circle* e1,
             RS_Ellipse* e2);
     
-	static RS_VectorSolutions getIntersectionEllipseLine(RS_Line* line,
-            RS_Ellipse* ellipse);
+	static RS_VectorSolutions getIntersectionEllipseLine(RS_Line const* line,
+            RS_Ellipse const* ellipse);
 	/**
 	 * @brief createQuadrilateral form quadrilateral from 4 straight lines
 	 * @param container contains 4 straight lines
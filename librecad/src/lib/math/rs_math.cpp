@@ -28,7 +28,9 @@
 #include <boost/numeric/ublas/lu.hpp>
 #include <boost/math/special_functions/ellint_2.hpp>
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <muParser.h>
 #include <QString>
 #include <QDebug>
@@ -393,6 +395,26 @@ void RS_Math::test() {
 			}
 			std::cout<<std::endl;
 		}
+
+		std::cout<<"testing batch quadratic solver"<<std::endl;
+		std::vector<double> ce0, ce1;
+		for (auto const& eqn: eqns) {
+			ce0.push_back(eqn.front());
+			ce1.push_back(eqn.back());
+		}
+		// no real root
+		ce0.push_back(0.);
+		ce1.push_back(1.);
+		std::vector<double> roots0(ce0.size()), roots1(ce0.size());
+		quadraticRoots(ce0.size(), ce0.data(), ce1.data(), roots0.data(), roots1.data());
+		for(size_t i=0; i < eqns.size(); i++) {
+			auto sol = quadraticRoots({{eqns[i].front(), eqns[i].back()}});
+			for (double x0: {roots0[i], roots1[i]}) {
+				double const prec = (x0 - sol[0]) * (x0 - sol[sol.size() - 1]);
+				assert(fabs(prec) < RS_TOLERANCE * (fabs(x0) + 1.));
+			}
+		}
+		assert(std::isnan(roots0.back()) && std::isnan(roots1.back()));
 		return;
 	}
 	QString s;
@@ -431,17 +453,17 @@ void RS_Math::test() {
 
 // quadratic, cubic, and quartic equation solver
 // @ ce[] contains coefficient of the cubic equation:
-// @ returns a vector contains real roots
+// @ returns the real roots
 //
-// solvers assume arguments are valid, and there's no attempt to verify validity of the argument pointers
+// The std::array versions work on the stack, the std::vector versions are
+// kept for callers which build coefficients dynamically and forward to them.
 //
 // @author Dongxu Li <dongxuli2011@gmail.com>
-std::vector<double> RS_Math::quadraticSolver(const std::vector<double>& ce)
+RS_Math::Roots<2> RS_Math::quadraticRoots(const std::array<double, 2>& ce)
 //quadratic solver for
 // x^2 + ce[0] x + ce[1] =0
 {
-    std::vector<double> ans(0,0.);
-	if (ce.size() != 2) return ans;
+	Roots<2> ans;
 	using LDouble = long double;
 	LDouble const b = -0.5L * ce[0];
 	LDouble const c = ce[1];
@@ -481,21 +503,43 @@ std::vector<double> RS_Math::quadraticSolver(const std::vector<double>& ce)
 			ans.push_back(b - r);
 
 		//Vieta's formulas for the second root
-		ans.push_back(c/ans.front());
+		ans.push_back(c/ans[0]);
 	} else
 		//multiple roots
 		ans.push_back(b);
 	return ans;
 }
 
+/**
+ * Solves x^2 + ce0[i] x + ce1[i] = 0 for i < count. The loop has no
+ * branches, so the compiler can vectorize it. It works in double precision,
+ * unlike quadraticRoots(). Missing roots are NaN, a double root is returned
+ * twice.
+ */
+void RS_Math::quadraticRoots(size_t count, const double* ce0, const double* ce1,
+							 double* roots0, double* roots1)
+{
+	double const nan = std::numeric_limits<double>::quiet_NaN();
+	for (size_t i = 0; i < count; ++i) {
+		double const b = -0.5 * ce0[i];
+		double const c = ce1[i];
+		double const discriminant = b * b - c;
+		double const r = std::sqrt(std::max(discriminant, 0.));
+		// b + r and b - r without loss of significance, Vieta's formulas
+		// for the other root
+		double const x0 = b >= 0. ? b + r : b - r;
+		double const x1 = x0 != 0. ? c / x0 : 0.;
+		roots0[i] = discriminant >= 0. ? x0 : nan;
+		roots1[i] = discriminant >= 0. ? x1 : nan;
+	}
+}
 
-std::vector<double> RS_Math::cubicSolver(const std::vector<double>& ce)
+
+RS_Math::Roots<3> RS_Math::cubicRoots(const std::array<double, 3>& ce)
 //cubic equation solver
 // x^3 + ce[0] x^2 + ce[1] x + ce[2] = 0
 {
-//    std::cout<<"x^3 + ("<<ce[0]<<")*x^2+("<<ce[1]<<")*x+("<<ce[2]<<")==0"<<std::endl;
-    std::vector<double> ans(0,0.);
-	if (ce.size() != 3) return ans;
+	Roots<3> ans;
     // depressed cubic, Tschirnhaus transformation, x= t - b/(3a)
     // t^3 + p t +q =0
     double shift=(1./3)*ce[0];
@@ -512,34 +556,22 @@ std::vector<double> RS_Math::cubicSolver(const std::vector<double>& ce)
     //	and u^3,v^3 are,
     //		-q/2 \pm sqrt(q^2/4 + p^3/27)
     //	discriminant= q^2/4 + p^3/27
-    //std::cout<<"p="<<p<<"\tq="<<q<<std::endl;
     double discriminant= (1./27)*p*p*p+(1./4)*q*q;
     if ( fabs(p)< 1.0e-75) {
         ans.push_back((q>0)?-pow(q,(1./3)):pow(-q,(1./3)));
         ans[0] -= shift;
-//        DEBUG_HEADER
-//        std::cout<<"cubic: one root: "<<ans[0]<<std::endl;
         return ans;
     }
-    //std::cout<<"discriminant="<<discriminant<<std::endl;
     if(discriminant>0) {
-        std::vector<double> ce2(2,0.);
-        ce2[0]=q;
-        ce2[1]=-1./27*p*p*p;
-		auto r=quadraticSolver(ce2);
+		auto r=quadraticRoots({{q, -1./27*p*p*p}});
         if ( r.size()==0 ) { //should not happen
 			std::cerr<<__FILE__<<" : "<<__func__<<" : line"<<__LINE__<<" :cubicSolver()::Error cubicSolver("<<ce[0]<<' '<<ce[1]<<' '<<ce[2]<<")\n";
+			return ans;
         }
         double u,v;
-        u= (q<=0) ? pow(r[0], 1./3): -pow(-r[1],1./3);
-        //u=(q<=0)?pow(-0.5*q+sqrt(discriminant),1./3):-pow(0.5*q+sqrt(discriminant),1./3);
+        u= (q<=0) ? pow(r[0], 1./3): -pow(-r[r.size() - 1],1./3);
         v=(-1./3)*p/u;
-        //std::cout<<"u="<<u<<"\tv="<<v<<std::endl;
-        //std::cout<<"u^3="<<u*u*u<<"\tv^3="<<v*v*v<<std::endl;
         ans.push_back(u+v - shift);
-
-//        DEBUG_HEADER
-//        std::cout<<"cubic: one root: "<<ans[0]<<std::endl;
 	}else{
 		std::complex<double> u(q,0),rt[3];
 		u=std::pow(-0.5*u-sqrt(0.25*u*u+p*p*p/27),1./3);
@@ -547,11 +579,6 @@ std::vector<double> RS_Math::cubicSolver(const std::vector<double>& ce)
 		std::complex<double> w(-0.5,sqrt(3.)/2);
 		rt[1]=u*w-p/(3.*u*w)-shift;
 		rt[2]=u/w-p*w/(3.*u)-shift;
-		//        DEBUG_HEADER
-		//        std::cout<<"Roots:\n";
-		//        std::cout<<rt[0]<<std::endl;
-		//        std::cout<<rt[1]<<std::endl;
-		//        std::cout<<rt[2]<<std::endl;
 		ans.push_back(rt[0].real());
 		ans.push_back(rt[1].real());
 		ans.push_back(rt[2].real());
@@ -575,18 +602,14 @@ std::vector<double> RS_Math::cubicSolver(const std::vector<double>& ce)
 
 /** quartic solver
 * x^4 + ce[0] x^3 + ce[1] x^2 + ce[2] x + ce[3] = 0
-@ce, a vector of size 4 contains the coefficient in order
-@return, a vector contains real roots
+@ce, the coefficients in order
+@return, the real roots
 **/
-std::vector<double> RS_Math::quarticSolver(const std::vector<double>& ce)
+RS_Math::Roots<4> RS_Math::quarticRoots(const std::array<double, 4>& ce)
 {
-    std::vector<double> ans(0,0.);
+	Roots<4> ans;
     if(RS_DEBUG->getLevel()>=RS_Debug::D_INFORMATIONAL){
 		DEBUG_HEADER
-        std::cout<<"expected array size=4, got "<<ce.size()<<std::endl;
-    }
-    if(ce.size() != 4) return ans;
-    if(RS_DEBUG->getLevel()>=RS_Debug::D_INFORMATIONAL){
         std::cout<<"x^4+("<<ce[0]<<")*x^3+("<<ce[1]<<")*x^2+("<<ce[2]<<")*x+("<<ce[3]<<")==0"<<std::endl;
     }
 
@@ -610,16 +633,11 @@ std::vector<double> RS_Math::quarticSolver(const std::vector<double>& ce)
     if (q*q <= 1.e-4*RS_TOLERANCE*fabs(p*r)) {// Biquadratic equations
         double discriminant= 0.25*p*p -r;
         if (discriminant < -1.e3*RS_TOLERANCE) {
-
-//            DEBUG_HEADER
-//            std::cout<<"discriminant="<<discriminant<<"\tno root"<<std::endl;
             return ans;
         }
         double t2[2];
         t2[0]=-0.5*p-sqrt(fabs(discriminant));
         t2[1]= -p - t2[0];
-        //        std::cout<<"t2[0]="<<t2[0]<<std::endl;
-        //        std::cout<<"t2[1]="<<t2[1]<<std::endl;
         if ( t2[1] >= 0.) { // two real roots
             ans.push_back(sqrt(t2[1])-shift);
             ans.push_back(-sqrt(t2[1])-shift);
@@ -628,20 +646,14 @@ std::vector<double> RS_Math::quarticSolver(const std::vector<double>& ce)
             ans.push_back(sqrt(t2[0])-shift);
             ans.push_back(-sqrt(t2[0])-shift);
         }
-//        DEBUG_HEADER
-//        for(int i=0;i<ans.size();i++){
-//            std::cout<<"root x: "<<ans[i]<<std::endl;
-//        }
         return ans;
     }
     if ( fabs(r)< 1.0e-75 ) {
-        std::vector<double> cubic(3,0.);
-        cubic[1]=p;
-        cubic[2]=q;
         ans.push_back(0.);
-		auto r=cubicSolver(cubic);
-		std::copy(r.begin(),r.end(), std::back_inserter(ans));
-        for(size_t i=0; i<ans.size(); i++) ans[i] -= shift;
+		for (double x: cubicRoots({{0., p, q}}))
+			ans.push_back(x);
+		for (double& x: ans)
+			x -= shift;
         return ans;
     }
     // depressed quartic to two quadratic equations
@@ -655,15 +667,7 @@ std::vector<double> RS_Math::quarticSolver(const std::vector<double>& ce)
     //  y=u^2,
     //  y^3 + 2 p y^2 + ( p^2 - 4 r) y - q^2 =0
     //
-    std::vector<double> cubic(3,0.);
-    cubic[0]=2.*p;
-    cubic[1]=p*p-4.*r;
-    cubic[2]=-q*q;
-	auto r3= cubicSolver(cubic);
-    //std::cout<<"quartic_solver:: real roots from cubic: "<<ret<<std::endl;
-    //for(unsigned int i=0; i<ret; i++)
-    //   std::cout<<"cubic["<<i<<"]="<<cubic[i]<<" x= "<<croots[i]<<std::endl;
-	//newton-raphson
+	auto r3= cubicRoots({{2.*p, p*p-4.*r, -q*q}});
     if (r3.size()==1) { //one real root from cubic
         if (r3[0]< 0.) {//this should not happen
 			DEBUG_HEADER
@@ -671,33 +675,21 @@ std::vector<double> RS_Math::quarticSolver(const std::vector<double>& ce)
             return ans;
         }
         double sqrtz0=sqrt(r3[0]);
-        std::vector<double> ce2(2,0.);
-        ce2[0]=	-sqrtz0;
-        ce2[1]=0.5*(p+r3[0])+0.5*q/sqrtz0;
-        auto r1=quadraticSolver(ce2);
+        auto r1=quadraticRoots({{-sqrtz0, 0.5*(p+r3[0])+0.5*q/sqrtz0}});
         if (r1.size()==0 ) {
-            ce2[0]=	sqrtz0;
-            ce2[1]=0.5*(p+r3[0])-0.5*q/sqrtz0;
-            r1=quadraticSolver(ce2);
+            r1=quadraticRoots({{sqrtz0, 0.5*(p+r3[0])-0.5*q/sqrtz0}});
         }
-		for(auto& x: r1){
-			x -= shift;
+		for(double x: r1){
+			ans.push_back(x - shift);
 		}
-        return r1;
+        return ans;
     }
     if ( r3[0]> 0. && r3[1] > 0. ) {
         double sqrtz0=sqrt(r3[0]);
-        std::vector<double> ce2(2,0.);
-        ce2[0]=	-sqrtz0;
-        ce2[1]=0.5*(p+r3[0])+0.5*q/sqrtz0;
-        ans=quadraticSolver(ce2);
-        ce2[0]=	sqrtz0;
-        ce2[1]=0.5*(p+r3[0])-0.5*q/sqrtz0;
-		auto r1=quadraticSolver(ce2);
-		std::copy(r1.begin(),r1.end(),std::back_inserter(ans));
-		for(auto& x: ans){
-			x -= shift;
-		}
+		for (double x: quadraticRoots({{-sqrtz0, 0.5*(p+r3[0])+0.5*q/sqrtz0}}))
+			ans.push_back(x - shift);
+		for (double x: quadraticRoots({{sqrtz0, 0.5*(p+r3[0])-0.5*q/sqrtz0}}))
+			ans.push_back(x - shift);
     }
 	// newton-raphson
 	for(double& x0: ans){
@@ -705,8 +697,6 @@ std::vector<double> RS_Math::quarticSolver(const std::vector<double>& ce)
 		for(size_t i=0; i<20; ++i){
 			double f=(( (x0 + ce[0])*x0 + ce[1])*x0 +ce[2])*x0 + ce[3] ;
 			double df=((4.*x0+3.*ce[0])*x0 +2.*ce[1])*x0+ce[2];
-//			DEBUG_HEADER
-//			qDebug()<<"i="<<i<<"\tx0="<<x0<<"\tf="<<f<<"\tdf="<<df;
 			if(fabs(df)>RS_TOLERANCE2){
 				dx=f/df;
 				x0 -= dx;
@@ -720,20 +710,18 @@ std::vector<double> RS_Math::quarticSolver(const std::vector<double>& ce)
 
 /** quartic solver
 * ce[4] x^4 + ce[3] x^3 + ce[2] x^2 + ce[1] x + ce[0] = 0
-@ce, a vector of size 5 contains the coefficient in order
-@return, a vector contains real roots
+@ce, the coefficients in order
+@return, the real roots
 *ToDo, need a robust algorithm to locate zero terms, better handling of tolerances
 **/
-std::vector<double> RS_Math::quarticSolverFull(const std::vector<double>& ce)
+RS_Math::Roots<4> RS_Math::quarticRootsFull(const std::array<double, 5>& ce)
 {
     if(RS_DEBUG->getLevel()>=RS_Debug::D_INFORMATIONAL){
 		DEBUG_HEADER
         std::cout<<ce[4]<<"*y^4+("<<ce[3]<<")*y^3+("<<ce[2]<<"*y^2+("<<ce[1]<<")*y+("<<ce[0]<<")==0"<<std::endl;
     }
 
-    std::vector<double> roots(0,0.);
-    if(ce.size()!=5) return roots;
-    std::vector<double> ce2(4,0.);
+	Roots<4> roots;
 
     if ( fabs(ce[4]) < 1.0e-14) { // this should not happen
         if ( fabs(ce[3]) < 1.0e-14) { // this should not happen
@@ -744,40 +732,51 @@ std::vector<double> RS_Math::quarticSolverFull(const std::vector<double>& ce)
                     return roots;
                 }
             } else {
-                ce2.resize(2);
-                ce2[0]=ce[1]/ce[2];
-                ce2[1]=ce[0]/ce[2];
-                //std::cout<<"ce2[2]={ "<<ce2[0]<<' '<<ce2[1]<<" }\n";
-                roots=RS_Math::quadraticSolver(ce2);
+				roots.assign(quadraticRoots({{ce[1]/ce[2], ce[0]/ce[2]}}));
             }
         } else {
-            ce2.resize(3);
-            ce2[0]=ce[2]/ce[3];
-            ce2[1]=ce[1]/ce[3];
-            ce2[2]=ce[0]/ce[3];
-            //std::cout<<"ce2[3]={ "<<ce2[0]<<' '<<ce2[1]<<' '<<ce2[2]<<" }\n";
-            roots=RS_Math::cubicSolver(ce2);
+			roots.assign(cubicRoots({{ce[2]/ce[3], ce[1]/ce[3], ce[0]/ce[3]}}));
         }
     } else {
-        ce2[0]=ce[3]/ce[4];
-        ce2[1]=ce[2]/ce[4];
-        ce2[2]=ce[1]/ce[4];
-        ce2[3]=ce[0]/ce[4];
+		std::array<double, 4> const ce2{{ce[3]/ce[4], ce[2]/ce[4], ce[1]/ce[4], ce[0]/ce[4]}};
         if(RS_DEBUG->getLevel()>=RS_Debug::D_INFORMATIONAL){
 			DEBUG_HEADER
             std::cout<<"ce2[4]={ "<<ce2[0]<<' '<<ce2[1]<<' '<<ce2[2]<<' '<<ce2[3]<<" }\n";
         }
         if(fabs(ce2[3])<= RS_TOLERANCE15) {
             //constant term is zero, factor 0 out, solve a cubic equation
-            ce2.resize(3);
-            roots=RS_Math::cubicSolver(ce2);
+			roots.assign(cubicRoots({{ce2[0], ce2[1], ce2[2]}}));
             roots.push_back(0.);
         }else
-            roots=RS_Math::quarticSolver(ce2);
+            roots=quarticRoots(ce2);
     }
     return roots;
 }
 
+std::vector<double> RS_Math::quadraticSolver(const std::vector<double>& ce)
+{
+	if (ce.size() != 2) return {};
+	return quadraticRoots({{ce[0], ce[1]}}).toVector();
+}
+
+std::vector<double> RS_Math::cubicSolver(const std::vector<double>& ce)
+{
+	if (ce.size() != 3) return {};
+	return cubicRoots({{ce[0], ce[1], ce[2]}}).toVector();
+}
+
+std::vector<double> RS_Math::quarticSolver(const std::vector<double>& ce)
+{
+	if (ce.size() != 4) return {};
+	return quarticRoots({{ce[0], ce[1], ce[2], ce[3]}}).toVector();
+}
+
+std::vector<double> RS_Math::quarticSolverFull(const std::vector<double>& ce)
+{
+	if (ce.size() != 5) return {};
+	return quarticRootsFull({{ce[0], ce[1], ce[2], ce[3], ce[4]}}).toVector();
+}
+
 //linear Equation solver by Gauss-Jordan
 /**
   * Solve linear equation set
@@ -1000,7 +999,7 @@ RS_VectorSolutions RS_Math::simultaneousQuadraticSolverFull(const std::vector<st
     double  j2=j*j;
     double  k2=k*k;
     double  l2=l*l;
-    std::vector<double> qy(5,0.);
+    std::array<double, 5> qy;
     //y^4
     qy[4]=-c2*g2 + b*c*g*h - a*c*h2 - b2*g*i + 2.*a*c*g*i + a*b*h*i - a2*i2;
     //y^3
@@ -1021,7 +1020,7 @@ RS_VectorSolutions RS_Math::simultaneousQuadraticSolverFull(const std::vector<st
         std::cout<<qy[4]<<"*y^4 +("<<qy[3]<<")*y^3+("<<qy[2]<<")*y^2+("<<qy[1]<<")*y+("<<qy[0]<<")==0"<<std::endl;
 	}
     //quarticSolver
-	auto roots=quarticSolverFull(qy);
+	auto roots=quarticRootsFull(qy);
     if(RS_DEBUG->getLevel()>=RS_Debug::D_INFORMATIONAL){
         std::cout<<"roots.size()= "<<roots.size()<<std::endl;
     }
@@ -1029,7 +1028,7 @@ RS_VectorSolutions RS_Math::simultaneousQuadraticSolverFull(const std::vector<st
     if (roots.size()==0 ) { // no intersection found
         return ret;
     }
-    std::vector<double> ce(0,0.);
+    std::array<double, 3> ce;
 
     for(size_t i0=0;i0<roots.size();i0++){
         if(RS_DEBUG->getLevel()>=RS_Debug::D_INFORMATIONAL){
@@ -1039,7 +1038,6 @@ RS_VectorSolutions RS_Math::simultaneousQuadraticSolverFull(const std::vector<st
         /*
           Collect[Eliminate[{ a*x^2 + b*x*y+c*y^2+d*x+e*y+f==0,g*x^2+h*x*y+i*y^2+j*x+k*y+l==0},x],y]
           */
-        ce.resize(3);
         ce[0]=a;
         ce[1]=b*roots[i0]+d;
         ce[2]=c*roots[i0]*roots[i0]+e*roots[i0]+f;
@@ -1056,12 +1054,9 @@ RS_VectorSolutions RS_Math::simultaneousQuadraticSolverFull(const std::vector<st
         if(fabs(ce[0])<1e-75 && fabs(ce[1])<1e-75) continue;
 
         if(fabs(a)>1e-75){
-            std::vector<double> ce2(2,0.);
-            ce2[0]=ce[1]/ce[0];
-            ce2[1]=ce[2]/ce[0];
 //                DEBUG_HEADER
-//                        std::cout<<"x^2 +("<<ce2[0]<<")*x+("<<ce2[1]<<")==0"<<std::endl;
-			auto xRoots=quadraticSolver(ce2);
+//                        std::cout<<"x^2 +("<<ce[1]/ce[0]<<")*x+("<<ce[2]/ce[0]<<")==0"<<std::endl;
+			auto xRoots=quadraticRoots({{ce[1]/ce[0], ce[2]/ce[0]}});
             for(size_t j0=0;j0<xRoots.size();j0++){
 //                DEBUG_HEADER
 //                std::cout<<"x="<<xRoots[j0]<<std::endl;
@@ -27,6 +27,8 @@
 #ifndef RS_MATH_H
 #define RS_MATH_H
 
+#include <array>
+#include <cstddef>
 #include <vector>
 
 class RS_Vector;
@@ -78,6 +80,54 @@ public:
     static double eval(const QString& expr, bool* ok);
 	//! \}
 
+	/**
+	 * Real roots of a polynomial of degree up to N, kept on the stack.
+	 */
+	template<size_t N>
+	class Roots {
+	public:
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		double& operator [] (size_t i) { return values[i]; }
+		double operator [] (size_t i) const { return values[i]; }
+		double* begin() { return values.data(); }
+		double* end() { return values.data() + count; }
+		const double* begin() const { return values.data(); }
+		const double* end() const { return values.data() + count; }
+
+		void push_back(double x) { values[count++] = x; }
+		//! replace the roots by roots of a polynomial of lower degree
+		template<size_t M>
+		void assign(const Roots<M>& other) {
+			static_assert(M <= N, "too many roots");
+			count = 0;
+			for (double x: other)
+				push_back(x);
+		}
+		std::vector<double> toVector() const {
+			return std::vector<double>(begin(), end());
+		}
+
+	private:
+		std::array<double, N> values;
+		size_t count = 0;
+	};
+
+	/** \{ \brief polynomial solvers, the coefficients are ordered as for the
+	  * std::vector versions below, which forward to these */
+	static Roots<2> quadraticRoots(const std::array<double, 2>& ce);
+	static Roots<3> cubicRoots(const std::array<double, 3>& ce);
+	static Roots<4> quarticRoots(const std::array<double, 4>& ce);
+	static Roots<4> quarticRootsFull(const std::array<double, 5>& ce);
+	//! \}
+	/**
+	 * @brief quadraticRoots solve count quadratic equations at once,
+	 * x^2 + ce0[i] x + ce1[i] = 0, coefficients and roots in separate arrays
+	 * @param roots0,roots1 the roots, NaN if there's no real root
+	 */
+	static void quadraticRoots(size_t count, const double* ce0, const double* ce1,
+							   double* roots0, double* roots1);
+
     static std::vector<double> quadraticSolver(const std::vector<double>& ce);
     static std::vector<double> cubicSolver(const std::vector<double>& ce);
     /** quartic solver
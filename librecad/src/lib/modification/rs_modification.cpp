@@ -35,6 +35,7 @@
 #include "rs_clipboard.h"
 #include "rs_creation.h"
 #include "rs_graphic.h"
+#include "rs_hatch.h"
 #include "rs_information.h"
 #include "rs_insert.h"
 #include "rs_block.h"
@@ -47,6 +48,8 @@
 #include "rs_debug.h"
 #include "rs_dialogfactory.h"
 #include "lc_undosection.h"
+#include "lc_bulkedit.h"
+#include "lc_transformundoable.h"
 
 #ifdef EMU_C99
 #include "emu_c99.h"
@@ -101,7 +104,7 @@ void RS_Modification::remove() {
 
     LC_UndoSection undo( document);
 	// not safe (?)
-    for(auto e: *container) {
+    for(auto e: container->selectedEntities()) {
         if (e && e->isSelected()) {
             e->setSelected(false);
             e->changeUndoState();
@@ -131,7 +134,7 @@ void RS_Modification::revertDirection() {
 	}
 
 	std::vector<RS_Entity*> addList;
-    for(auto e: *container) {
+    for(auto e: container->selectedEntities()) {
 		if (e && e->isSelected()) {
 			RS_Entity* ec = e->clone();
 			ec->revertDirection();
@@ -141,9 +144,10 @@ void RS_Modification::revertDirection() {
         }
 	}
 
-    LC_UndoSection undo( document, handleUndo); // bundle remove/add entities in one undoCycle
-    deselectOriginals(true);
-	addNewEntities(addList);
+    // bundle remove/add entities in one undoCycle and one redraw
+    LC_BulkEdit edit(*container, document, graphicView, handleUndo);
+    deselectOriginals(edit, true);
+    addNewEntities(edit, addList);
 
     RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Modification::revertDirection: OK");
 }
@@ -170,7 +174,7 @@ bool RS_Modification::changeAttributes(
     QList<RS_Entity*> clones;
     QSet<RS_Block*> blocks;
 
-    for (auto en: *cont) {
+    for (auto en: cont->selectedEntities()) {
         if (!en) continue;
         if (!en->isSelected()) continue;
 
@@ -272,7 +276,7 @@ void RS_Modification::copy(const RS_Vector& ref, const bool cut) {
     LC_UndoSection undo( document, cut && handleUndo);
 
 	// copy entities / layers / blocks
-	for(auto e: *container){
+	for(auto e: container->selectedEntities()){
         //for (unsigned i=0; i<container->count(); ++i) {
         //RS_Entity* e = container->entityAt(i);
         if (e && e->isSelected()) {
@@ -1586,6 +1590,14 @@ bool RS_Modification::move(RS_MoveData& data) {
         return false;
     }
 
+    if (data.number==0 && !data.useCurrentLayer && !data.useCurrentAttributes) {
+        std::unique_ptr<LC_TransformUndoable> transform = selectionTransform();
+        transform->move(data.offset);
+        // since 2.0.4.0: keep selection
+        transformSelection(std::move(transform), true);
+        return true;
+    }
+
 	std::vector<RS_Entity*> addList;
 
     // Create new entities
@@ -1595,7 +1607,7 @@ bool RS_Modification::move(RS_MoveData& data) {
         // too slow:
         //for (unsigned i=0; i<container->count(); ++i) {
 		//RS_Entity* e = container->entityAt(i);
-		for(auto e: *container){
+		for(auto e: container->selectedEntities()){
 			if (e && e->isSelected()) {
                 RS_Entity* ec = e->clone();
 
@@ -1616,9 +1628,10 @@ bool RS_Modification::move(RS_MoveData& data) {
         }
     }
 
-    LC_UndoSection undo( document, handleUndo); // bundle remove/add entities in one undoCycle
-    deselectOriginals(data.number==0);
-    addNewEntities(addList);
+    // bundle remove/add entities in one undoCycle and one redraw
+    LC_BulkEdit edit(*container, document, graphicView, handleUndo);
+    deselectOriginals(edit, data.number==0);
+    addNewEntities(edit, addList);
 
     return true;
 }
@@ -1643,7 +1656,7 @@ bool RS_Modification::offset(const RS_OffsetData& data) {
             num<=data.number || (data.number==0 && num<=1);
             num++) {
         // too slow:
-		for(auto e: *container){
+		for(auto e: container->selectedEntities()){
 			if (e && e->isSelected()) {
                 RS_Entity* ec = e->clone();
 				//highlight is used by trim actions. do not carry over flag
@@ -1669,9 +1682,10 @@ bool RS_Modification::offset(const RS_OffsetData& data) {
         }
     }
 
-    LC_UndoSection undo( document, handleUndo); // bundle remove/add entities in one undoCycle
-    deselectOriginals(data.number==0);
-    addNewEntities(addList);
+    // bundle remove/add entities in one undoCycle and one redraw
+    LC_BulkEdit edit(*container, document, graphicView, handleUndo);
+    deselectOriginals(edit, data.number==0);
+    addNewEntities(edit, addList);
 
     return true;
 }
@@ -1689,13 +1703,20 @@ bool RS_Modification::rotate(RS_RotateData& data) {
         return false;
     }
 
+    if (data.number==0 && !data.useCurrentLayer && !data.useCurrentAttributes) {
+        std::unique_ptr<LC_TransformUndoable> transform = selectionTransform();
+        transform->rotate(data.center, data.angle);
+        transformSelection(std::move(transform), false);
+        return true;
+    }
+
 	std::vector<RS_Entity*> addList;
 
     // Create new entities
     for (int num=1;
             num<=data.number || (data.number==0 && num<=1);
 			num++) {
-		for(auto e: *container){
+		for(auto e: container->selectedEntities()){
             //for (unsigned i=0; i<container->count(); ++i) {
             //RS_Entity* e = container->entityAt(i);
 
@@ -1718,9 +1739,10 @@ bool RS_Modification::rotate(RS_RotateData& data) {
         }
     }
 
-    LC_UndoSection undo( document, handleUndo); // bundle remove/add entities in one undoCycle
-    deselectOriginals(data.number==0);
-    addNewEntities(addList);
+    // bundle remove/add entities in one undoCycle and one redraw
+    LC_BulkEdit edit(*container, document, graphicView, handleUndo);
+    deselectOriginals(edit, data.number==0);
+    addNewEntities(edit, addList);
 
     return true;
 }
@@ -1738,9 +1760,19 @@ bool RS_Modification::scale(RS_ScaleData& data) {
         return false;
     }
 
+    // non-isotropic scaling replaces circles and arcs by ellipses
+    if (data.number==0 && !data.useCurrentLayer && !data.useCurrentAttributes
+            && fabs(data.factor.x - data.factor.y) <= RS_TOLERANCE
+            && fabs(data.factor.x) > RS_TOLERANCE) {
+        std::unique_ptr<LC_TransformUndoable> transform = selectionTransform();
+        transform->scale(data.referencePoint, data.factor);
+        transformSelection(std::move(transform), false);
+        return true;
+    }
+
 	std::vector<RS_Entity*> selectedList,addList;
 
-	for(auto ec: *container){
+	for(auto ec: container->selectedEntities()){
         if (ec->isSelected() ) {
             if ( fabs(data.factor.x - data.factor.y) > RS_TOLERANCE ) {
                     if ( ec->rtti() == RS2::EntityCircle ) {
@@ -1797,9 +1829,10 @@ bool RS_Modification::scale(RS_ScaleData& data) {
         }
     }
 
-    LC_UndoSection undo( document, handleUndo); // bundle remove/add entities in one undoCycle
-    deselectOriginals(data.number==0);
-    addNewEntities(addList);
+    // bundle remove/add entities in one undoCycle and one redraw
+    LC_BulkEdit edit(*container, document, graphicView, handleUndo);
+    deselectOriginals(edit, data.number==0);
+    addNewEntities(edit, addList);
 
     return true;
 }
@@ -1817,13 +1850,40 @@ bool RS_Modification::mirror(RS_MirrorData& data) {
         return false;
     }
 
+    if (!data.copy && !data.useCurrentLayer && !data.useCurrentAttributes) {
+        std::unique_ptr<LC_TransformUndoable> transform =
+                selectionTransform(LC_TransformUndoable::canMirrorBack);
+        transform->mirror(data.axisPoint1, data.axisPoint2);
+
+        // undo could not mirror these back, they are replaced by clones
+        std::vector<RS_Entity*> replaced;
+        std::vector<RS_Entity*> addList;
+        for (auto e: container->selectedEntities()) {
+            if (e && e->isSelected() && !LC_TransformUndoable::canMirrorBack(e)) {
+                RS_Entity* ec = e->clone();
+                ec->setSelected(false);
+                ec->mirror(data.axisPoint1, data.axisPoint2);
+                replaced.push_back(e);
+                addList.push_back(ec);
+            }
+        }
+
+        LC_BulkEdit edit(*container, document, graphicView, handleUndo);
+        transformSelection(std::move(transform), false, edit);
+        for (RS_Entity* e: replaced) {
+            edit.remove(e);
+        }
+        addNewEntities(edit, addList);
+        return true;
+    }
+
 	std::vector<RS_Entity*> addList;
 
     // Create new entities
     for (int num=1;
             num<=(int)data.copy || (data.copy==false && num<=1);
 			++num) {
-		for(auto e: *container){
+		for(auto e: container->selectedEntities()){
             //for (unsigned i=0; i<container->count(); ++i) {
             //RS_Entity* e = container->entityAt(i);
 
@@ -1846,9 +1906,10 @@ bool RS_Modification::mirror(RS_MirrorData& data) {
         }
     }
 
-    LC_UndoSection undo( document, handleUndo); // bundle remove/add entities in one undoCycle
-    deselectOriginals(data.copy==false);
-    addNewEntities(addList);
+    // bundle remove/add entities in one undoCycle and one redraw
+    LC_BulkEdit edit(*container, document, graphicView, handleUndo);
+    deselectOriginals(edit, data.copy==false);
+    addNewEntities(edit, addList);
 
     return true;
 }
@@ -1865,6 +1926,16 @@ bool RS_Modification::rotate2(RS_Rotate2Data& data) {
         return false;
     }
 
+    if (data.number==0 && !data.useCurrentLayer && !data.useCurrentAttributes) {
+        std::unique_ptr<LC_TransformUndoable> transform = selectionTransform();
+        RS_Vector center2 = data.center2;
+        center2.rotate(data.center1, data.angle1);
+        transform->rotate(data.center1, data.angle1);
+        transform->rotate(center2, data.angle2);
+        transformSelection(std::move(transform), false);
+        return true;
+    }
+
 	std::vector<RS_Entity*> addList;
 
     // Create new entities
@@ -1872,7 +1943,7 @@ bool RS_Modification::rotate2(RS_Rotate2Data& data) {
             num<=data.number || (data.number==0 && num<=1);
             num++) {
 
-		for(auto e: *container){
+		for(auto e: container->selectedEntities()){
             //for (unsigned i=0; i<container->count(); ++i) {
             //RS_Entity* e = container->entityAt(i);
 
@@ -1899,9 +1970,10 @@ bool RS_Modification::rotate2(RS_Rotate2Data& data) {
         }
     }
 
-    LC_UndoSection undo( document, handleUndo); // bundle remove/add entities in one undoCycle
-    deselectOriginals(data.number==0);
-    addNewEntities(addList);
+    // bundle remove/add entities in one undoCycle and one redraw
+    LC_BulkEdit edit(*container, document, graphicView, handleUndo);
+    deselectOriginals(edit, data.number==0);
+    addNewEntities(edit, addList);
 
     return true;
 }
@@ -1918,13 +1990,21 @@ bool RS_Modification::moveRotate(RS_MoveRotateData& data) {
         return false;
     }
 
+    if (data.number==0 && !data.useCurrentLayer && !data.useCurrentAttributes) {
+        std::unique_ptr<LC_TransformUndoable> transform = selectionTransform();
+        transform->move(data.offset);
+        transform->rotate(data.referencePoint + data.offset, data.angle);
+        transformSelection(std::move(transform), false);
+        return true;
+    }
+
 	std::vector<RS_Entity*> addList;
 
     // Create new entities
     for (int num=1;
             num<=data.number || (data.number==0 && num<=1);
 			++num) {
-		for(auto e: *container){
+		for(auto e: container->selectedEntities()){
             //for (unsigned i=0; i<container->count(); ++i) {
             //RS_Entity* e = container->entityAt(i);
 
@@ -1949,9 +2029,10 @@ bool RS_Modification::moveRotate(RS_MoveRotateData& data) {
         }
     }
 
-    LC_UndoSection undo( document, handleUndo); // bundle remove/add entities in one undoCycle
-    deselectOriginals(data.number==0);
-    addNewEntities(addList);
+    // bundle remove/add entities in one undoCycle and one redraw
+    LC_BulkEdit edit(*container, document, graphicView, handleUndo);
+    deselectOriginals(edit, data.number==0);
+    addNewEntities(edit, addList);
 
     return true;
 }
@@ -1959,79 +2040,99 @@ bool RS_Modification::moveRotate(RS_MoveRotateData& data) {
 
 
 /**
- * Deselects all selected entities and removes them if remove is true;
+ * @return A transformation of the selected entities without steps yet.
  *
- * @param remove true: Remove entities.
+ * @param accept If given, only selected entities it accepts are transformed.
  */
-void RS_Modification::deselectOriginals(bool remove)
+std::unique_ptr<LC_TransformUndoable> RS_Modification::selectionTransform(
+        bool (*accept)(RS_Entity const*)) const
 {
-    LC_UndoSection undo( document, handleUndo);
+    std::vector<RS_Entity*> selected;
+    for (auto e: container->selectedEntities()) {
+        if (e && e->isSelected() && (!accept || accept(e))) {
+            selected.push_back(e);
+        }
+    }
+    return std::unique_ptr<LC_TransformUndoable>(
+                new LC_TransformUndoable(container, std::move(selected)));
+}
 
-    for (auto e: *container) {
 
-        //for (unsigned i=0; i<container->count(); ++i) {
-        //RS_Entity* e = container->entityAt(i);
 
-        if (e) {
-            bool selected = false;
+/**
+ * Transforms the entities in place and adds the transformation to the
+ * undo cycle. Used instead of cloning the entities, when the modification
+ * doesn't keep the originals and doesn't change the type of the entities.
+ *
+ * @param keepSelection false: Deselect the entities.
+ */
+void RS_Modification::transformSelection(std::unique_ptr<LC_TransformUndoable> transform,
+                                         bool keepSelection)
+{
+    if (transform->count() == 0) {
+        return;
+    }
 
-            /*
-                  if (e->isAtomic()) {
-                      RS_AtomicEntity* ae = (RS_AtomicEntity*)e;
-                      if (ae->isStartpointSelected() ||
-                              ae->isEndpointSelected()) {
+    LC_BulkEdit edit(*container, document, graphicView, handleUndo);
+    transformSelection(std::move(transform), keepSelection, edit);
+}
 
-                          selected = true;
-                      }
-                  }
-            */
 
-            if (e->isSelected()) {
-                selected = true;
-            }
 
-            if (selected) {
-                e->setSelected(false);
-                if (remove
-                   ) {
-                    //if (graphicView) {
-                    //    graphicView->deleteEntity(e);
-                    //}
-                    e->changeUndoState();
-                    undo.addUndoable(e);
-                } else {
-                    //if (graphicView) {
-                    //    graphicView->drawEntity(e);
-                    //}
-                }
-            }
+/**
+ * Same as above, but the changes become part of an edit of the caller.
+ */
+void RS_Modification::transformSelection(std::unique_ptr<LC_TransformUndoable> transform,
+                                         bool keepSelection, LC_BulkEdit& edit)
+{
+    if (transform->count() == 0) {
+        return;
+    }
+
+    if (!keepSelection) {
+        for (RS_Entity* e: transform->getEntities()) {
+            edit.deselect(e);
         }
     }
+    transform->apply(edit);
+    if (document && handleUndo) {
+        edit.addUndoable(transform.release());
+    }
 }
 
 
 
 /**
- * Adds the given entities to the container and draws the entities if
- * there's a graphic view available.
+ * Deselects all selected entities and removes them if remove is true;
  *
- * @param addList Entities to add.
+ * @param remove true: Remove entities.
  */
-void RS_Modification::addNewEntities(std::vector<RS_Entity*>& addList)
+void RS_Modification::deselectOriginals(LC_BulkEdit& edit, bool remove)
 {
-    LC_UndoSection undo( document, handleUndo);
-
-    for (RS_Entity* e: addList) {
-        if (e) {
-            container->addEntity(e);
-            undo.addUndoable(e);
+    for (auto e: container->selectedEntities()) {
+        if (e && e->isSelected()) {
+            if (remove) {
+                edit.remove(e);
+            } else {
+                edit.deselect(e);
+            }
         }
     }
+}
 
-    container->calculateBorders();
 
-    if (graphicView) {
-        graphicView->redraw(RS2::RedrawDrawing);
+
+/**
+ * Adds the given entities to the container. They are drawn, when the
+ * edit is applied.
+ *
+ * @param addList Entities to add.
+ */
+void RS_Modification::addNewEntities(LC_BulkEdit& edit, std::vector<RS_Entity*>& addList)
+{
+    edit.reserve(addList.size());
+    for (RS_Entity* e: addList) {
+        edit.add(e);
     }
 }
 
@@ -2482,9 +2583,10 @@ bool RS_Modification::stretch(const RS_Vector& firstCorner,
         }
     }
 
-    LC_UndoSection undo( document, handleUndo); // bundle remove/add entities in one undoCycle
-    deselectOriginals(true);
-    addNewEntities(addList);
+    // bundle remove/add entities in one undoCycle and one redraw
+    LC_BulkEdit edit(*container, document, graphicView, handleUndo);
+    deselectOriginals(edit, true);
+    addNewEntities(edit, addList);
 
     return true;
 }
@@ -3045,7 +3147,7 @@ bool RS_Modification::explode(const bool remove /*= true*/)
 
 	std::vector<RS_Entity*> addList;
 
-    for(auto e: *container){
+    for(auto e: container->selectedEntities()){
         //for (unsigned i=0; i<container->count(); ++i) {
         //RS_Entity* e = container->entityAt(i);
 
@@ -3056,6 +3158,26 @@ bool RS_Modification::explode(const bool remove /*= true*/)
                 RS_EntityContainer* ec = (RS_EntityContainer*)e;
                 //ec->setSelected(false);
 
+                // the pattern of a hatch may only exist for the visible part
+                if (ec->rtti()==RS2::EntityHatch) {
+                    static_cast<RS_Hatch*>(ec)->updatePattern();
+                }
+
+                // texts keep references to the glyphs of their font, the
+                // letters are exploded from inserts created on a copy
+                std::unique_ptr<RS_EntityContainer> letters;
+                if (ec->rtti()==RS2::EntityText) {
+                    RS_Text* text = static_cast<RS_Text*>(ec->clone());
+                    text->createLetters();
+                    letters.reset(text);
+                    ec = text;
+                } else if (ec->rtti()==RS2::EntityMText) {
+                    RS_MText* text = static_cast<RS_MText*>(ec->clone());
+                    text->createLetters();
+                    letters.reset(text);
+                    ec = text;
+                }
+
                 // iterate and explode container:
                 //for (unsigned i2=0; i2<ec->count(); ++i2) {
                 //    RS_Entity* e2 = ec->entityAt(i2);
@@ -3139,9 +3261,11 @@ bool RS_Modification::explode(const bool remove /*= true*/)
         }
     }
 
-    LC_UndoSection undo( document, handleUndo); // bundle remove/add entities in one undoCycle
-    deselectOriginals( remove);
-    addNewEntities(addList);
+    // bundle remove/add entities in one undoCycle and one redraw
+    LC_BulkEdit edit(*container, document, graphicView, handleUndo);
+    deselectOriginals(edit, remove);
+    addNewEntities(edit, addList);
+    edit.apply();
     container->updateInserts();
 
     return true;
@@ -3159,25 +3283,28 @@ bool RS_Modification::explodeTextIntoLetters() {
 
 	std::vector<RS_Entity*> addList;
 
-	for(auto e: *container){
+	for(auto e: container->selectedEntities()){
         if (e && e->isSelected()) {
             if (e->rtti()==RS2::EntityMText) {
-                // add letters of text:
-                RS_MText* text = (RS_MText*)e;
-                explodeTextIntoLetters(text, addList);
+                // add letters of text, from inserts created on a copy:
+                std::unique_ptr<RS_MText> text{static_cast<RS_MText*>(e->clone())};
+                text->createLetters();
+                explodeTextIntoLetters(text.get(), addList);
             } else if (e->rtti()==RS2::EntityText) {
-                // add letters of text:
-                RS_Text* text = (RS_Text*)e;
-                explodeTextIntoLetters(text, addList);
+                // add letters of text, from inserts created on a copy:
+                std::unique_ptr<RS_Text> text{static_cast<RS_Text*>(e->clone())};
+                text->createLetters();
+                explodeTextIntoLetters(text.get(), addList);
             } else {
                 e->setSelected(false);
             }
         }
     }
 
-    LC_UndoSection undo( document, handleUndo); // bundle remove/add entities in one undoCycle
-    deselectOriginals(true);
-    addNewEntities(addList);
+    // bundle remove/add entities in one undoCycle and one redraw
+    LC_BulkEdit edit(*container, document, graphicView, handleUndo);
+    deselectOriginals(edit, true);
+    addNewEntities(edit, addList);
 
     return true;
 }
@@ -3304,7 +3431,7 @@ bool RS_Modification::moveRef(RS_MoveRefData& data) {
 	std::vector<RS_Entity*> addList;
 
     // Create new entities
-	for(auto e: *container){
+	for(auto e: container->selectedEntities()){
 		if (e && e->isSelected()) {
             RS_Entity* ec = e->clone();
 
@@ -3315,9 +3442,10 @@ bool RS_Modification::moveRef(RS_MoveRefData& data) {
         }
     }
 
-    LC_UndoSection undo( document, handleUndo); // bundle remove/add entities in one undoCycle
-    deselectOriginals(true);
-    addNewEntities(addList);
+    // bundle remove/add entities in one undoCycle and one redraw
+    LC_BulkEdit edit(*container, document, graphicView, handleUndo);
+    deselectOriginals(edit, true);
+    addNewEntities(edit, addList);
 
     return true;
 }
@@ -27,10 +27,13 @@
 #ifndef RS_MODIFICATION_H
 #define RS_MODIFICATION_H
 
+#include <memory>
 #include "rs_vector.h"
 #include "rs_pen.h"
 #include <QHash>
 
+class LC_BulkEdit;
+class LC_TransformUndoable;
 class RS_AtomicEntity;
 class RS_Entity;
 class RS_EntityContainer;
@@ -293,8 +296,14 @@ public:
                                 RS_AtomicEntity& segment2);
 
 private:
-    void deselectOriginals(bool remove);
-	void addNewEntities(std::vector<RS_Entity*>& addList);
+	std::unique_ptr<LC_TransformUndoable> selectionTransform(
+			bool (*accept)(RS_Entity const*) = nullptr) const;
+	void transformSelection(std::unique_ptr<LC_TransformUndoable> transform,
+							bool keepSelection);
+	void transformSelection(std::unique_ptr<LC_TransformUndoable> transform,
+							bool keepSelection, LC_BulkEdit& edit);
+	void deselectOriginals(LC_BulkEdit& edit, bool remove);
+	void addNewEntities(LC_BulkEdit& edit, std::vector<RS_Entity*>& addList);
 	bool explodeTextIntoLetters(RS_MText* text, std::vector<RS_Entity*>& addList);
 	bool explodeTextIntoLetters(RS_Text* text, std::vector<RS_Entity*>& addList);
 
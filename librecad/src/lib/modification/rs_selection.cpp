@@ -32,6 +32,9 @@
 #include "rs_entity.h"
 #include "rs_graphic.h"
 #include "rs_layer.h"
+#include "lc_bulkedit.h"
+#include "lc_endpointmap.h"
+#include "lc_rect.h"
 
 
 
@@ -152,54 +155,50 @@ void RS_Selection::selectIntersected(const RS_Vector& v1, const RS_Vector& v2,
                                      bool select) {
 
 	RS_Line line{v1, v2};
-    bool inters;
-
-	for(auto e: *container){
-    //for (unsigned i=0; i<container->count(); ++i) {
-        //RS_Entity* e = container->entityAt(i);
-
-        if (e && e->isVisible()) {
-
-            inters = false;
-
-            // select containers / groups:
-            if (e->isContainer()) {
-                RS_EntityContainer* ec = (RS_EntityContainer*)e;
-
-                for (RS_Entity* e2=ec->firstEntity(RS2::ResolveAll); e2;
-                        e2=ec->nextEntity(RS2::ResolveAll)) {
-
-                    RS_VectorSolutions sol =
-                        RS_Information::getIntersection(&line, e2, true);
-
-                    if (sol.hasValid()) {
-                        inters = true;
-                    }
-                }
-            } else {
-
-                RS_VectorSolutions sol =
-                    RS_Information::getIntersection(&line, e, true);
-
-                if (sol.hasValid()) {
-                    inters = true;
-                }
-            }
-
-            if (inters) {
-                if (graphicView) {
-                    graphicView->deleteEntity(e);
-                }
-
-                e->setSelected(select);
-
-                if (graphicView) {
-                    graphicView->drawEntity(e);
-                }
-            }
-        }
-    }
 
+	// only entities whose boxes are crossed by the line can intersect it,
+	// construction lines are not bounded by their box
+	auto const intersects = [&line, &v1, &v2](RS_Entity* e) {
+		RS_Vector p1 = v1;
+		RS_Vector p2 = v2;
+		LC_Rect const box = LC_Rect(e->getMin(), e->getMax()).increaseBy(RS_TOLERANCE);
+		if (e->rtti() != RS2::EntityConstructionLine && !box.clipLine(p1, p2)) {
+			return false;
+		}
+		return RS_Information::getIntersection(&line, e, true).hasValid();
+	};
+
+	for (RS_Entity* e: container->getEntitiesOverlappingWindow(v1, v2)) {
+		if (!e->isVisible()) {
+			continue;
+		}
+
+		bool inters = false;
+
+		// select containers / groups:
+		if (e->isContainer()) {
+			RS_EntityContainer* ec = (RS_EntityContainer*)e;
+
+			for (RS_Entity* e2=ec->firstEntity(RS2::ResolveAll); e2 && !inters;
+				 e2=ec->nextEntity(RS2::ResolveAll)) {
+				inters = intersects(e2);
+			}
+		} else {
+			inters = intersects(e);
+		}
+
+		if (inters) {
+			if (graphicView) {
+				graphicView->deleteEntity(e);
+			}
+
+			e->setSelected(select);
+
+			if (graphicView) {
+				graphicView->drawEntity(e);
+			}
+		}
+	}
 }
 
 
@@ -223,68 +222,33 @@ void RS_Selection::selectContour(RS_Entity* e) {
     RS_AtomicEntity* ae = (RS_AtomicEntity*)e;
     RS_Vector p1 = ae->getStartpoint();
     RS_Vector p2 = ae->getEndpoint();
-    bool found = false;
 
-    // (de)select 1st entity:
-    if (graphicView) {
-        graphicView->deleteEntity(e);
-    }
-    e->setSelected(select);
-    if (graphicView) {
-        graphicView->drawEntity(e);
+    // the contour is (de)selected and redrawn at once
+    LC_BulkEdit edit(*container, nullptr, graphicView, false);
+    edit.select(e, select);
+
+    // endpoints of the entities which could be connected:
+    LC_EndpointMap endpoints(1.0e-4);
+    long order = 0;
+    for(auto en: *container){
+        if (en && en != e && en->isVisible() &&
+            en->isAtomic() && en->isSelected()!=select &&
+            (!(en->getLayer() && en->getLayer()->isLocked()))) {
+            endpoints.insert(en, order);
+        }
+        ++order;
     }
 
-    do {
-        found = false;
-
-		for(auto en: *container){
-        //for (unsigned i=0; i<container->count(); ++i) {
-            //RS_Entity* en = container->entityAt(i);
-
-            if (en && en->isVisible() && 
-				en->isAtomic() && en->isSelected()!=select && 
-				(!(en->getLayer() && en->getLayer()->isLocked()))) {
-
-                ae = (RS_AtomicEntity*)en;
-                bool doit = false;
-
-                // startpoint connects to 1st point
-                if (ae->getStartpoint().distanceTo(p1)<1.0e-4) {
-                    doit = true;
-                    p1 = ae->getEndpoint();
-                }
-
-                // endpoint connects to 1st point
-                else if (ae->getEndpoint().distanceTo(p1)<1.0e-4) {
-                    doit = true;
-                    p1 = ae->getStartpoint();
-                }
-
-                // startpoint connects to 2nd point
-                else if (ae->getStartpoint().distanceTo(p2)<1.0e-4) {
-                    doit = true;
-                    p2 = ae->getEndpoint();
-                }
-
-                // endpoint connects to 1st point
-                else if (ae->getEndpoint().distanceTo(p2)<1.0e-4) {
-                    doit = true;
-                    p2 = ae->getStartpoint();
-                }
-
-                if (doit) {
-                    if (graphicView) {
-                        graphicView->deleteEntity(ae);
-                    }
-                    ae->setSelected(select);
-                    if (graphicView) {
-                        graphicView->drawEntity(ae);
-                    }
-                    found = true;
-                }
-            }
+    // follow the contour from both ends:
+    for (RS_Vector* p: {&p1, &p2}) {
+        bool start = false;
+        RS_Entity* en = nullptr;
+        while ((en = endpoints.nearest(*p, nullptr, &start)) != nullptr) {
+            endpoints.remove(en);
+            *p = start ? en->getEndpoint() : en->getStartpoint();
+            edit.select(en, select);
         }
-    } while(found);
+    }
 }
 
 
@@ -215,8 +215,15 @@ HEADERS += \
     lib/generators/lc_xmlwriterinterface.h \
     lib/generators/lc_xmlwriterqxmlstreamwriter.h \
     actions/lc_actionfileexportmakercam.h \
+    lib/engine/lc_bulkedit.h \
+    lib/engine/lc_endpointmap.h \
+    lib/engine/lc_glyphrun.h \
+    lib/engine/lc_hatchfill.h \
     lib/engine/lc_rect.h \
+    lib/engine/lc_spatialindex.h \
+    lib/engine/lc_transformundoable.h \
     lib/engine/lc_undosection.h \
+    lib/gui/lc_arctessellator.h \
     lib/printing/lc_printing.h \
     actions/lc_actiondrawlinepolygon3.h \
     main/lc_application.h
@@ -305,8 +312,15 @@ SOURCES += \
     lib/engine/rs_atomicentity.cpp \
     lib/engine/rs_undocycle.cpp \
     lib/engine/rs_flags.cpp \
+    lib/engine/lc_bulkedit.cpp \
+    lib/engine/lc_endpointmap.cpp \
+    lib/engine/lc_glyphrun.cpp \
+    lib/engine/lc_hatchfill.cpp \
     lib/engine/lc_rect.cpp \
+    lib/engine/lc_spatialindex.cpp \
+    lib/engine/lc_transformundoable.cpp \
     lib/engine/lc_undosection.cpp \
+    lib/gui/lc_arctessellator.cpp \
     lib/engine/rs.cpp \
     lib/printing/lc_printing.cpp \
     actions/lc_actiondrawlinepolygon3.cpp \
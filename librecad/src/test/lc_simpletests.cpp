@@ -1,6 +1,17 @@
+#include <atomic>
 #include <iostream>
 #include <cmath>
+#include <functional>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <memory>
+#include <new>
+#include <random>
+#include <vector>
+#include <QElapsedTimer>
+#include <QFileDialog>
+#include <QImage>
 #include <QMenuBar>
 #include "lc_simpletests.h"
 #include "qc_applicationwindow.h"
@@ -23,9 +34,14 @@
 #include "rs_point.h"
 #include "rs_text.h"
 #include "rs_entitycontainer.h"
+#include "rs_information.h"
+#include "lc_quadratic.h"
 #include "rs_layer.h"
 #include "rs_graphicview.h"
 #include "rs_debug.h"
+#include "rs_painterqt.h"
+#include "rs_staticgraphicview.h"
+#include "intern/dxfreader.h"
 
 LC_SimpleTests::LC_SimpleTests(QWidget *parent):
 	QObject(parent)
@@ -109,6 +125,31 @@ LC_SimpleTests::LC_SimpleTests(QWidget *parent):
 		connect(action, SIGNAL(triggered()),
 				this, SLOT(slotTestResize1024()));
 		testMenu->addAction(action);
+
+		action = new QAction("Snap Benchmark", this);
+		connect(action, SIGNAL(triggered()),
+				this, SLOT(slotTestSnapBenchmark()));
+		testMenu->addAction(action);
+
+		action = new QAction("Render Benchmark", this);
+		connect(action, SIGNAL(triggered()),
+				this, SLOT(slotTestRenderBenchmark()));
+		testMenu->addAction(action);
+
+		action = new QAction("DXF Read Benchmark", this);
+		connect(action, SIGNAL(triggered()),
+				this, SLOT(slotTestDxfReadBenchmark()));
+		testMenu->addAction(action);
+
+		action = new QAction("Undo Benchmark", this);
+		connect(action, SIGNAL(triggered()),
+				this, SLOT(slotTestUndoBenchmark()));
+		testMenu->addAction(action);
+
+		action = new QAction("Intersection Benchmark", this);
+		connect(action, SIGNAL(triggered()),
+				this, SLOT(slotTestIntersectionBenchmark()));
+		testMenu->addAction(action);
 }
 
 /**
@@ -1103,3 +1144,380 @@ void LC_SimpleTests::slotTestResize1024() {
 	QC_ApplicationWindow::getAppWindow()->update();
 	RS_DEBUG->print("%s\n: end\n", __func__);
 }
+
+/**
+ * Testing function.
+ */
+void LC_SimpleTests::slotTestSnapBenchmark() {
+	RS_DEBUG->print("%s\n: begin\n", __func__);
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<double> unit(0., 1.);
+	constexpr int queries = 1000;
+
+	for (int size: {1000, 10000, 100000, 300000}) {
+		// keep the density of the drawing constant
+		double const extent = 10. * std::sqrt(double(size));
+		RS_EntityContainer container;
+		for (int i = 0; i < size; ++i) {
+			RS_Vector const start{extent * unit(generator), extent * unit(generator)};
+			RS_Vector const offset{20. * unit(generator) - 10., 20. * unit(generator) - 10.};
+			container.addEntity(new RS_Line{&container, start, start + offset});
+		}
+		container.calculateBorders();
+
+		std::vector<RS_Vector> points;
+		for (int i = 0; i < queries; ++i) {
+			points.emplace_back(extent * unit(generator), extent * unit(generator));
+		}
+
+		// the first queries after a change build the index
+		QElapsedTimer timer;
+		timer.start();
+		double dist = 0.;
+		container.getNearestEntity(points.front(), &dist, RS2::ResolveNone);
+		for (int i = 0; i < 16; ++i) {
+			container.getNearestEndpoint(points[i], &dist);
+		}
+		qint64 const warmUp = timer.nsecsElapsed();
+
+		timer.restart();
+		for (const RS_Vector& point: points) {
+			container.getNearestEntity(point, &dist, RS2::ResolveNone);
+		}
+		qint64 const entity = timer.nsecsElapsed();
+
+		timer.restart();
+		for (const RS_Vector& point: points) {
+			container.getNearestEndpoint(point, &dist);
+		}
+		qint64 const endpoint = timer.nsecsElapsed();
+
+		timer.restart();
+		for (const RS_Vector& point: points) {
+			container.getNearestIntersection(point, &dist);
+		}
+		qint64 const intersection = timer.nsecsElapsed();
+
+		std::cout << size << " entities: warm up " << warmUp / 1000000.
+				  << " ms, getNearestEntity " << entity / (1000. * queries)
+				  << " us, getNearestEndpoint " << endpoint / (1000. * queries)
+				  << " us, getNearestIntersection " << intersection / (1000. * queries)
+				  << " us per query" << std::endl;
+	}
+	RS_DEBUG->print("%s\n: end\n", __func__);
+}
+
+namespace {
+//! heap allocations since the program started, counted with LC_DEBUGGING only
+std::atomic<unsigned long> allocationCount{0};
+}
+
+#ifdef LC_DEBUGGING
+void* operator new(std::size_t size)
+{
+	++allocationCount;
+	if (void* p = std::malloc(size ? size : 1)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+#endif
+
+/**
+ * Renders one million lines through RS_StaticGraphicView, once zoomed to the
+ * whole drawing and once to a small part of it.
+ */
+void LC_SimpleTests::slotTestRenderBenchmark() {
+	RS_DEBUG->print("%s\n: begin\n", __func__);
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<double> unit(0., 1.);
+	constexpr int size = 1000000;
+
+	double const extent = 10. * std::sqrt(double(size));
+	RS_EntityContainer container;
+	RS_Pen const pen(RS_Color(0, 0, 0), RS2::Width00, RS2::SolidLine);
+	for (int i = 0; i < size; ++i) {
+		RS_Vector const start{extent * unit(generator), extent * unit(generator)};
+		RS_Vector const offset{20. * unit(generator) - 10., 20. * unit(generator) - 10.};
+		RS_Line* line = new RS_Line{&container, start, start + offset};
+		line->setPen(pen);
+		container.addEntity(line);
+	}
+	container.calculateBorders();
+
+	QImage image(1024, 768, QImage::Format_ARGB32);
+	RS_PainterQt painter(&image);
+	RS_StaticGraphicView view(image.width(), image.height(), &painter);
+	view.setContainer(&container);
+
+	for (double zoom: {1., 30.}) {
+		view.zoomAuto(false);
+		view.zoomIn(zoom, container.getMin() + container.getSize() * 0.5);
+		// the first drawing builds the spatial index
+		view.drawEntity(&painter, &container);
+
+		RS_Vector const vpMin(view.toGraph(0, view.getHeight()));
+		RS_Vector const vpMax(view.toGraph(view.getWidth(), 0));
+		size_t const visible = container.getEntitiesOverlappingWindow(vpMin, vpMax).size();
+
+		QElapsedTimer timer;
+		unsigned long const allocations = allocationCount;
+		timer.start();
+		view.drawEntity(&painter, &container);
+		qint64 const elapsed = timer.nsecsElapsed();
+		unsigned long const used = allocationCount - allocations;
+
+		std::cout << size << " lines, zoom " << zoom << ": "
+				  << visible << " in view, " << elapsed / 1000000. << " ms, "
+				  << used << " allocations (" << double(used) / visible
+				  << " per line in view)" << std::endl;
+	}
+	painter.end();
+#ifndef LC_DEBUGGING
+	std::cout << "allocations are counted in builds with LC_DEBUGGING only" << std::endl;
+#endif
+	RS_DEBUG->print("%s\n: end\n", __func__);
+}
+
+void LC_SimpleTests::slotTestDxfReadBenchmark() {
+	RS_DEBUG->print("%s\n: begin\n", __func__);
+	QString const fileName = QFileDialog::getOpenFileName(
+				nullptr, "DXF Read Benchmark", QString(), "DXF (*.dxf *.DXF)");
+	if (fileName.isEmpty()) {
+		return;
+	}
+	std::string const path = QFile::encodeName(fileName).toStdString();
+
+	QElapsedTimer timer;
+	timer.start();
+	std::ifstream file(path, std::ios_base::in | std::ios::binary);
+	file.seekg(0, std::ios::end);
+	std::streamoff const size = file.tellg();
+	if (size <= 0) {
+		std::cout << path << ": cannot read file" << std::endl;
+		return;
+	}
+	std::vector<char> buffer(static_cast<size_t>(size));
+	file.seekg(0, std::ios::beg);
+	file.read(&buffer[0], size);
+	file.close();
+	qint64 const loadTime = timer.nsecsElapsed();
+
+	// the reference reader, as used before the file was loaded at once
+	std::ifstream stream(path, std::ios_base::in);
+	dxfReaderAscii streamReader(&stream);
+	dxfReaderAsciiBuffer bufferReader(buffer.data(), buffer.data() + buffer.size());
+	unsigned long records = 0;
+	for (;;) {
+		int streamCode = 0;
+		int bufferCode = 0;
+		bool const streamOk = streamReader.readRec(&streamCode);
+		bool const bufferOk = bufferReader.readRec(&bufferCode);
+		double const streamDouble = streamReader.getDouble();
+		double const bufferDouble = bufferReader.getDouble();
+		if (streamOk != bufferOk || streamCode != bufferCode
+				|| streamReader.type != bufferReader.type
+				|| streamReader.getString() != bufferReader.getString()
+				|| (streamCode >= 10 && streamCode < 60
+					&& std::memcmp(&streamDouble, &bufferDouble, sizeof(double)))
+				|| (streamCode >= 60 && streamCode < 80
+					&& streamReader.getInt32() != bufferReader.getInt32())) {
+			std::cout << path << ": readers differ at record " << records
+					  << ", group code " << streamCode << std::endl;
+			return;
+		}
+		if (!streamOk) {
+			break;
+		}
+		++records;
+	}
+	stream.close();
+
+	int code = 0;
+	stream.open(path, std::ios_base::in);
+	dxfReaderAscii streamTiming(&stream);
+	timer.restart();
+	while (streamTiming.readRec(&code)) {
+	}
+	qint64 const streamTime = timer.nsecsElapsed();
+
+	dxfReaderAsciiBuffer bufferTiming(buffer.data(), buffer.data() + buffer.size());
+	timer.restart();
+	while (bufferTiming.readRec(&code)) {
+	}
+	qint64 const bufferTime = timer.nsecsElapsed() + loadTime;
+
+	double const megaBytes = size / 1e6;
+	std::cout << path << ": " << megaBytes << " MB, " << records << " records, identical" << std::endl;
+	std::cout << "stream reader: " << megaBytes * 1e9 / streamTime << " MB/s" << std::endl;
+	std::cout << "buffer reader: " << megaBytes * 1e9 / bufferTime
+			  << " MB/s, loading the file included" << std::endl;
+	RS_DEBUG->print("%s\n: end\n", __func__);
+}
+
+void LC_SimpleTests::slotTestUndoBenchmark() {
+	RS_DEBUG->print("%s\n: begin\n", __func__);
+	constexpr int size = 100000;
+	RS_Graphic graphic;
+	graphic.setUndoLimits(0, 0);
+
+	QElapsedTimer timer;
+	auto report = [&timer](const char* step) {
+		std::cout << step << ": " << timer.nsecsElapsed() / 1000000. << " ms" << std::endl;
+		timer.restart();
+	};
+	auto addLine = [&graphic](int i) {
+		RS_Line* line = new RS_Line{&graphic, {double(i % 1000), double(i / 1000)},
+				{i % 1000 + 0.5, i / 1000 + 0.5}};
+		graphic.addEntity(line);
+		graphic.addUndoable(line);
+		return line;
+	};
+
+	std::cout << size << " entities" << std::endl;
+	timer.start();
+	graphic.startUndoCycle();
+	std::vector<RS_Entity*> pasted;
+	pasted.reserve(size);
+	for (int i = 0; i < size; ++i) {
+		pasted.push_back(addLine(i));
+	}
+	graphic.endUndoCycle();
+	report("paste");
+
+	graphic.undo();
+	report("undo paste");
+
+	// the pasted entities are dropped from the redo history
+	graphic.startUndoCycle();
+	addLine(0);
+	graphic.endUndoCycle();
+	report("edit after undo of paste");
+
+	graphic.startUndoCycle();
+	pasted.clear();
+	for (int i = 0; i < size; ++i) {
+		pasted.push_back(addLine(i));
+	}
+	graphic.endUndoCycle();
+	graphic.startUndoCycle();
+	for (RS_Entity* e: pasted) {
+		e->setUndoState(true);
+		graphic.addUndoable(e);
+	}
+	graphic.endUndoCycle();
+	timer.restart();
+	graphic.undo();
+	report("undo delete");
+	graphic.redo();
+	report("redo delete");
+	graphic.undo();
+	report("undo delete");
+
+	graphic.startUndoCycle();
+	addLine(0);
+	graphic.endUndoCycle();
+	report("edit after undo of delete");
+
+	graphic.undo();
+	graphic.undo();
+	graphic.undo();
+	report("undo edit, paste and edit");
+
+	graphic.startUndoCycle();
+	addLine(0);
+	graphic.endUndoCycle();
+	report("edit after undo of all");
+	std::cout << graphic.count() << " entities left" << std::endl;
+	RS_DEBUG->print("%s\n: end\n", __func__);
+}
+
+void LC_SimpleTests::slotTestIntersectionBenchmark() {
+	RS_DEBUG->print("%s\n: begin\n", __func__);
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<double> unit(0., 1.);
+	constexpr int pairs = 1000;
+	constexpr int rounds = 100;
+
+	// random entities in a 10x10 square, so most pairs intersect
+	auto point = [&]() {
+		return RS_Vector{10. * unit(generator), 10. * unit(generator)};
+	};
+	auto radius = [&]() {
+		return 1. + 4. * unit(generator);
+	};
+	auto angle = [&]() {
+		return 2. * M_PI * unit(generator);
+	};
+	std::function<RS_Entity*()> const line = [&]() -> RS_Entity* {
+		return new RS_Line{nullptr, point(), point()};
+	};
+	std::function<RS_Entity*()> const circle = [&]() -> RS_Entity* {
+		return new RS_Circle{nullptr, {point(), radius()}};
+	};
+	std::function<RS_Entity*()> const arc = [&]() -> RS_Entity* {
+		return new RS_Arc{nullptr, {point(), radius(), angle(), angle(), false}};
+	};
+	std::function<RS_Entity*()> const ellipse = [&]() -> RS_Entity* {
+		RS_Vector majorP;
+		majorP.setPolar(radius(), angle());
+		return new RS_Ellipse{nullptr, {point(), majorP, 0.2 + 0.8 * unit(generator),
+										0., 2. * M_PI, false}};
+	};
+
+	struct PairType {
+		const char* name;
+		std::function<RS_Entity*()> const& create1;
+		std::function<RS_Entity*()> const& create2;
+	};
+	PairType const pairTypes[] = {
+		{"line/line", line, line},
+		{"line/circle", line, circle},
+		{"line/arc", line, arc},
+		{"circle/circle", circle, circle},
+		{"arc/arc", arc, arc},
+		{"line/ellipse", line, ellipse},
+		{"circle/ellipse", circle, ellipse}
+	};
+
+	for (PairType const& pairType: pairTypes) {
+		std::vector<std::unique_ptr<RS_Entity>> entities;
+		for (int i = 0; i < pairs; ++i) {
+			entities.emplace_back(pairType.create1());
+			entities.emplace_back(pairType.create2());
+		}
+
+		QElapsedTimer timer;
+		timer.start();
+		size_t found = 0;
+		for (int round = 0; round < rounds; ++round) {
+			for (size_t i = 0; i < entities.size(); i += 2) {
+				found += RS_Information::getIntersection(entities[i].get(),
+														 entities[i + 1].get(), true).size();
+			}
+		}
+		qint64 const dispatched = timer.nsecsElapsed();
+
+		// the general solver all pairs used to go through
+		timer.restart();
+		for (int round = 0; round < rounds; ++round) {
+			for (size_t i = 0; i < entities.size(); i += 2) {
+				LC_Quadratic::getIntersection(entities[i]->getQuadratic(),
+											  entities[i + 1]->getQuadratic());
+			}
+		}
+		qint64 const quadratic = timer.nsecsElapsed();
+
+		double const calls = double(pairs) * rounds;
+		std::cout << pairType.name << ": " << calls * 1e9 / std::max<qint64>(1, dispatched)
+				  << " intersections/s, quadratic solver " << calls * 1e9 / std::max<qint64>(1, quadratic)
+				  << " intersections/s, " << found / rounds << " points on "
+				  << pairs << " pairs" << std::endl;
+	}
+	RS_DEBUG->print("%s\n: end\n", __func__);
+}
@@ -42,5 +42,15 @@ public slots:
 	void slotTestResize800();
 	/** resizes window to 640x480 for screen shots */
 	void slotTestResize1024();
+	/** snap latency versus drawing size */
+	void slotTestSnapBenchmark();
+	/** time and heap allocations of rendering a large drawing */
+	void slotTestRenderBenchmark();
+	/** throughput of the ascii DXF readers */
+	void slotTestDxfReadBenchmark();
+	/** undo, redo and re-edit of large undo cycles */
+	void slotTestUndoBenchmark();
+	/** intersections per second by pair of entity types */
+	void slotTestIntersectionBenchmark();
 };
 #endif // LC_SIMPLETESTS_H
@@ -26,6 +26,9 @@
 
 #include "qg_graphicview.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include <QGridLayout>
 #include <QLabel>
 #include <QMenu>
@@ -57,6 +60,24 @@
 #define CURSOR_SIZE 15
 #endif
 
+namespace {
+//! edge length of the cached drawing tiles in pixels
+constexpr int tileSize = 256;
+/**
+ * tiles are rendered with this margin in pixels, so wide pens and entities
+ * clipped at the border of the rendered region don't leave seams
+ */
+constexpr int tileMargin = 32;
+
+//! column or row of the tile containing the given pixel
+int tileIndex(double pixel)
+{
+    // windows far outside of the view must not overflow
+    double const index = std::floor(pixel / tileSize);
+    return static_cast<int>(std::max(-1e9, std::min(1e9, index)));
+}
+}
+
 /**
  * Constructor.
  */
@@ -109,6 +130,8 @@ QG_GraphicView::~QG_GraphicView() {
  */
 int QG_GraphicView::getWidth() const
 {
+    if (tilesRenderSize.isValid())
+        return tilesRenderSize.width();
     if (scrollbars)
         return width() - vScrollBar->sizeHint().width();
     else
@@ -122,6 +145,8 @@ int QG_GraphicView::getWidth() const
  */
 int QG_GraphicView::getHeight() const
 {
+    if (tilesRenderSize.isValid())
+        return tilesRenderSize.height();
     if (scrollbars)
         return height() - hScrollBar->sizeHint().height();
     else
@@ -129,6 +154,19 @@ int QG_GraphicView::getHeight() const
 }
 
 
+
+/**
+ * @return the window of the whole view. While drawTiles() renders a row
+ * of tiles, it is joined with the row, which reaches past the view.
+ */
+LC_Rect QG_GraphicView::getVisibleArea() const
+{
+    if (tilesRenderSize.isValid())
+        return view_rect.merge(RS_GraphicView::getVisibleArea());
+    return RS_GraphicView::getVisibleArea();
+}
+
+
 /**
  * Changes the current background color of this view.
  */
@@ -237,12 +275,39 @@ void QG_GraphicView::updateGridStatusWidget(const QString& text)
  * Redraws the widget.
  */
 void QG_GraphicView::redraw(RS2::RedrawMethod method) {
+        if (method & RS2::RedrawDrawing)
+            drawingTiles.clear();
         redrawMethod=(RS2::RedrawMethod ) (redrawMethod | method);
         update(); // Paint when reeady to pain
 //	repaint(); //Paint immediate
 }
 
 
+/**
+ * Redraws the tiles overlapping the given window.
+ */
+void QG_GraphicView::redrawWindow(const RS_Vector& v1, const RS_Vector& v2) {
+    // tiles are counted from the screen position of the graph origin
+    RS_Vector const p1 = toGui(v1) - RS_Vector(getOffsetX(), getHeight() - getOffsetY());
+    RS_Vector const p2 = toGui(v2) - RS_Vector(getOffsetX(), getHeight() - getOffsetY());
+    int const firstColumn = tileIndex(std::min(p1.x, p2.x) - tileMargin);
+    int const lastColumn = tileIndex(std::max(p1.x, p2.x) + tileMargin);
+    int const firstRow = tileIndex(std::min(p1.y, p2.y) - tileMargin);
+    int const lastRow = tileIndex(std::max(p1.y, p2.y) + tileMargin);
+
+    for (auto it = drawingTiles.begin(); it != drawingTiles.end(); ) {
+        if (it->first.first >= firstColumn && it->first.first <= lastColumn
+                && it->first.second >= firstRow && it->first.second <= lastRow) {
+            it = drawingTiles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    redrawMethod=(RS2::RedrawMethod ) (redrawMethod | RS2::RedrawDrawing);
+    update();
+}
+
+
 void QG_GraphicView::resizeEvent(QResizeEvent* /*e*/) {
     RS_DEBUG->print("QG_GraphicView::resizeEvent begin");
     adjustOffsetControls();
@@ -834,7 +899,7 @@ void QG_GraphicView::slotHScrolled(int value) {
     }
     //if (isUpdateEnabled()) {
 //         updateGrid();
-    redraw();
+    redraw((RS2::RedrawMethod) (RS2::RedrawGrid | RS2::RedrawOverlay));
 }
 
 
@@ -858,7 +923,7 @@ void QG_GraphicView::slotVScrolled(int value) {
     }
     //if (isUpdateEnabled()) {
   //  updateGrid();
-    redraw();
+    redraw((RS2::RedrawMethod) (RS2::RedrawGrid | RS2::RedrawOverlay));
 }
 /**
  * @brief setOffset
@@ -964,23 +1029,67 @@ void QG_GraphicView::paintEvent(QPaintEvent *)
         painter1.end();
     }
 
-    if (redrawMethod & RS2::RedrawDrawing)
+    QPoint const offset(getOffsetX(), getOffsetY());
+    if ((redrawMethod & RS2::RedrawDrawing)
+            || layer2Offset != offset || layer2Size != PixmapLayer2->size())
     {
         view_rect = LC_Rect(toGraph(0, 0),
                             toGraph(getWidth(), getHeight()));
+        if (tilesFactor != getFactor()) {
+            drawingTiles.clear();
+            tilesFactor = getFactor();
+        }
+
+        // screen position of the tile grid origin
+        int const originX = getOffsetX();
+        int const originY = getHeight() - getOffsetY();
+        int const firstColumn = tileIndex(-originX);
+        int const lastColumn = tileIndex(getWidth() - 1 - originX);
+        int const firstRow = tileIndex(-originY);
+        int const lastRow = tileIndex(getHeight() - 1 - originY);
+
+        // keep one ring of hidden tiles for panning back and forth
+        for (auto it = drawingTiles.begin(); it != drawingTiles.end(); ) {
+            if (it->first.first < firstColumn - 1 || it->first.first > lastColumn + 1
+                    || it->first.second < firstRow - 1 || it->first.second > lastRow + 1) {
+                it = drawingTiles.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        // render missing tiles, consecutive ones in a row at once
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int column = firstColumn; column <= lastColumn; ++column) {
+                if (drawingTiles.count({column, row}))
+                    continue;
+                int last = column;
+                while (last < lastColumn && !drawingTiles.count({last + 1, row}))
+                    ++last;
+                drawTiles(row, column, last);
+                column = last;
+            }
+        }
+
         // DRaw layer 2
         PixmapLayer2->fill(Qt::transparent);
         RS_PainterQt painter2(PixmapLayer2.get());
-        if (antialiasing)
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int column = firstColumn; column <= lastColumn; ++column) {
+                auto const it = drawingTiles.find({column, row});
+                if (it != drawingTiles.end())
+                    painter2.drawPixmap(originX + column * tileSize,
+                                        originY + row * tileSize,
+                                        *it->second);
+            }
+        }
+        if (!isPrintPreview())
         {
-            painter2.setRenderHint(QPainter::Antialiasing);
+            drawAbsoluteZero((RS_Painter*)&painter2);
         }
-        painter2.setDrawingMode(drawingMode);
-        painter2.setDrawSelectedOnly(false);
-        drawLayer2((RS_Painter*)&painter2);
-        painter2.setDrawSelectedOnly(true);
-        drawLayer2((RS_Painter*)&painter2);
         painter2.end();
+        layer2Offset = offset;
+        layer2Size = PixmapLayer2->size();
     }
 
     if (redrawMethod & RS2::RedrawOverlay)
@@ -1008,6 +1117,49 @@ void QG_GraphicView::paintEvent(QPaintEvent *)
 void QG_GraphicView::setAntialiasing(bool state)
 {
 	antialiasing = state;
+	drawingTiles.clear();
+}
+
+/**
+ * Renders the tiles from firstColumn to lastColumn of a row. They are
+ * rendered at once, as if the view showed just this part of the drawing.
+ */
+void QG_GraphicView::drawTiles(int row, int firstColumn, int lastColumn)
+{
+    int const columns = lastColumn - firstColumn + 1;
+    QPixmap strip(columns * tileSize + 2 * tileMargin, tileSize + 2 * tileMargin);
+    strip.fill(Qt::transparent);
+
+    int const offsetX = getOffsetX();
+    int const offsetY = getOffsetY();
+    // view_rect keeps the window of the whole view, see getVisibleArea()
+    tilesRenderSize = strip.size();
+    setOffsetX(tileMargin - firstColumn * tileSize);
+    setOffsetY(tileSize + tileMargin + row * tileSize);
+
+    RS_PainterQt painter(&strip);
+    if (antialiasing)
+    {
+        painter.setRenderHint(QPainter::Antialiasing);
+    }
+    painter.setDrawingMode(drawingMode);
+    painter.setDrawSelectedOnly(false);
+    drawEntity((RS_Painter*)&painter, container);
+    // selected entities go on top, found without another pass over the drawing
+    painter.setDrawSelectedOnly(true);
+    for (RS_Entity* e: container->selectedEntities()) {
+        drawEntity((RS_Painter*)&painter, e);
+    }
+    painter.end();
+
+    tilesRenderSize = QSize();
+    setOffsetX(offsetX);
+    setOffsetY(offsetY);
+
+    for (int i = 0; i < columns; ++i) {
+        drawingTiles[{firstColumn + i, row}].reset(new QPixmap(
+            strip.copy(tileMargin + i * tileSize, tileMargin, tileSize, tileSize)));
+    }
 }
 
 void QG_GraphicView::addScrollbars()
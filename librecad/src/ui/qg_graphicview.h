@@ -27,6 +27,7 @@
 #ifndef QG_GRAPHICVIEW_H
 #define QG_GRAPHICVIEW_H
 
+#include <map>
 #include <QWidget>
 
 #include "rs_graphicview.h"
@@ -58,7 +59,9 @@ public:
 
 	int getWidth() const override;
 	int getHeight() const override;
+	LC_Rect getVisibleArea() const override;
 	void redraw(RS2::RedrawMethod method=RS2::RedrawAll) override;
+	void redrawWindow(const RS_Vector& v1, const RS_Vector& v2) override;
 	void adjustOffsetControls() override;
 	void adjustZoomControls() override;
 	void setBackground(const RS_Color& bg) override;
@@ -150,6 +153,18 @@ protected:
 	std::unique_ptr<QPixmap> PixmapLayer1;  // Used for grids and absolute 0
     std::unique_ptr<QPixmap> PixmapLayer2;  // Used for the actual CAD drawing
     std::unique_ptr<QPixmap> PixmapLayer3;  // Used for crosshair and actionitems
+
+	/**
+	 * Tiles of the rendered drawing, PixmapLayer2 is put together from
+	 * them. A tile is keyed by its column and row in a grid which moves
+	 * with the drawing, so panning only renders tiles which become visible.
+	 */
+	std::map<std::pair<int, int>, std::unique_ptr<QPixmap>> drawingTiles;
+	//! zoom factor the tiles were rendered with
+	RS_Vector tilesFactor;
+	//! offset and size of the view PixmapLayer2 was put together for
+	QPoint layer2Offset;
+	QSize layer2Size;
 	
 	RS2::RedrawMethod redrawMethod;
 		
@@ -159,6 +174,10 @@ protected:
     QMap<QString, QMenu*> menus;
 
 private:
+    void drawTiles(int row, int firstColumn, int lastColumn);
+
+    //! size of the tile row drawTiles() renders, invalid otherwise
+    QSize tilesRenderSize;
     bool antialiasing{false};
     bool scrollbars{false};
     bool cursor_hiding{false};